@@ -393,8 +393,10 @@ void GpuMesh::buildGpuTopoBuffers(
     for(int i=0; i < vertCount; ++i)
     {
         const MeshTopo& meshTopo = topos[i];
-        uint neigVertCount = (uint)meshTopo.neighborVerts.size();
-        uint neigElemCount = (uint)meshTopo.neighborElems.size();
+        MeshNeigRange<MeshNeigVert> neigVerts = neighborVerts(i);
+        MeshNeigRange<MeshNeigElem> neigElems = neighborElems(i);
+        uint neigVertCount = (uint)neigVerts.size();
+        uint neigElemCount = (uint)neigElems.size();
         int type = meshTopo.snapToBoundary->isFixed() ? -1 :
                 meshTopo.snapToBoundary->id();
 
@@ -403,10 +405,10 @@ void GpuMesh::buildGpuTopoBuffers(
             neigElemBase, neigElemCount);
 
         for (uint n = 0; n < neigVertCount; ++n)
-            neigVertBuff.push_back(GpuNeigVert(meshTopo.neighborVerts[n]));
+            neigVertBuff.push_back(GpuNeigVert(neigVerts[n]));
 
         for (uint n = 0; n < neigElemCount; ++n)
-            neigElemBuff.push_back(GpuNeigElem(meshTopo.neighborElems[n]));
+            neigElemBuff.push_back(GpuNeigElem(neigElems[n]));
 
         neigVertBase += neigVertCount;
         neigElemBase += neigElemCount;
@@ -1,5 +1,7 @@
 #include "Mesh.h"
 
+#include <atomic>
+#include <functional>
 #include <algorithm>
 #include <iostream>
 #include <cstdint>
@@ -13,6 +15,8 @@
 #include "OptimizationPlot.h"
 
 #include "NodeGroups.h"
+#include "QualityCache.h"
+#include "ThreadPool.h"
 
 using namespace std;
 using namespace cellar;
@@ -152,7 +156,9 @@ MeshTopo::MeshTopo(const AbstractConstraint* constraint) :
 }
 
 Mesh::Mesh() :
+    _topologyCompaction(true),
     _nodeGroups(new NodeGroups()),
+    _qualityCache(new QualityCache()),
     _boundary(new BoundaryFree())
 {
 
@@ -166,7 +172,17 @@ Mesh::Mesh(const Mesh& m) :
     pyrs(m.pyrs),
     pris(m.pris),
     hexs(m.hexs),
+    tetValues(m.tetValues),
+    pyrValues(m.pyrValues),
+    priValues(m.priValues),
+    hexValues(m.hexValues),
+    _topologyCompaction(m._topologyCompaction),
+    _neigVertBases(m._neigVertBases),
+    _neigElemBases(m._neigElemBases),
+    _neigVerts(m._neigVerts),
+    _neigElems(m._neigElems),
     _nodeGroups(new NodeGroups(m.nodeGroups())),
+    _qualityCache(new QualityCache()),
     _boundary(m._boundary)
 {
 
@@ -187,9 +203,22 @@ Mesh& Mesh::operator=(const Mesh& mesh)
     pyrs = mesh.pyrs;
     pris = mesh.pris;
     hexs = mesh.hexs;
+    tetValues = mesh.tetValues;
+    pyrValues = mesh.pyrValues;
+    priValues = mesh.priValues;
+    hexValues = mesh.hexValues;
+
+    _topologyCompaction = mesh._topologyCompaction;
+    _neigVertBases = mesh._neigVertBases;
+    _neigElemBases = mesh._neigElemBases;
+    _neigVerts = mesh._neigVerts;
+    _neigElems = mesh._neigElems;
 
     _nodeGroups.reset(new NodeGroups(mesh.nodeGroups()));
+    _qualityCache.reset(new QualityCache());
     _boundary = mesh._boundary;
+
+    return *this;
 }
 
 void Mesh::clear()
@@ -204,12 +233,39 @@ void Mesh::clear()
     pris.shrink_to_fit();
     hexs.clear();
     hexs.shrink_to_fit();
+    tetValues.clear();
+    tetValues.shrink_to_fit();
+    pyrValues.clear();
+    pyrValues.shrink_to_fit();
+    priValues.clear();
+    priValues.shrink_to_fit();
+    hexValues.clear();
+    hexValues.shrink_to_fit();
     topos.clear();
     topos.shrink_to_fit();
+    _neigVertBases.clear();
+    _neigVertBases.shrink_to_fit();
+    _neigElemBases.clear();
+    _neigElemBases.shrink_to_fit();
+    _neigVerts.clear();
+    _neigVerts.shrink_to_fit();
+    _neigElems.clear();
+    _neigElems.shrink_to_fit();
     nodeGroups().clear();
+    qualityCache().disable();
 }
 
 void Mesh::compileTopology(bool verbose)
+{
+    buildTopology(verbose, false);
+}
+
+void Mesh::updateTopology(bool verbose)
+{
+    buildTopology(verbose, true);
+}
+
+void Mesh::buildTopology(bool verbose, bool updateGroups)
 {
     if(verbose)
     {
@@ -224,6 +280,11 @@ void Mesh::compileTopology(bool verbose)
     pris.shrink_to_fit();
     hexs.shrink_to_fit();
 
+    tetValues.resize(tets.size());
+    pyrValues.resize(pyrs.size());
+    priValues.resize(pris.size());
+    hexValues.resize(hexs.size());
+
     size_t vertCount = verts.size();
 
     auto neigBegin = chrono::high_resolution_clock::now();
@@ -233,7 +294,15 @@ void Mesh::compileTopology(bool verbose)
 
     auto indeBegin = chrono::high_resolution_clock::now();
 
-    nodeGroups().build(*this);
+    if(updateGroups)
+        nodeGroups().update(*this);
+    else
+        nodeGroups().build(*this);
+
+    qualityCache().invalidate(*this);
+
+    if(!_topologyCompaction)
+        expandTopology();
 
     auto compileEnd = chrono::high_resolution_clock::now();
 
@@ -258,15 +327,19 @@ void Mesh::compileTopology(bool verbose)
         size_t neigElemCount = 0;
         for(int i=0; i < vertCount; ++i)
         {
-            neigVertCount += topos[i].neighborVerts.size();
-            neigElemCount += topos[i].neighborElems.size();
+            neigVertCount += neighborVerts(i).size();
+            neigElemCount += neighborElems(i).size();
         }
 
         int64_t meshMemorySize =
+                int64_t(_neigVertBases.size() * sizeof(uint)) +
+                int64_t(_neigElemBases.size() * sizeof(uint)) +
                 int64_t(verts.size() * sizeof(decltype(verts.front()))) +
                 int64_t(tets.size() * sizeof(decltype(tets.front()))) +
                 int64_t(pris.size() * sizeof(decltype(pris.front()))) +
                 int64_t(hexs.size() * sizeof(decltype(hexs.front()))) +
+                int64_t((tetValues.size() + pyrValues.size() +
+                         priValues.size() + hexValues.size()) * sizeof(double)) +
                 int64_t(topos.size() * sizeof(decltype(topos.front()))) +
                 int64_t(neigVertCount * sizeof(MeshNeigVert)) +
                 int64_t(neigElemCount * sizeof(MeshNeigElem));
@@ -283,6 +356,261 @@ void Mesh::compileTopology(bool verbose)
     }
 }
 
+void Mesh::setTopologyCompaction(bool enabled)
+{
+    _topologyCompaction = enabled;
+
+    if(!_topologyCompaction)
+        expandTopology();
+    else if(!topos.empty())
+        compactTopology();
+}
+
+void Mesh::expandTopology()
+{
+    if(!isTopologyCompact())
+        return;
+
+    size_t vertCount = std::min(topos.size(), _neigVertBases.size() - 1);
+    for(size_t i=0; i < vertCount; ++i)
+    {
+        MeshTopo& topo = topos[i];
+
+        topo.neighborVerts.assign(
+            _neigVerts.begin() + _neigVertBases[i],
+            _neigVerts.begin() + _neigVertBases[i+1]);
+
+        topo.neighborElems.assign(
+            _neigElems.begin() + _neigElemBases[i],
+            _neigElems.begin() + _neigElemBases[i+1]);
+    }
+
+    _neigVertBases.clear();
+    _neigVertBases.shrink_to_fit();
+    _neigElemBases.clear();
+    _neigElemBases.shrink_to_fit();
+    _neigVerts.clear();
+    _neigVerts.shrink_to_fit();
+    _neigElems.clear();
+    _neigElems.shrink_to_fit();
+}
+
+void Mesh::permuteNeighborhoods(const std::vector<int>& positions)
+{
+    if(!isTopologyCompact())
+    {
+        for(MeshTopo& topo : topos)
+        {
+            for(MeshNeigVert& vN : topo.neighborVerts)
+                vN.v = positions[vN.v];
+        }
+
+        return;
+    }
+
+    size_t vertCount = positions.size();
+    vector<uint> vertBases(vertCount + 1, 0);
+    vector<uint> elemBases(vertCount + 1, 0);
+    for(size_t v=0; v < vertCount; ++v)
+    {
+        vertBases[positions[v] + 1] = _neigVertBases[v+1] - _neigVertBases[v];
+        elemBases[positions[v] + 1] = _neigElemBases[v+1] - _neigElemBases[v];
+    }
+
+    for(size_t v=0; v < vertCount; ++v)
+    {
+        vertBases[v+1] += vertBases[v];
+        elemBases[v+1] += elemBases[v];
+    }
+
+    vector<MeshNeigVert> neigVerts(_neigVerts.size());
+    vector<MeshNeigElem> neigElems(_neigElems.size());
+    ThreadPool& pool = getThreadPool();
+    uint coreCountHint = pool.concurrency();
+    pool.parallelFor(coreCountHint, [&](size_t t){
+        size_t vBeg = (vertCount * t) / coreCountHint;
+        size_t vEnd = (vertCount * (t+1)) / coreCountHint;
+        for(size_t v=vBeg; v < vEnd; ++v)
+        {
+            uint nId = vertBases[positions[v]];
+            for(uint n=_neigVertBases[v]; n < _neigVertBases[v+1]; ++n, ++nId)
+                neigVerts[nId] = MeshNeigVert(positions[_neigVerts[n].v]);
+
+            std::copy(_neigElems.begin() + _neigElemBases[v],
+                      _neigElems.begin() + _neigElemBases[v+1],
+                      neigElems.begin() + elemBases[positions[v]]);
+        }
+    });
+
+    _neigVertBases = std::move(vertBases);
+    _neigElemBases = std::move(elemBases);
+    _neigVerts = std::move(neigVerts);
+    _neigElems = std::move(neigElems);
+}
+
+uint64_t curveKey(glm::uvec3 p, ERenumbering curve)
+{
+    const int CURVE_BITS = 21;
+    uint X[3] = {p.x, p.y, p.z};
+
+    if(curve == ERenumbering::Hilbert)
+    {
+        // Skilling's transform of axes into the
+        // transposed representation of the Hilbert index
+        const uint M = 1u << (CURVE_BITS - 1);
+        for(uint Q = M; Q > 1; Q >>= 1)
+        {
+            uint P = Q - 1;
+            for(int i=0; i < 3; ++i)
+            {
+                if(X[i] & Q)
+                {
+                    X[0] ^= P;
+                }
+                else
+                {
+                    uint t = (X[0] ^ X[i]) & P;
+                    X[0] ^= t;
+                    X[i] ^= t;
+                }
+            }
+        }
+
+        // Gray encode
+        X[1] ^= X[0];
+        X[2] ^= X[1];
+        uint t = 0;
+        for(uint Q = M; Q > 1; Q >>= 1)
+            if(X[2] & Q) t ^= Q - 1;
+        X[0] ^= t;
+        X[1] ^= t;
+        X[2] ^= t;
+    }
+
+    // Interleave bits (Morton order of transposed coordinates)
+    uint64_t key = 0;
+    for(int b=CURVE_BITS-1; b >= 0; --b)
+    {
+        key = (key << 1) | ((X[0] >> b) & 1);
+        key = (key << 1) | ((X[1] >> b) & 1);
+        key = (key << 1) | ((X[2] >> b) & 1);
+    }
+
+    return key;
+}
+
+template<typename Elem, typename KeyFunc>
+void renumberElements(std::vector<Elem>& elems,
+                      const std::vector<MeshVert>& verts,
+                      const std::vector<uint>& positions,
+                      const KeyFunc& keyFunc)
+{
+    size_t elemCount = elems.size();
+    std::vector<std::pair<uint64_t, uint>> keys(elemCount);
+    for(size_t i=0; i < elemCount; ++i)
+    {
+        Elem& elem = elems[i];
+        glm::dvec3 c(0.0);
+        for(uint v=0; v < Elem::VERTEX_COUNT; ++v)
+        {
+            elem.v[v] = positions[elem.v[v]];
+            c += verts[elem.v[v]].p;
+        }
+
+        keys[i] = std::make_pair(keyFunc(c / double(Elem::VERTEX_COUNT)), i);
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<Elem> sorted(elemCount);
+    for(size_t i=0; i < elemCount; ++i)
+        sorted[i] = elems[keys[i].second];
+    elems.swap(sorted);
+}
+
+struct CurveKeyFunc
+{
+    glm::dvec3 minBox;
+    double scale;
+    ERenumbering curve;
+
+    uint64_t operator() (const glm::dvec3& p) const
+    {
+        return curveKey(glm::uvec3((p - minBox) * scale), curve);
+    }
+};
+
+void Mesh::renumber(ERenumbering curve)
+{
+    size_t vertCount = verts.size();
+    if(curve == ERenumbering::None || vertCount == 0)
+        return;
+
+    auto renumBegin = chrono::high_resolution_clock::now();
+
+    // Quantize positions over the mesh's bounding box
+    glm::dvec3 minBox(INFINITY);
+    glm::dvec3 maxBox(-INFINITY);
+    for(const MeshVert& vert : verts)
+    {
+        minBox = glm::min(minBox, vert.p);
+        maxBox = glm::max(maxBox, vert.p);
+    }
+
+    glm::dvec3 extents = maxBox - minBox;
+    double maxExtent = glm::max(glm::max(extents.x, extents.y), extents.z);
+    double scale = maxExtent > 0.0 ? double((1 << 21) - 1) / maxExtent : 0.0;
+    CurveKeyFunc keyFunc = {minBox, scale, curve};
+
+
+    // Sort vertices
+    std::vector<std::pair<uint64_t, uint>> keys(vertCount);
+    for(size_t i=0; i < vertCount; ++i)
+        keys[i] = std::make_pair(keyFunc(verts[i].p), i);
+    std::sort(keys.begin(), keys.end());
+
+    expandTopology();
+    bool hasTopos = (topos.size() == vertCount);
+
+    std::vector<uint> positions(vertCount);
+    std::vector<MeshVert> sortedVerts(vertCount);
+    std::vector<MeshTopo> sortedTopos(hasTopos ? vertCount : 0);
+    for(size_t i=0; i < vertCount; ++i)
+    {
+        uint vId = keys[i].second;
+        positions[vId] = i;
+        sortedVerts[i] = verts[vId];
+
+        if(hasTopos)
+        {
+            // Constraints follow their vertex, neighborhoods are dropped
+            sortedTopos[i] = MeshTopo(topos[vId].snapToBoundary);
+        }
+    }
+    verts.swap(sortedVerts);
+    if(hasTopos) topos.swap(sortedTopos);
+
+
+    // Sort elements by their centroid
+    renumberElements(tets, verts, positions, keyFunc);
+    renumberElements(pyrs, verts, positions, keyFunc);
+    renumberElements(pris, verts, positions, keyFunc);
+    renumberElements(hexs, verts, positions, keyFunc);
+
+    // Element values are indexed by element : drop them
+    tetValues.clear();
+    pyrValues.clear();
+    priValues.clear();
+    hexValues.clear();
+
+    nodeGroups().clear();
+
+    auto renumEnd = chrono::high_resolution_clock::now();
+    int renumTime = chrono::duration_cast<chrono::milliseconds>(renumEnd - renumBegin).count();
+    getLog().postMessage(new Message('I', false,
+        "Space filling curve renumbering time: " + to_string(renumTime) + "ms", "Mesh"));
+}
+
 void Mesh::updateGlslTopology() const
 {
 
@@ -361,99 +689,185 @@ void Mesh::setBoundary(const std::shared_ptr<AbstractBoundary>& boundary)
     assert(_boundary->unitTest());
 }
 
-void Mesh::compileNeighborhoods()
+template<typename Elem, typename ElemFunc, typename EdgeFunc>
+void emitIncidences(
+        const vector<Elem>& elems,
+        uint t, uint coreCount,
+        ElemFunc& elemFunc,
+        EdgeFunc& edgeFunc)
 {
-    for(MeshTopo& topo : topos)
-    {
-        topo.neighborElems.clear();
-        topo.neighborVerts.clear();
-    }
-
-    size_t tetCount = tets.size();
-    for(size_t i=0; i < tetCount; ++i)
+    size_t elemCount = elems.size();
+    size_t beg = (elemCount * t) / coreCount;
+    size_t end = (elemCount * (t+1)) / coreCount;
+    for(size_t i=beg; i < end; ++i)
     {
-        for(int v=0; v < MeshTet::VERTEX_COUNT; ++v)
-        {
-            topos[tets[i].v[v]].neighborElems.push_back(
-                MeshNeigElem(i, MeshTet::ELEMENT_TYPE, v));
-        }
+        const Elem& elem = elems[i];
+        for(uint v=0; v < Elem::VERTEX_COUNT; ++v)
+            elemFunc(elem.v[v], MeshNeigElem(i, Elem::ELEMENT_TYPE, v));
 
-        for(int e=0; e < MeshTet::EDGE_COUNT; ++e)
+        for(uint e=0; e < Elem::EDGE_COUNT; ++e)
         {
-            addEdge(tets[i].v[MeshTet::edges[e][0]],
-                    tets[i].v[MeshTet::edges[e][1]]);
+            uint v0 = elem.v[Elem::edges[e][0]];
+            uint v1 = elem.v[Elem::edges[e][1]];
+            edgeFunc(v0, v1);
+            edgeFunc(v1, v0);
         }
     }
+}
 
-    size_t pyramidCount = pyrs.size();
-    for(size_t i=0; i < pyramidCount; ++i)
-    {
-        for(int v=0; v < MeshPyr::VERTEX_COUNT; ++v)
-        {
-            topos[pyrs[i].v[v]].neighborElems.push_back(
-                MeshNeigElem(i, MeshPyr::ELEMENT_TYPE, v));
-        }
+template<typename ElemFunc, typename EdgeFunc>
+void emitIncidences(
+        const Mesh& mesh,
+        uint t, uint coreCount,
+        ElemFunc elemFunc,
+        EdgeFunc edgeFunc)
+{
+    emitIncidences(mesh.tets, t, coreCount, elemFunc, edgeFunc);
+    emitIncidences(mesh.pyrs, t, coreCount, elemFunc, edgeFunc);
+    emitIncidences(mesh.pris, t, coreCount, elemFunc, edgeFunc);
+    emitIncidences(mesh.hexs, t, coreCount, elemFunc, edgeFunc);
+}
 
-        for(int e=0; e < MeshPyr::EDGE_COUNT; ++e)
-        {
-            addEdge(pyrs[i].v[MeshPyr::edges[e][0]],
-                    pyrs[i].v[MeshPyr::edges[e][1]]);
-        }
+void Mesh::compileNeighborhoods()
+{
+    size_t vertCount = verts.size();
+    ThreadPool& pool = getThreadPool();
+    uint coreCountHint = pool.concurrency();
+
+    // Incidences are bucketed by vertex with a counting sort :
+    // count each vertex's incidences, prefix-sum the counts into
+    // bases and then scatter incidences at their vertex's cursor.
+    vector<uint> elemBases(vertCount + 1);
+    vector<uint> vertBases(vertCount + 1);
+    unique_ptr<atomic<uint>[]> elemCursors(new atomic<uint>[vertCount]);
+    unique_ptr<atomic<uint>[]> vertCursors(new atomic<uint>[vertCount]);
+    for(size_t v=0; v < vertCount; ++v)
+    {
+        elemCursors[v].store(0, memory_order_relaxed);
+        vertCursors[v].store(0, memory_order_relaxed);
     }
 
-    size_t prismCount = pris.size();
-    for(size_t i=0; i < prismCount; ++i)
+    auto forEachCore = [&](const function<void(uint)>& task)
     {
-        for(int v=0; v < MeshPri::VERTEX_COUNT; ++v)
-        {
-            topos[pris[i].v[v]].neighborElems.push_back(
-                MeshNeigElem(i, MeshPri::ELEMENT_TYPE, v));
-        }
+        pool.parallelFor(coreCountHint, [&task](size_t t){ task(uint(t)); });
+    };
 
-        for(int e=0; e < MeshPri::EDGE_COUNT; ++e)
-        {
-            addEdge(pris[i].v[MeshPri::edges[e][0]],
-                    pris[i].v[MeshPri::edges[e][1]]);
-        }
-    }
 
-    size_t hexCount = hexs.size();
-    for(size_t i=0; i < hexCount; ++i)
+    // Count incidences
+    forEachCore([&](uint t){
+        emitIncidences(*this, t, coreCountHint,
+            [&](uint v, const MeshNeigElem&) {
+                elemCursors[v].fetch_add(1, memory_order_relaxed);},
+            [&](uint v, uint) {
+                vertCursors[v].fetch_add(1, memory_order_relaxed);});
+    });
+
+    for(size_t v=0; v < vertCount; ++v)
     {
-        for(int v=0; v < MeshHex::VERTEX_COUNT; ++v)
-        {
-            topos[hexs[i].v[v]].neighborElems.push_back(
-                MeshNeigElem(i, MeshHex::ELEMENT_TYPE, v));
-        }
+        elemBases[v+1] = elemBases[v] + elemCursors[v].load(memory_order_relaxed);
+        vertBases[v+1] = vertBases[v] + vertCursors[v].load(memory_order_relaxed);
+        elemCursors[v].store(elemBases[v], memory_order_relaxed);
+        vertCursors[v].store(vertBases[v], memory_order_relaxed);
+    }
+
 
-        for(int e=0; e < MeshHex::EDGE_COUNT; ++e)
+    // Scatter incidences
+    vector<MeshNeigElem> neigElems(elemBases[vertCount]);
+    vector<MeshNeigVert> neigVerts(vertBases[vertCount]);
+    forEachCore([&](uint t){
+        emitIncidences(*this, t, coreCountHint,
+            [&](uint v, const MeshNeigElem& n) {
+                neigElems[elemCursors[v].fetch_add(1, memory_order_relaxed)] = n;},
+            [&](uint v, uint n) {
+                neigVerts[vertCursors[v].fetch_add(1, memory_order_relaxed)] = n;});
+    });
+
+
+    // Sort and deduplicate each vertex's neighborhood.
+    // Sorting also makes the result independent of scatter order.
+    forEachCore([&](uint t){
+        size_t vBeg = (vertCount * t) / coreCountHint;
+        size_t vEnd = (vertCount * (t+1)) / coreCountHint;
+        for(size_t v=vBeg; v < vEnd; ++v)
         {
-            addEdge(hexs[i].v[MeshHex::edges[e][0]],
-                    hexs[i].v[MeshHex::edges[e][1]]);
+            auto eBeg = neigElems.begin() + elemBases[v];
+            auto eEnd = neigElems.begin() + elemBases[v+1];
+            std::sort(eBeg, eEnd, [](const MeshNeigElem& a, const MeshNeigElem& b) {
+                return a.type < b.type || (a.type == b.type && a.id < b.id);
+            });
+
+            auto nBeg = neigVerts.begin() + vertBases[v];
+            auto nEnd = neigVerts.begin() + vertBases[v+1];
+            std::sort(nBeg, nEnd, [](const MeshNeigVert& a, const MeshNeigVert& b) {
+                return a.v < b.v;
+            });
+            nEnd = std::unique(nBeg, nEnd, [](const MeshNeigVert& a, const MeshNeigVert& b) {
+                return a.v == b.v;
+            });
+            vertCursors[v].store(nEnd - nBeg, memory_order_relaxed);
+
+            // Neighborhoods now live in the compact store
+            vector<MeshNeigVert>().swap(topos[v].neighborVerts);
+            vector<MeshNeigElem>().swap(topos[v].neighborElems);
         }
-    }
+    });
 
 
-    // Compact topology neighborhoods
-    size_t vertCount = verts.size();
-    for(int i=0; i < vertCount; ++i)
+    // Pack deduplicated neighbor verts in place. Buckets only
+    // shrink, so each one moves toward the front of the array.
+    uint neigVertBase = 0;
+    for(size_t v=0; v < vertCount; ++v)
     {
-        topos[i].neighborVerts.shrink_to_fit();
-        topos[i].neighborElems.shrink_to_fit();
+        uint count = vertCursors[v].load(memory_order_relaxed);
+        auto nBeg = neigVerts.begin() + vertBases[v];
+        std::copy(nBeg, nBeg + count, neigVerts.begin() + neigVertBase);
+        vertBases[v] = neigVertBase;
+        neigVertBase += count;
     }
+    vertBases[vertCount] = neigVertBase;
+    neigVerts.resize(neigVertBase);
+    neigVerts.shrink_to_fit();
+
+    _neigVertBases = std::move(vertBases);
+    _neigElemBases = std::move(elemBases);
+    _neigVerts = std::move(neigVerts);
+    _neigElems = std::move(neigElems);
 }
 
-void Mesh::addEdge(int firstVert, int secondVert)
+void Mesh::compactTopology()
 {
-    vector<MeshNeigVert>& neighbors = topos[firstVert].neighborVerts;
-    int neighborCount = neighbors.size();
-    for(int n=0; n < neighborCount; ++n)
+    if(isTopologyCompact())
+        return;
+
+    size_t vertCount = topos.size();
+    _neigVertBases.resize(vertCount + 1);
+    _neigElemBases.resize(vertCount + 1);
+
+    uint neigVertBase = 0;
+    uint neigElemBase = 0;
+    for(size_t i=0; i < vertCount; ++i)
     {
-        if(secondVert == neighbors[n])
-            return;
+        _neigVertBases[i] = neigVertBase;
+        _neigElemBases[i] = neigElemBase;
+        neigVertBase += topos[i].neighborVerts.size();
+        neigElemBase += topos[i].neighborElems.size();
     }
+    _neigVertBases[vertCount] = neigVertBase;
+    _neigElemBases[vertCount] = neigElemBase;
 
-    // This really is a new edge
-    topos[firstVert].neighborVerts.push_back(secondVert);
-    topos[secondVert].neighborVerts.push_back(firstVert);
+    _neigVerts.resize(neigVertBase);
+    _neigElems.resize(neigElemBase);
+    for(size_t i=0; i < vertCount; ++i)
+    {
+        MeshTopo& topo = topos[i];
+
+        std::copy(topo.neighborVerts.begin(), topo.neighborVerts.end(),
+                  _neigVerts.begin() + _neigVertBases[i]);
+        std::copy(topo.neighborElems.begin(), topo.neighborElems.end(),
+                  _neigElems.begin() + _neigElemBases[i]);
+
+        // Release per-vertex allocations
+        vector<MeshNeigVert>().swap(topo.neighborVerts);
+        vector<MeshNeigElem>().swap(topo.neighborElems);
+    }
 }
@@ -22,6 +22,7 @@ class AbstractBoundary;
 class AbstractConstraint;
 class OptimizationPlot;
 class NodeGroups;
+class QualityCache;
 
 
 struct MeshVert
@@ -68,7 +69,6 @@ struct MeshTri
 struct MeshTet
 {
     uint v[4];
-    double value;    
     mutable uint c[1];
 
 
@@ -126,7 +126,6 @@ struct MeshLocalTet
 struct MeshPyr
 {
     uint v[5];
-    double value;
     mutable uint c[4];
 
 
@@ -163,7 +162,6 @@ struct MeshPyr
 struct MeshPri
 {
     uint v[6];
-    double value;
     mutable uint c[6];
 
 
@@ -201,7 +199,6 @@ struct MeshPri
 struct MeshHex
 {
     uint v[8];
-    double value;
     mutable uint c[8];
 
 
@@ -268,6 +265,20 @@ struct MeshTopo
     explicit MeshTopo(const AbstractConstraint* constraint);
 };
 
+template<typename Neig>
+struct MeshNeigRange
+{
+    const Neig* b;
+    const Neig* e;
+
+    inline MeshNeigRange(const Neig* b, const Neig* e) : b(b), e(e) {}
+    inline const Neig* begin() const { return b; }
+    inline const Neig* end() const { return e; }
+    inline size_t size() const { return e - b; }
+    inline bool empty() const { return b == e; }
+    inline const Neig& operator[] (size_t i) const { return b[i]; }
+};
+
 
 typedef glm::dmat3 MeshMetric;
 
@@ -299,6 +310,13 @@ enum class EBufferBinding
     SPAWN_OFFSETS_BUFFER_BINDING
 };
 
+enum class ERenumbering
+{
+    None,
+    Morton,
+    Hilbert
+};
+
 enum class ECutType
 {
     None,
@@ -321,6 +339,32 @@ public:
 
     virtual void compileTopology(bool verbose = true);
 
+    // Same as compileTopology(), but only regroups the
+    // nodes that topology editors marked dirty in nodeGroups()
+    virtual void updateTopology(bool verbose = false);
+
+    // Neighborhoods are read from the compact topology store when
+    // it was built by compileTopology(), from MeshTopo otherwise
+    MeshNeigRange<MeshNeigVert> neighborVerts(uint vId) const;
+    MeshNeigRange<MeshNeigElem> neighborElems(uint vId) const;
+
+    bool isTopologyCompact() const;
+    bool topologyCompaction() const;
+    void setTopologyCompaction(bool enabled);
+
+    // Moves compact neighborhoods back into MeshTopo's
+    // vectors so that they can be edited in place
+    virtual void expandTopology();
+
+    // Renames neighbor verts as vertex v becomes vertex positions[v].
+    // Compact neighborhoods are also moved to their vertex's new place,
+    // MeshTopo's ones move with topos.
+    virtual void permuteNeighborhoods(const std::vector<int>& positions);
+
+    // Sorts vertices and elements along a space filling curve.
+    // Neighborhoods are invalidated : compile the topology afterward.
+    virtual void renumber(ERenumbering curve);
+
     virtual void updateGlslTopology() const;
     virtual void updateGlslVertices() const;
     virtual void fetchGlslVertices();
@@ -341,6 +385,8 @@ public:
 
     NodeGroups& nodeGroups() const;
 
+    QualityCache& qualityCache() const;
+
     AbstractBoundary& boundary() const;
     void setBoundary(const std::shared_ptr<AbstractBoundary>& boundary);
 
@@ -353,13 +399,30 @@ public:
     std::vector<MeshPri>  pris;
     std::vector<MeshHex>  hexs;
 
+    // Per element scalars (qualities, debug highlights) kept apart
+    // from element records so that connectivity stays tightly packed
+    std::vector<double> tetValues;
+    std::vector<double> pyrValues;
+    std::vector<double> priValues;
+    std::vector<double> hexValues;
+
 
 protected:
+    void buildTopology(bool verbose, bool updateGroups);
+    // Builds neighborhoods straight into the compact topology store
     virtual void compileNeighborhoods();
-    virtual void addEdge(int firstVert,
-                         int secondVert);
+    virtual void compactTopology();
+
+    // Compressed sparse row topology :
+    // neighbors of vertex i are in [bases[i], bases[i+1])
+    bool _topologyCompaction;
+    std::vector<uint> _neigVertBases;
+    std::vector<uint> _neigElemBases;
+    std::vector<MeshNeigVert> _neigVerts;
+    std::vector<MeshNeigElem> _neigElems;
 
     std::shared_ptr<NodeGroups> _nodeGroups;
+    std::shared_ptr<QualityCache> _qualityCache;
     std::shared_ptr<AbstractBoundary> _boundary;
 };
 
@@ -371,9 +434,50 @@ inline NodeGroups& Mesh::nodeGroups() const
     return *_nodeGroups;
 }
 
+inline QualityCache& Mesh::qualityCache() const
+{
+    return *_qualityCache;
+}
+
 inline AbstractBoundary& Mesh::boundary() const
 {
     return *_boundary;
 }
 
+inline MeshNeigRange<MeshNeigVert> Mesh::neighborVerts(uint vId) const
+{
+    if(_neigVertBases.empty())
+    {
+        const std::vector<MeshNeigVert>& n = topos[vId].neighborVerts;
+        return MeshNeigRange<MeshNeigVert>(n.data(), n.data() + n.size());
+    }
+
+    const MeshNeigVert* n = _neigVerts.data();
+    return MeshNeigRange<MeshNeigVert>(
+        n + _neigVertBases[vId], n + _neigVertBases[vId+1]);
+}
+
+inline MeshNeigRange<MeshNeigElem> Mesh::neighborElems(uint vId) const
+{
+    if(_neigElemBases.empty())
+    {
+        const std::vector<MeshNeigElem>& n = topos[vId].neighborElems;
+        return MeshNeigRange<MeshNeigElem>(n.data(), n.data() + n.size());
+    }
+
+    const MeshNeigElem* n = _neigElems.data();
+    return MeshNeigRange<MeshNeigElem>(
+        n + _neigElemBases[vId], n + _neigElemBases[vId+1]);
+}
+
+inline bool Mesh::isTopologyCompact() const
+{
+    return !_neigVertBases.empty();
+}
+
+inline bool Mesh::topologyCompaction() const
+{
+    return _topologyCompaction;
+}
+
 #endif // GPUMESH_MESH
@@ -1,15 +1,19 @@
 #include "MeshCrew.h"
 
 #include <CellarWorkbench/GL/GlProgram.h>
+#include <CellarWorkbench/Misc/Log.h>
 
 #include "Mesh.h"
 #include "Boundaries/AbstractBoundary.h"
 #include "Evaluators/AbstractEvaluator.h"
+#include "Evaluators/Pipeline.h"
 #include "Measurers/MetricFreeMeasurer.h"
 #include "Measurers/MetricWiseMeasurer.h"
 #include "Samplers/AbstractSampler.h"
 #include "Topologists/BatrTopologist.h"
 
+using namespace cellar;
+
 
 const std::string METRIC_FREE = "Metric Free";
 const std::string METRIC_WISE = "Metric Wise";
@@ -84,6 +88,11 @@ const AbstractTopologist& MeshCrew::topologist() const
     return *_topologist;
 }
 
+const AbstractPipeline& MeshCrew::pipeline() const
+{
+    return *_pipeline;
+}
+
 std::shared_ptr<AbstractSampler> MeshCrew::samplerPtr() const
 {
     return _sampler;
@@ -109,6 +118,36 @@ void MeshCrew::setEvaluator(const Mesh& mesh, const std::shared_ptr<AbstractEval
     reinitCrew(mesh);
 }
 
+OptionMapDetails MeshCrew::availableMetricIntegrations() const
+{
+    std::shared_ptr<AbstractMeasurer> measurer;
+    _availableMeasurers.select(METRIC_WISE, measurer);
+    return std::static_pointer_cast<MetricWiseMeasurer>(
+        measurer)->availableIntegrations();
+}
+
+void MeshCrew::setMetricIntegration(const Mesh& mesh, const std::string& integrationName)
+{
+    std::shared_ptr<AbstractMeasurer> measurer;
+    _availableMeasurers.select(METRIC_WISE, measurer);
+
+    std::shared_ptr<MetricWiseMeasurer> wiseMeasurer =
+        std::static_pointer_cast<MetricWiseMeasurer>(measurer);
+    wiseMeasurer->setIntegration(integrationName);
+
+    if(_isInitialized && _sampler->isMetricWise() && !mesh.verts.empty())
+    {
+        double meanError, maxError;
+        wiseMeasurer->estimateIntegrationError(
+            mesh, *_sampler, meanError, maxError);
+
+        getLog().postMessage(new Message('I', false,
+            "Edge length relative error against adaptive integration: mean = " +
+            std::to_string(meanError) + ", max = " + std::to_string(maxError),
+            "MeshCrew"));
+    }
+}
+
 void MeshCrew::installPlugins(const Mesh& mesh, cellar::GlProgram& program) const
 {
     _sampler->installPlugin(mesh, program);
@@ -153,11 +192,15 @@ void MeshCrew::clearCudaMemory(const Mesh& mesh) const
 
 void MeshCrew::reinitCrew(const Mesh& mesh)
 {
-    if(_isInitialized)
+    if(_sampler.get()   != nullptr &&
+       _measurer.get()  != nullptr &&
+       _evaluator.get() != nullptr)
     {
-        if(_sampler.get()   != nullptr &&
-           _measurer.get()  != nullptr &&
-           _evaluator.get() != nullptr)
+        // The evaluator picks the pipeline matching the
+        // actual types of the sampler and the measurer
+        _pipeline = _evaluator->createPipeline(*_sampler, *_measurer);
+
+        if(_isInitialized)
         {
             _evaluator->initialize(mesh, *this);
         }
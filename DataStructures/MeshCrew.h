@@ -14,6 +14,7 @@ class Mesh;
 class AbstractSampler;
 class AbstractEvaluator;
 class AbstractMeasurer;
+class AbstractPipeline;
 class AbstractSmoother;
 class AbstractTopologist;
 
@@ -37,6 +38,9 @@ public:
     const AbstractEvaluator& evaluator() const;
     const AbstractTopologist& topologist() const;
 
+    // Evaluator, measurer and sampler bound together for hot loops
+    const AbstractPipeline& pipeline() const;
+
     std::shared_ptr<AbstractSampler> samplerPtr() const;
 
     void initialize(const Mesh& mesh);
@@ -46,6 +50,10 @@ public:
     void setSampler(const Mesh& mesh, const std::shared_ptr<AbstractSampler>& sampler);
     void setEvaluator(const Mesh& mesh, const std::shared_ptr<AbstractEvaluator>& evaluator);
 
+    // Edge length integration of the metric wise measurer
+    OptionMapDetails availableMetricIntegrations() const;
+    void setMetricIntegration(const Mesh& mesh, const std::string& integrationName);
+
     void installPlugins(const Mesh& mesh, cellar::GlProgram& program) const;
     void setPluginGlslUniforms(const Mesh& mesh, cellar::GlProgram& program) const;
     void setPluginCudaUniforms(const Mesh& mesh) const;
@@ -65,6 +73,7 @@ private:
     std::shared_ptr<AbstractSampler> _sampler;
     std::shared_ptr<AbstractMeasurer> _measurer;
     std::shared_ptr<AbstractEvaluator> _evaluator;
+    std::shared_ptr<AbstractPipeline> _pipeline;
     std::shared_ptr<AbstractTopologist> _topologist;
     bool _isInitialized;
 };
@@ -1,12 +1,13 @@
 #include "NodeGroups.h"
 
-#include <set>
 #include <iostream>
+#include <iterator>
 #include <algorithm>
 
 #include <CellarWorkbench/Misc/Log.h>
 
 #include "Mesh.h"
+#include "ThreadPool.h"
 #include "Boundaries/Constraints/AbstractConstraint.h"
 
 using namespace cellar;
@@ -21,6 +22,12 @@ const int NodeGroups::BOUND_TYPE = 1;
 const int NodeGroups::SUBSU_TYPE = 2;
 const int NodeGroups::INTER_TYPE = 3;
 
+const size_t NodeGroups::CHUNKS_PER_WORKER = 8;
+const size_t NodeGroups::MIN_CHUNK_SIZE = 16;
+const size_t NodeGroups::COLORING_BLOCK_SIZE = 32768;
+const int NodeGroups::BALANCING_ITERATIONS = 3;
+const double NodeGroups::UPDATE_MAX_DIRTY_RATIO = 0.25;
+
 
 NodeGroups::Range::Range() :
     begin(0),
@@ -39,7 +46,9 @@ NodeGroups::GpuDispatch::GpuDispatch() :
 }
 
 NodeGroups::NodeGroups() :
-    _cpuWorkerCount(1)
+    _cpuWorkerCount(1),
+    _coloring(EGroupColoring::Serial),
+    _balancing(true)
 {
     _gpuDispatcher = [](GpuDispatch& d)
     {
@@ -56,6 +65,16 @@ void NodeGroups::setCpuWorkerCount(size_t workerCount)
     dispatchGpuWorkgroups();
 }
 
+void NodeGroups::setColoring(EGroupColoring coloring)
+{
+    _coloring = coloring;
+}
+
+void NodeGroups::setBalancing(bool enabled)
+{
+    _balancing = enabled;
+}
+
 void NodeGroups::setGpuDispatcher(const GpuDispatcher& dispatcher)
 {
     _gpuDispatcher = dispatcher;
@@ -77,6 +96,15 @@ void NodeGroups::clear()
 
     _parallelGroups.clear();
     _parallelGroups.shrink_to_fit();
+
+    _nodeTypes.clear();
+    _nodeTypes.shrink_to_fit();
+
+    _nodeGroupIds.clear();
+    _nodeGroupIds.shrink_to_fit();
+
+    _dirtyNodes.clear();
+    _dirtyNodes.shrink_to_fit();
 }
 
 void NodeGroups::shrink_to_fit()
@@ -90,13 +118,13 @@ void NodeGroups::shrink_to_fit()
     {
         group.undispatchedNodes.shrink_to_fit();
 
-        group.allDispatchedNodes.shrink_to_fit();
-        for(std::vector<uint>& dispatch : group.allDispatchedNodes)
-            dispatch.shrink_to_fit();
+        group.allNodeChunks.shrink_to_fit();
+        for(std::vector<uint>& chunk : group.allNodeChunks)
+            chunk.shrink_to_fit();
 
-        group.cpuOnlyDispatchedNodes.shrink_to_fit();
-        for(std::vector<uint>& dispatch : group.cpuOnlyDispatchedNodes)
-            dispatch.shrink_to_fit();
+        group.cpuOnlyNodeChunks.shrink_to_fit();
+        for(std::vector<uint>& chunk : group.cpuOnlyNodeChunks)
+            chunk.shrink_to_fit();
     }
 }
 
@@ -108,18 +136,131 @@ void NodeGroups::build(Mesh& mesh)
     determineTypes(mesh, types);
 
     std::vector<int> groups;
-    determineGroups(mesh, groups);
+    if(_coloring == EGroupColoring::Partitioned)
+        determineGroupsPartitioned(mesh, groups);
+    else
+        determineGroups(mesh, groups);
+
+    if(_balancing)
+        balanceGroups(mesh, types, groups);
 
     std::vector<int> positions;
     determinePositions(mesh, types, groups, positions);
 
     clusterNodes(mesh, types, groups, positions);
 
+    // Keep nodes' labels for later updates
+    _nodeTypes.swap(types);
+    _nodeGroupIds.swap(groups);
+    _dirtyNodes.assign(mesh.verts.size(), false);
+
     // Dispatch workgroups
     dispatchCpuWorkgroups();
     dispatchGpuWorkgroups();
 }
 
+void NodeGroups::markDirty(uint vId)
+{
+    // Nothing to maintain until groups are built
+    if(_nodeGroupIds.empty())
+        return;
+
+    if(vId >= _dirtyNodes.size())
+    {
+        _nodeTypes.resize(vId+1, UNSET_TYPE);
+        _nodeGroupIds.resize(vId+1, UNSET_GROUP);
+        _dirtyNodes.resize(vId+1, true);
+    }
+
+    _dirtyNodes[vId] = true;
+}
+
+void NodeGroups::eraseNodes(const std::vector<bool>& aliveNodes)
+{
+    if(_nodeGroupIds.empty())
+        return;
+
+    size_t nodeCount = aliveNodes.size();
+    if(_nodeGroupIds.size() > nodeCount)
+    {
+        // Labels don't match the vertex buffer anymore
+        // Next update() will have to build groups anew
+        _nodeTypes.clear();
+        _nodeGroupIds.clear();
+        _dirtyNodes.clear();
+        return;
+    }
+
+    _nodeTypes.resize(nodeCount, UNSET_TYPE);
+    _nodeGroupIds.resize(nodeCount, UNSET_GROUP);
+    _dirtyNodes.resize(nodeCount, true);
+
+    // Same compaction as the vertex buffer's
+    size_t copyId = 0;
+    for(size_t vId=0; vId < nodeCount; ++vId)
+    {
+        if(aliveNodes[vId])
+        {
+            _nodeTypes[copyId] = _nodeTypes[vId];
+            _nodeGroupIds[copyId] = _nodeGroupIds[vId];
+            _dirtyNodes[copyId] = _dirtyNodes[vId];
+            ++copyId;
+        }
+    }
+
+    _nodeTypes.resize(copyId);
+    _nodeGroupIds.resize(copyId);
+    _dirtyNodes.resize(copyId);
+}
+
+void NodeGroups::update(Mesh& mesh)
+{
+    size_t vertCount = mesh.verts.size();
+    if(_nodeGroupIds.empty() || _nodeGroupIds.size() > vertCount)
+    {
+        build(mesh);
+        return;
+    }
+
+    // Nodes added since the last update are dirty
+    _nodeTypes.resize(vertCount, UNSET_TYPE);
+    _nodeGroupIds.resize(vertCount, UNSET_GROUP);
+    _dirtyNodes.resize(vertCount, true);
+
+    std::vector<uint> dirtyNodes;
+    for(size_t vId=0; vId < vertCount; ++vId)
+        if(_dirtyNodes[vId])
+            dirtyNodes.push_back(vId);
+
+    if(dirtyNodes.size() > vertCount * UPDATE_MAX_DIRTY_RATIO)
+    {
+        build(mesh);
+        return;
+    }
+
+    std::vector<int> types;
+    std::vector<int> groups;
+    types.swap(_nodeTypes);
+    groups.swap(_nodeGroupIds);
+    clear();
+
+    std::vector<bool> movedNodes;
+    retypeNodes(mesh, dirtyNodes, types, movedNodes);
+    regroupNodes(mesh, dirtyNodes, types, groups);
+
+    std::vector<int> positions;
+    repositionNodes(mesh, types, groups, movedNodes, positions);
+
+    clusterNodes(mesh, types, groups, positions);
+
+    _nodeTypes.swap(types);
+    _nodeGroupIds.swap(groups);
+    _dirtyNodes.assign(vertCount, false);
+
+    dispatchCpuWorkgroups();
+    dispatchGpuWorkgroups();
+}
+
 void NodeGroups::determineTypes(const Mesh& mesh, std::vector<int>& types)
 {
     size_t vertCount = mesh.verts.size();
@@ -219,7 +360,7 @@ void NodeGroups::determineTypes(const Mesh& mesh, std::vector<int>& types)
         else
         {
             bool isSubsurface = false;
-            for(const MeshNeigElem& ne : topo.neighborElems)
+            for(const MeshNeigElem& ne : mesh.neighborElems(vId))
             {
                 if((ne.type == MeshTet::ELEMENT_TYPE && boundingTets[ne.id]) ||
                    (ne.type == MeshPyr::ELEMENT_TYPE && boundingPyrs[ne.id]) ||
@@ -239,17 +380,67 @@ void NodeGroups::determineTypes(const Mesh& mesh, std::vector<int>& types)
     }
 }
 
+template<typename Elem, typename Func>
+inline void forEachElemNode(const Elem& elem, Func& func)
+{
+    for(size_t n=0; n < Elem::VERTEX_COUNT; ++n)
+        func(elem.v[n]);
+}
+
+// Calls func on every node sharing an element with vId (vId included)
+template<typename Func>
+void forEachPatchNode(const Mesh& mesh, uint vId, Func func)
+{
+    for(const MeshNeigElem& neigElem : mesh.neighborElems(vId))
+    {
+        switch(neigElem.type)
+        {
+        case MeshTet::ELEMENT_TYPE :
+            forEachElemNode(mesh.tets[neigElem.id], func); break;
+        case MeshPyr::ELEMENT_TYPE :
+            forEachElemNode(mesh.pyrs[neigElem.id], func); break;
+        case MeshPri::ELEMENT_TYPE :
+            forEachElemNode(mesh.pris[neigElem.id], func); break;
+        case MeshHex::ELEMENT_TYPE :
+            forEachElemNode(mesh.hexs[neigElem.id], func); break;
+        }
+    }
+}
+
+template<typename Func>
+inline int firstFitGroup(
+        const Mesh& mesh,
+        uint vId,
+        std::vector<int>& stamps,
+        const Func& groupOf)
+{
+    forEachPatchNode(mesh, vId, [&](uint nId){
+        int group = groupOf(nId);
+        if(group >= 0)
+        {
+            if(group >= int(stamps.size()))
+                stamps.resize(group+1, -1);
+            stamps[group] = vId;
+        }
+    });
+
+    int group = 0;
+    while(group < int(stamps.size()) && stamps[group] == int(vId))
+        ++group;
+
+    return group;
+}
+
 void NodeGroups::determineGroups(const Mesh& mesh, std::vector<int>& groups)
 {
     size_t vertCount = mesh.verts.size();
-    const std::vector<MeshTet>& tets = mesh.tets;
-    const std::vector<MeshPyr>& pyrs = mesh.pyrs;
-    const std::vector<MeshPri>& pris = mesh.pris;
-    const std::vector<MeshHex>& hexs = mesh.hexs;
-    const std::vector<MeshTopo>& topos = mesh.topos;
+
+    // Existing groups are [0, groupCount). A group is unavailable
+    // to a node when its stamp is the node's id.
+    int groupCount = 0;
+    std::vector<int> stamps;
 
     size_t seekStart = 0;
-    std::set<uint> existingGroups;
     std::vector<size_t> nextNodes;
     groups = std::vector<int> (vertCount, NO_GROUP);
     while(nextNodes.size() < vertCount)
@@ -266,94 +457,31 @@ void NodeGroups::determineGroups(const Mesh& mesh, std::vector<int>& groups)
             }
         }
 
-        for(int v=firstNode; v < nextNodes.size(); ++v)
+        for(size_t v=firstNode; v < nextNodes.size(); ++v)
         {
             uint vId = nextNodes[v];
-            const MeshTopo& topo = topos[vId];
-            std::set<uint> availableGroups = existingGroups;
 
-            for(size_t e=0; e < topo.neighborElems.size(); ++e)
-            {
-                const MeshNeigElem& neigElem = topo.neighborElems[e];
-                if(neigElem.type == MeshTet::ELEMENT_TYPE)
+            forEachPatchNode(mesh, vId, [&](uint nId){
+                int& group = groups[nId];
+                if(group == NO_GROUP)
                 {
-                    const MeshTet& elem = tets[neigElem.id];
-                    for(size_t n=0; n < MeshTet::VERTEX_COUNT; ++n)
-                    {
-                        int& group = groups[elem.v[n]];
-                        if(group == NO_GROUP)
-                        {
-                            group = UNSET_GROUP;
-                            nextNodes.push_back(elem.v[n]);
-                        }
-                        else if(group != UNSET_GROUP)
-                        {
-                            availableGroups.erase(group);
-                        }
-                    }
+                    group = UNSET_GROUP;
+                    nextNodes.push_back(nId);
                 }
-                else if(neigElem.type == MeshPyr::ELEMENT_TYPE)
+                else if(group != UNSET_GROUP)
                 {
-                    const MeshPyr& elem = pyrs[neigElem.id];
-                    for(size_t n=0; n < MeshPyr::VERTEX_COUNT; ++n)
-                    {
-                        int& group = groups[elem.v[n]];
-                        if(group == NO_GROUP)
-                        {
-                            group = UNSET_GROUP;
-                            nextNodes.push_back(elem.v[n]);
-                        }
-                        else if(group != UNSET_GROUP)
-                        {
-                            availableGroups.erase(group);
-                        }
-                    }
+                    stamps[group] = vId;
                 }
-                else if(neigElem.type == MeshPri::ELEMENT_TYPE)
-                {
-                    const MeshPri& elem = pris[neigElem.id];
-                    for(size_t n=0; n < MeshPri::VERTEX_COUNT; ++n)
-                    {
-                        int& group = groups[elem.v[n]];
-                        if(group == NO_GROUP)
-                        {
-                            group = UNSET_GROUP;
-                            nextNodes.push_back(elem.v[n]);
-                        }
-                        else if(group != UNSET_GROUP)
-                        {
-                            availableGroups.erase(group);
-                        }
-                    }
-                }
-                else if(neigElem.type == MeshHex::ELEMENT_TYPE)
-                {
-                    const MeshHex& elem = hexs[neigElem.id];
-                    for(size_t n=0; n < MeshHex::VERTEX_COUNT; ++n)
-                    {
-                        int& group = groups[elem.v[n]];
-                        if(group == NO_GROUP)
-                        {
-                            group = UNSET_GROUP;
-                            nextNodes.push_back(elem.v[n]);
-                        }
-                        else if(group != UNSET_GROUP)
-                        {
-                            availableGroups.erase(group);
-                        }
-                    }
-                }
-            }
+            });
 
-            int group;
-            if(availableGroups.empty())
-            {
-                group = existingGroups.size();
-                existingGroups.insert(group);
-            }
-            else
+            int group = 0;
+            while(group < groupCount && stamps[group] == int(vId))
+                ++group;
+
+            if(group == groupCount)
             {
-                group = *availableGroups.begin();
+                ++groupCount;
+                stamps.push_back(-1);
             }
 
             groups[vId] = group;
@@ -361,47 +489,301 @@ void NodeGroups::determineGroups(const Mesh& mesh, std::vector<int>& groups)
     }
 }
 
-void NodeGroups::determinePositions(Mesh& mesh,
-        const std::vector<int> &types,
-        const std::vector<int> &groups,
-        std::vector<int>& positions)
+void NodeGroups::determineGroupsPartitioned(
+        const Mesh& mesh,
+        std::vector<int>& groups)
 {
-    const auto& topos = mesh.topos;
+    // Nodes are cut in fixed blocks of consecutive ids. Nodes whose
+    // patch straddles blocks are colored first, in a serial fashion.
+    // The remaining nodes can't be adjacent to another block's nodes :
+    // blocks are then colored in parallel, each one in a first-fit
+    // fashion around the already colored straddling nodes.
+    // Blocks don't depend on the thread count, neither does the result.
+    // Space filling curve numbering keeps straddling nodes few.
     size_t vertCount = mesh.verts.size();
+    groups = std::vector<int> (vertCount, NO_GROUP);
 
-    //////////////////
-    // Build ranges //
-    //////////////////
-    for(size_t vId=0; vId < vertCount; ++vId)
+    size_t blockCount = (vertCount + COLORING_BLOCK_SIZE - 1) / COLORING_BLOCK_SIZE;
+    auto blockOf = [](size_t vId) { return vId / COLORING_BLOCK_SIZE; };
+
+    std::vector<char> straddles(vertCount, 0);
+    getThreadPool().parallelFor(blockCount, [&](size_t b){
+        size_t beg = b * COLORING_BLOCK_SIZE;
+        size_t end = glm::min(beg + COLORING_BLOCK_SIZE, vertCount);
+        for(size_t vId = beg; vId < end; ++vId)
+        {
+            forEachPatchNode(mesh, vId, [&](uint nId){
+                if(blockOf(nId) != b) straddles[vId] = 1;
+            });
+        }
+    });
+
+    std::vector<int> stamps;
+    for(size_t vId = 0; vId < vertCount; ++vId)
     {
-        if(types[vId] == FIXED_TYPE)
+        if(straddles[vId])
         {
-            ++_fixedNodes.end;
+            groups[vId] = firstFitGroup(mesh, vId, stamps,
+                [&](uint nId){ return groups[nId]; });
         }
-        else  if(types[vId] == BOUND_TYPE)
+    }
+
+    getThreadPool().parallelFor(blockCount, [&](size_t b){
+        size_t beg = b * COLORING_BLOCK_SIZE;
+        size_t end = glm::min(beg + COLORING_BLOCK_SIZE, vertCount);
+
+        std::vector<int> stamps;
+        for(size_t vId = beg; vId < end; ++vId)
         {
-            ++_boundaryNodes.end;
+            if(!straddles[vId])
+            {
+                groups[vId] = firstFitGroup(mesh, vId, stamps,
+                    [&](uint nId){ return groups[nId]; });
+            }
         }
-        else  if(types[vId] == SUBSU_TYPE)
+    });
+}
+
+void NodeGroups::balanceGroups(
+        const Mesh& mesh,
+        const std::vector<int>& types,
+        std::vector<int>& groups)
+{
+    // Fixed nodes never move : they don't need a group of their own
+    // and don't prevent their neighbors from sharing a group.
+    size_t vertCount = mesh.verts.size();
+    auto movableGroup = [&](const std::vector<int>& g, uint nId) {
+        return types[nId] != FIXED_TYPE ? g[nId] : NO_GROUP; };
+
+    auto countGroups = [&]() {
+        int groupCount = 0;
+        for(size_t vId = 0; vId < vertCount; ++vId)
+            if(types[vId] != FIXED_TYPE)
+                groupCount = glm::max(groupCount, groups[vId]+1);
+        return groupCount;
+    };
+
+
+    ///////////////////////////
+    // Group count reduction //
+    ///////////////////////////
+    // Iterated greedy : nodes are colored anew one group at a time,
+    // from the last group to the first. This never adds groups, tends
+    // to empty the tail groups and any group's nodes are independent,
+    // which lets us recolor each group in parallel.
+    for(int it=0; it < BALANCING_ITERATIONS; ++it)
+    {
+        int groupCount = countGroups();
+
+        std::vector<std::vector<uint>> members(groupCount);
+        for(size_t vId = 0; vId < vertCount; ++vId)
+            if(types[vId] != FIXED_TYPE)
+                members[groups[vId]].push_back(vId);
+
+        std::vector<int> recolored(groups);
+        for(size_t vId = 0; vId < vertCount; ++vId)
+            if(types[vId] != FIXED_TYPE)
+                recolored[vId] = NO_GROUP;
+
+        for(int g = groupCount-1; g >= 0; --g)
         {
-            ++_subsurfaceNodes.end;
+            const std::vector<uint>& nodes = members[g];
+            size_t nodeCount = nodes.size();
+            size_t taskCount = (nodeCount + MIN_CHUNK_SIZE*64 - 1) / (MIN_CHUNK_SIZE*64);
+
+            getThreadPool().parallelFor(taskCount, [&](size_t t){
+                size_t beg = (nodeCount * t) / taskCount;
+                size_t end = (nodeCount * (t+1)) / taskCount;
+
+                std::vector<int> stamps;
+                for(size_t n = beg; n < end; ++n)
+                {
+                    recolored[nodes[n]] = firstFitGroup(mesh, nodes[n], stamps,
+                        [&](uint nId){ return movableGroup(recolored, nId); });
+                }
+            });
         }
-        else  if(types[vId] == INTER_TYPE)
+
+        groups.swap(recolored);
+    }
+
+
+    ///////////////////////
+    // Size equalization //
+    ///////////////////////
+    // Nodes of oversized groups move to the smallest
+    // undersized group none of their neighbors belong to.
+    int groupCount = countGroups();
+    if(groupCount == 0)
+        return;
+
+    size_t movableCount = 0;
+    std::vector<size_t> sizes(groupCount, 0);
+    for(size_t vId = 0; vId < vertCount; ++vId)
+    {
+        if(types[vId] != FIXED_TYPE)
         {
-            ++_interiorNodes.end;
+            ++sizes[groups[vId]];
+            ++movableCount;
         }
     }
 
-    _boundaryNodes.begin += _fixedNodes.end;
-    _boundaryNodes.end += _fixedNodes.end;
+    size_t targetSize = (movableCount + groupCount - 1) / groupCount;
 
-    _subsurfaceNodes.begin += _boundaryNodes.end;
-    _subsurfaceNodes.end += _boundaryNodes.end;
+    std::vector<int> stamps(groupCount, -1);
+    for(size_t vId = 0; vId < vertCount; ++vId)
+    {
+        if(types[vId] == FIXED_TYPE || sizes[groups[vId]] <= targetSize)
+            continue;
 
-    _interiorNodes.begin += _subsurfaceNodes.end;
-    _interiorNodes.end += _subsurfaceNodes.end;
+        forEachPatchNode(mesh, vId, [&](uint nId){
+            int group = movableGroup(groups, nId);
+            if(group >= 0) stamps[group] = vId;
+        });
 
-    assert(_interiorNodes.end == vertCount);
+        int best = -1;
+        for(int g=0; g < groupCount; ++g)
+        {
+            if(sizes[g] < targetSize && stamps[g] != int(vId) &&
+               (best < 0 || sizes[g] < sizes[best]))
+                best = g;
+        }
+
+        if(best >= 0)
+        {
+            --sizes[groups[vId]];
+            ++sizes[best];
+            groups[vId] = best;
+        }
+    }
+}
+
+void NodeGroups::retypeNodes(
+        const Mesh& mesh,
+        const std::vector<uint>& dirtyNodes,
+        std::vector<int>& types,
+        std::vector<bool>& movedNodes)
+{
+    // A node's type only depends on its own constraint and on the
+    // constraints of its patch's nodes : dirty nodes and their
+    // patch's nodes are the only ones that may change type.
+    size_t vertCount = mesh.verts.size();
+    movedNodes.assign(vertCount, false);
+
+    std::vector<bool> visited(vertCount, false);
+    auto retype = [&](uint nId) {
+        if(visited[nId])
+            return;
+        visited[nId] = true;
+
+        int type;
+        const MeshTopo& topo = mesh.topos[nId];
+        if(topo.snapToBoundary->isFixed())
+        {
+            type = FIXED_TYPE;
+        }
+        else if(topo.snapToBoundary->isConstrained())
+        {
+            type = BOUND_TYPE;
+        }
+        else
+        {
+            bool isSubsurface = false;
+            forEachPatchNode(mesh, nId, [&](uint pId){
+                if(isMovableBound(mesh.topos[pId]))
+                    isSubsurface = true;
+            });
+
+            type = isSubsurface ? SUBSU_TYPE : INTER_TYPE;
+        }
+
+        if(types[nId] != type)
+        {
+            types[nId] = type;
+            movedNodes[nId] = true;
+        }
+    };
+
+    for(uint vId : dirtyNodes)
+    {
+        movedNodes[vId] = true;
+
+        retype(vId);
+        forEachPatchNode(mesh, vId, retype);
+    }
+}
+
+void NodeGroups::regroupNodes(
+        const Mesh& mesh,
+        const std::vector<uint>& dirtyNodes,
+        const std::vector<int>& types,
+        std::vector<int>& groups)
+{
+    // Only elements of dirty nodes were created : two clean neighbors
+    // still share the groups they had when the groups were valid.
+    // Dirty nodes keep their group unless a movable neighbor has it.
+    auto movableGroup = [&](uint nId) {
+        return types[nId] != FIXED_TYPE ? groups[nId] : NO_GROUP; };
+
+    std::vector<int> stamps;
+    for(uint vId : dirtyNodes)
+    {
+        if(types[vId] == FIXED_TYPE)
+            continue;
+
+        int group = groups[vId];
+        bool isFree = group >= 0;
+        if(isFree)
+        {
+            forEachPatchNode(mesh, vId, [&](uint nId){
+                if(nId != vId && movableGroup(nId) == group)
+                    isFree = false;
+            });
+        }
+
+        if(!isFree)
+        {
+            groups[vId] = UNSET_GROUP;
+            groups[vId] = firstFitGroup(mesh, vId, stamps, movableGroup);
+        }
+    }
+
+
+    // Drop groups left without movable nodes
+    size_t vertCount = mesh.verts.size();
+
+    int groupCount = 0;
+    for(size_t vId=0; vId < vertCount; ++vId)
+        if(types[vId] != FIXED_TYPE)
+            groupCount = glm::max(groupCount, groups[vId]+1);
+
+    std::vector<int> remap(groupCount, NO_GROUP);
+    for(size_t vId=0; vId < vertCount; ++vId)
+        if(types[vId] != FIXED_TYPE)
+            remap[groups[vId]] = 0;
+
+    int nextGroup = 0;
+    for(int& g : remap)
+        if(g != NO_GROUP)
+            g = nextGroup++;
+
+    for(size_t vId=0; vId < vertCount; ++vId)
+    {
+        if(types[vId] != FIXED_TYPE)
+            groups[vId] = remap[groups[vId]];
+        else
+            groups[vId] = NO_GROUP;
+    }
+}
+
+void NodeGroups::determinePositions(Mesh& mesh,
+        const std::vector<int> &types,
+        const std::vector<int> &groups,
+        std::vector<int>& positions)
+{
+    size_t vertCount = mesh.verts.size();
+
+    determineRanges(types);
 
 
     //////////////////////
@@ -409,7 +791,10 @@ void NodeGroups::determinePositions(Mesh& mesh,
     //////////////////////
     std::vector<int> indices(vertCount);
     std::iota(indices.begin(), indices.end(), 0);
-    std::sort(indices.begin(), indices.end(), [&] (int a, int b) {
+
+    // Stable sort keeps incoming (e.g. space filling curve)
+    // order among nodes with the same type, group and degree
+    std::stable_sort(indices.begin(), indices.end(), [&] (int a, int b) {
         if(types[a] == types[b])
         {
             if(types[a] == FIXED_TYPE)
@@ -421,15 +806,14 @@ void NodeGroups::determinePositions(Mesh& mesh,
                 if(groups[a] == groups[b])
                 {
                     // Inside type-group sets, nodes are sorted by their
-                    // number of neighbor elements. This enables us to balance
-                    // CPU and GPU dispatches. CPU dispatches needs a uniform
-                    // distribution of neighborhood sizes. GPU dispatches prefer
-                    // workgroups(blocks) with of nodes with equal number of neighbors
+                    // number of neighbor elements. GPU dispatches prefer
+                    // workgroups(blocks) with of nodes with equal number of neighbors.
+                    // CPU chunks are claimed dynamically and don't depend on it.
 
                     // See dispatchCpuWorkgroups() and dispatchGpuWorkgroups()
                     // to know how dispatches are built based on this sorting
-                    return topos[a].neighborElems.size() <
-                            topos[b].neighborElems.size();
+                    return mesh.neighborElems(a).size() <
+                            mesh.neighborElems(b).size();
                 }
                 else
                 {
@@ -448,6 +832,116 @@ void NodeGroups::determinePositions(Mesh& mesh,
         positions[indices[vId]] = vId;
 }
 
+void NodeGroups::determineRanges(const std::vector<int>& types)
+{
+    size_t vertCount = types.size();
+
+    //////////////////
+    // Build ranges //
+    //////////////////
+    for(size_t vId=0; vId < vertCount; ++vId)
+    {
+        if(types[vId] == FIXED_TYPE)
+        {
+            ++_fixedNodes.end;
+        }
+        else  if(types[vId] == BOUND_TYPE)
+        {
+            ++_boundaryNodes.end;
+        }
+        else  if(types[vId] == SUBSU_TYPE)
+        {
+            ++_subsurfaceNodes.end;
+        }
+        else  if(types[vId] == INTER_TYPE)
+        {
+            ++_interiorNodes.end;
+        }
+    }
+
+    _boundaryNodes.begin += _fixedNodes.end;
+    _boundaryNodes.end += _fixedNodes.end;
+
+    _subsurfaceNodes.begin += _boundaryNodes.end;
+    _subsurfaceNodes.end += _boundaryNodes.end;
+
+    _interiorNodes.begin += _subsurfaceNodes.end;
+    _interiorNodes.end += _subsurfaceNodes.end;
+
+    assert(_interiorNodes.end == vertCount);
+}
+
+void NodeGroups::repositionNodes(
+        const Mesh& mesh,
+        const std::vector<int>& types,
+        const std::vector<int>& groups,
+        const std::vector<bool>& movedNodes,
+        std::vector<int>& positions)
+{
+    size_t vertCount = mesh.verts.size();
+
+    determineRanges(types);
+
+
+    // Nodes that didn't move are still sorted by type, group and number
+    // of neighbor elements relative to one another. They keep their order
+    // and moved nodes are merged in their type-group set. This replaces
+    // the global sort of determinePositions() by a linear pass.
+    int groupCount = 0;
+    for(size_t vId=0; vId < vertCount; ++vId)
+        if(types[vId] != FIXED_TYPE)
+            groupCount = glm::max(groupCount, groups[vId]+1);
+
+    auto setOf = [&](size_t vId) -> size_t {
+        if(types[vId] == FIXED_TYPE)
+            return 0;
+        return 1 + size_t(types[vId] - BOUND_TYPE) * groupCount + groups[vId];
+    };
+
+    size_t setCount = 1 + size_t(INTER_TYPE - BOUND_TYPE + 1) * groupCount;
+    std::vector<std::vector<uint>> stayingSets(setCount);
+    std::vector<std::vector<uint>> movedSets(setCount);
+    for(size_t vId=0; vId < vertCount; ++vId)
+    {
+        if(movedNodes[vId])
+            movedSets[setOf(vId)].push_back(vId);
+        else
+            stayingSets[setOf(vId)].push_back(vId);
+    }
+
+    auto byNeighborCount = [&](uint a, uint b) {
+        return mesh.neighborElems(a).size() <
+                mesh.neighborElems(b).size();
+    };
+
+    std::vector<uint> indices;
+    indices.reserve(vertCount);
+    for(size_t s=0; s < setCount; ++s)
+    {
+        const std::vector<uint>& staying = stayingSets[s];
+        std::vector<uint>& moved = movedSets[s];
+
+        if(s == 0)
+        {
+            // Fixed nodes are not sorted
+            indices.insert(indices.end(), staying.begin(), staying.end());
+            indices.insert(indices.end(), moved.begin(), moved.end());
+        }
+        else
+        {
+            std::stable_sort(moved.begin(), moved.end(), byNeighborCount);
+            std::merge(staying.begin(), staying.end(),
+                       moved.begin(), moved.end(),
+                       std::back_inserter(indices),
+                       byNeighborCount);
+        }
+    }
+
+    positions.resize(vertCount);
+    for(size_t vId=0; vId < vertCount; ++vId)
+        positions[indices[vId]] = vId;
+}
+
 void NodeGroups::clusterNodes(Mesh& mesh,
         std::vector<int>& types,
         std::vector<int>& groups,
@@ -500,11 +994,7 @@ void NodeGroups::clusterNodes(Mesh& mesh,
         hex.v[7] = positions[hex.v[7]];
     }
 
-    for(MeshTopo& topo : topos)
-    {
-        for(MeshNeigVert& vN : topo.neighborVerts)
-            vN.v = positions[vN.v];
-    }
+    mesh.permuteNeighborhoods(positions);
 
 
 
@@ -621,40 +1111,33 @@ void NodeGroups::dispatchCpuWorkgroups()
 {
     for(ParallelGroup& group : _parallelGroups)
     {
-        group.allDispatchedNodes.clear();
-        group.allDispatchedNodes.resize(_cpuWorkerCount);
-        size_t allGroupSize = group.undispatchedNodes.size();
-        size_t maxDispatchSize = glm::ceil(double(allGroupSize) / _cpuWorkerCount);
-        for(size_t w=0; w < _cpuWorkerCount; ++w)
-        {
-            // !!! for( [...] ; v += _cpuWorkerCount)
-            // Nodes are sorted according to their number of neighbor elements
-            // This distribution pattern makes sure CPU dispatches are well balanced
-
-            group.allDispatchedNodes[w].reserve(maxDispatchSize);
-            for(size_t v = w; v < allGroupSize; v += _cpuWorkerCount)
-            {
-                group.allDispatchedNodes[w].push_back(
-                    group.undispatchedNodes[v]);
-            }
-        }
+        chunkNodes(group.undispatchedNodes,
+                   group.undispatchedNodes.size(),
+                   group.allNodeChunks);
     }
+}
 
-
-//    for(size_t w=0; w < _cpuWorkerCount; ++w)
-//    {
-//        std::cout << w+1;
-//        for(ParallelGroup& group : _parallelGroups)
-//            std::cout << " & " << group.allDispatchedNodes[w].size();
-//        std::cout << " \\\\" << std::endl;
-//    }
-
-
-//    std::cout << std::endl << std::endl;
-//    const ParallelGroup& group = _parallelGroups[7];
-//    int vCount = group.allDispatchedNodes[2].size();
-//    for(int v = 0; v < std::min(vCount, 8); ++v)
-//        std::cout << group.allDispatchedNodes[2][v] << " & ";
+void NodeGroups::chunkNodes(
+        const std::vector<uint>& nodes,
+        size_t nodeCount,
+        std::vector<std::vector<uint>>& chunks) const
+{
+    // Workers claim chunks dynamically, so a worker slowed down by
+    // expensive nodes (e.g. mixed element types, long Nelder-Mead
+    // searches) no longer holds the others at the group barrier.
+    // Several chunks per worker leave room to even out the load while
+    // keeping each chunk's nodes contiguous in the vertex buffer.
+    size_t chunkSize = glm::max(MIN_CHUNK_SIZE, size_t(glm::ceil(
+        double(nodeCount) / (_cpuWorkerCount * CHUNKS_PER_WORKER))));
+
+    chunks.clear();
+    chunks.reserve((nodeCount + chunkSize - 1) / chunkSize);
+    for(size_t c = 0; c < nodeCount; c += chunkSize)
+    {
+        size_t end = glm::min(c + chunkSize, nodeCount);
+        chunks.push_back(std::vector<uint>(
+            nodes.begin() + c, nodes.begin() + end));
+    }
 }
 
 void NodeGroups::dispatchGpuWorkgroups()
@@ -663,9 +1146,6 @@ void NodeGroups::dispatchGpuWorkgroups()
     {
         _gpuDispatcher(group.gpuDispatch);
 
-        group.cpuOnlyDispatchedNodes.clear();
-        group.cpuOnlyDispatchedNodes.resize(_cpuWorkerCount);
-
         size_t cpuGroupSize = group.boundaryRange.end -
                 group.boundaryRange.begin;
 
@@ -674,20 +1154,9 @@ void NodeGroups::dispatchGpuWorkgroups()
             cpuGroupSize = group.undispatchedNodes.size();
         }
 
-        size_t maxDispatchSize = glm::ceil(double(cpuGroupSize) / _cpuWorkerCount);
-        for(size_t w=0; w < _cpuWorkerCount; ++w)
-        {
-            // !!! for( [...] ; v += _cpuWorkerCount)
-            // Nodes are sorted according to their number of neighbor elements
-            // This distribution pattern makes sure CPU dispatches are well balanced
-
-            group.cpuOnlyDispatchedNodes[w].reserve(maxDispatchSize);
-            for(size_t v = w; v < cpuGroupSize; v += _cpuWorkerCount)
-            {
-                group.cpuOnlyDispatchedNodes[w].push_back(
-                    group.undispatchedNodes[v]);
-            }
-        }
+        chunkNodes(group.undispatchedNodes,
+                   cpuGroupSize,
+                   group.cpuOnlyNodeChunks);
     }
 }
 
@@ -16,6 +16,22 @@ class Mesh;
 class MeshTopo;
 
 
+// Independent groups coloring algorithms. Serial is the default : the
+// partitioned coloring yields about twice as many groups, and every
+// smoothing pass synchronizes (or dispatches on GPU) once per group,
+// while coloring only runs when the topology is compiled. Partitioned
+// pays off on large meshes whose topology is compiled often.
+enum class EGroupColoring
+{
+    // Greedy first-fit coloring in breadth-first order
+    Serial,
+
+    // Parallel first-fit coloring of blocks of consecutive
+    // nodes, then serial coloring of nodes between blocks
+    Partitioned
+};
+
+
 /// The layout of the vertex buffer is as follows :
 ///      FixedX : Xth node of the fixed nodes group
 ///      IndX_BoundY : Yth boundary node of the Xth independent group
@@ -83,13 +99,14 @@ public:
         // Nodes' patches of this vector never overlapse
         std::vector<uint> undispatchedNodes;
 
-        // Parallel group's nodes are dispatched according
-        // to the number of requested threads
-        std::vector<std::vector<uint>> allDispatchedNodes;
+        // Parallel group's nodes are cut in chunks sized according
+        // to the number of requested threads. Threads claim chunks
+        // one at a time until the group is exhausted.
+        std::vector<std::vector<uint>> allNodeChunks;
 
-        // Parallel group's boundary nodes are dispatched
-        // according to the number of requested threads
-        std::vector<std::vector<uint>> cpuOnlyDispatchedNodes;
+        // Parallel group's boundary nodes are cut in chunks
+        // sized according to the number of requested threads
+        std::vector<std::vector<uint>> cpuOnlyNodeChunks;
     };
 
     size_t count();
@@ -97,6 +114,13 @@ public:
     size_t cpuWorkerCount() const;
     void setCpuWorkerCount(size_t workerCount);
 
+    EGroupColoring coloring() const;
+    void setColoring(EGroupColoring coloring);
+
+    // Reduces the group count and evens out group sizes after coloring
+    bool balancing() const;
+    void setBalancing(bool enabled);
+
     typedef std::function<void(GpuDispatch&)> GpuDispatcher;
     void setGpuDispatcher(const GpuDispatcher& dispatcher);
 
@@ -115,6 +139,16 @@ public:
 
     void build(Mesh& mesh);
 
+    // Topology editors mark the nodes whose patch or constraint changed
+    // and report vertex buffer compactions so that update() only has to
+    // retype, regroup and reposition the affected region.
+    void markDirty(uint vId);
+    void eraseNodes(const std::vector<bool>& aliveNodes);
+
+    // Falls back on build() when groups were never built
+    // or when too large a fraction of the nodes is dirty.
+    void update(Mesh& mesh);
+
 
 private:
 
@@ -127,6 +161,12 @@ private:
     static const int SUBSU_TYPE;
     static const int INTER_TYPE;
 
+    static const size_t CHUNKS_PER_WORKER;
+    static const size_t MIN_CHUNK_SIZE;
+    static const size_t COLORING_BLOCK_SIZE;
+    static const int BALANCING_ITERATIONS;
+    static const double UPDATE_MAX_DIRTY_RATIO;
+
 
     /// @brief Independent vertex groups compilation
     /// Compiles independent vertex groups that is used by parallel smoothing
@@ -140,10 +180,29 @@ private:
     /// number of vertices and _d_ is the 'mean' vertex degree.
     void determineTypes(const Mesh& mesh, std::vector<int>& types);
     void determineGroups(const Mesh& mesh, std::vector<int>& groups);    
+    void determineGroupsPartitioned(const Mesh& mesh, std::vector<int>& groups);
+    void balanceGroups(const Mesh& mesh,
+            const std::vector<int>& types,
+            std::vector<int>& groups);
     void determinePositions(Mesh& mesh,
             const std::vector<int> &types,
             const std::vector<int> &groups,
             std::vector<int> &positions);
+    void determineRanges(const std::vector<int>& types);
+
+    void retypeNodes(const Mesh& mesh,
+            const std::vector<uint>& dirtyNodes,
+            std::vector<int>& types,
+            std::vector<bool>& movedNodes);
+    void regroupNodes(const Mesh& mesh,
+            const std::vector<uint>& dirtyNodes,
+            const std::vector<int>& types,
+            std::vector<int>& groups);
+    void repositionNodes(const Mesh& mesh,
+            const std::vector<int>& types,
+            const std::vector<int>& groups,
+            const std::vector<bool>& movedNodes,
+            std::vector<int>& positions);
 
     void clusterNodes(Mesh& mesh,
             std::vector<int> &types,
@@ -152,6 +211,11 @@ private:
 
     void dispatchCpuWorkgroups();
 
+    void chunkNodes(
+            const std::vector<uint>& nodes,
+            size_t nodeCount,
+            std::vector<std::vector<uint>>& chunks) const;
+
     void dispatchGpuWorkgroups();
 
     static bool isMovableBound(const MeshTopo& topo);
@@ -159,6 +223,8 @@ private:
 
     size_t _cpuWorkerCount;
     GpuDispatcher _gpuDispatcher;
+    EGroupColoring _coloring;
+    bool _balancing;
 
     // Fixed nodes are uploaded once and
     // never moved across smoothing passes
@@ -190,6 +256,13 @@ private:
     // All the independent patch that can be processed
     // individually in a parallel fashion, on the GPU and CPU
     std::vector<ParallelGroup> _parallelGroups;
+
+
+    // Type and group of each node as of the last build() or update(),
+    // in vertex buffer order. Empty until groups are built.
+    std::vector<int> _nodeTypes;
+    std::vector<int> _nodeGroupIds;
+    std::vector<bool> _dirtyNodes;
 };
 
 
@@ -200,6 +273,16 @@ inline size_t NodeGroups::cpuWorkerCount() const
     return _cpuWorkerCount;
 }
 
+inline EGroupColoring NodeGroups::coloring() const
+{
+    return _coloring;
+}
+
+inline bool NodeGroups::balancing() const
+{
+    return _balancing;
+}
+
 inline size_t NodeGroups::count()
 {
     return _parallelGroups.size();
@@ -1,5 +1,8 @@
 #include "OptimizationPlot.h"
 
+#include <cmath>
+#include <algorithm>
+
 
 void OptimizationImpl::addSmoothingProperty(const std::string& name, const std::string& value)
 {
@@ -25,6 +28,40 @@ void OptimizationPlot::setMeshModelName(const std::string& name)
 void OptimizationPlot::setNodeGroups(const NodeGroups& groups)
 {
     _nodeGroups = groups;
+
+    const std::vector<NodeGroups::ParallelGroup>& parallelGroups =
+            groups.parallelGroups();
+
+    size_t groupCount = parallelGroups.size();
+    if(groupCount == 0)
+        return;
+
+    size_t minSize = parallelGroups.front().undispatchedNodes.size();
+    size_t maxSize = minSize;
+    size_t nodeCount = 0;
+    for(const NodeGroups::ParallelGroup& group : parallelGroups)
+    {
+        size_t size = group.undispatchedNodes.size();
+        minSize = std::min(minSize, size);
+        maxSize = std::max(maxSize, size);
+        nodeCount += size;
+    }
+
+    double meanSize = double(nodeCount) / groupCount;
+
+    double sizeVariance = 0.0;
+    for(const NodeGroups::ParallelGroup& group : parallelGroups)
+    {
+        double dev = group.undispatchedNodes.size() - meanSize;
+        sizeVariance += dev * dev;
+    }
+    sizeVariance /= groupCount;
+
+    addMeshProperty("Group Size Min",     std::to_string(minSize));
+    addMeshProperty("Group Size Mean",    std::to_string(meanSize));
+    addMeshProperty("Group Size Max",     std::to_string(maxSize));
+    addMeshProperty("Group Size Std Dev", std::to_string(std::sqrt(sizeVariance)));
+    addMeshProperty("Group Imbalance",    std::to_string(maxSize / meanSize));
 }
 
 void OptimizationPlot::addMeshProperty(const std::string& name, const std::string& value)
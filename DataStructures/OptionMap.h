@@ -30,6 +30,8 @@ public:
 
     void setContent(const Content& contentMap);
 
+    void addOption(const std::string& key, const V& value);
+
     bool select(const std::string& key, V& value) const;
 
     OptionMapDetails details() const;
@@ -75,6 +77,12 @@ void OptionMap<V>::setContent(const Content& contentMap)
     _content = contentMap;
 }
 
+template<typename V>
+void OptionMap<V>::addOption(const std::string& key, const V& value)
+{
+    _content[key] = value;
+}
+
 template<typename V>
 bool OptionMap<V>::select(const std::string& key, V& value) const
 {
@@ -0,0 +1,162 @@
+#include "QualityCache.h"
+
+#include <algorithm>
+
+#include "Mesh.h"
+
+
+QualityCache::QualityCache() :
+    _isEnabled(false),
+    _hasHistogram(false)
+{
+
+}
+
+QualityCache::~QualityCache()
+{
+
+}
+
+void QualityCache::enable(const Mesh& mesh)
+{
+    _isEnabled = true;
+    invalidate(mesh);
+}
+
+void QualityCache::disable()
+{
+    _isEnabled = false;
+
+    for(int t=0; t < ELEMENT_TYPE_COUNT; ++t)
+    {
+        _qualities[t].clear();
+        _qualities[t].shrink_to_fit();
+    }
+
+    _movedVerts.clear();
+    _movedVerts.shrink_to_fit();
+
+    _hasHistogram = false;
+    _minTree.clear();
+    _minTree.shrink_to_fit();
+}
+
+void QualityCache::invalidate(const Mesh& mesh)
+{
+    if(!_isEnabled)
+        return;
+
+    _qualities[MeshTet::ELEMENT_TYPE].assign(mesh.tets.size(), NAN);
+    _qualities[MeshPyr::ELEMENT_TYPE].assign(mesh.pyrs.size(), NAN);
+    _qualities[MeshPri::ELEMENT_TYPE].assign(mesh.pris.size(), NAN);
+    _qualities[MeshHex::ELEMENT_TYPE].assign(mesh.hexs.size(), NAN);
+    _movedVerts.assign(mesh.verts.size(), 0);
+
+    _hasHistogram = false;
+    _minTree.clear();
+}
+
+void QualityCache::commitMoves()
+{
+    std::fill(_movedVerts.begin(), _movedVerts.end(), 0);
+}
+
+void QualityCache::buildHistogram(std::size_t bucketCount)
+{
+    _histogram = QualityHistogram(bucketCount);
+
+    size_t leafCount = 0;
+    for(int t=0; t < ELEMENT_TYPE_COUNT; ++t)
+    {
+        _leafBases[t] = leafCount;
+        leafCount += _qualities[t].size();
+    }
+
+    _minTree.assign(2 * leafCount, INFINITY);
+
+    // Pyramids aren't evaluated : they stay out of the histogram
+    for(int t=0; t < ELEMENT_TYPE_COUNT; ++t)
+    {
+        if(t == MeshPyr::ELEMENT_TYPE)
+            continue;
+
+        const std::vector<double>& qualities = _qualities[t];
+        size_t elemCount = qualities.size();
+        for(size_t e=0; e < elemCount; ++e)
+        {
+            if(std::isnan(qualities[e]))
+                continue;
+
+            _histogram.add(qualities[e]);
+            _minTree[leafCount + _leafBases[t] + e] = qualities[e];
+        }
+    }
+
+    for(size_t n=leafCount; n > 1; --n)
+        _minTree[n-1] = std::min(_minTree[2*n-2], _minTree[2*n-1]);
+
+    _hasHistogram = true;
+}
+
+void QualityCache::collectDirtyElements(
+        const Mesh& mesh,
+        std::vector<MeshNeigElem>& elems) const
+{
+    elems.clear();
+
+    size_t vertCount = _movedVerts.size();
+    for(size_t v=0; v < vertCount; ++v)
+    {
+        if(!_movedVerts[v])
+            continue;
+
+        for(const MeshNeigElem& n : mesh.neighborElems(v))
+        {
+            if(n.type != MeshPyr::ELEMENT_TYPE)
+                elems.push_back(n);
+        }
+    }
+
+    std::sort(elems.begin(), elems.end(),
+        [](const MeshNeigElem& a, const MeshNeigElem& b) {
+            return a.type < b.type || (a.type == b.type && a.id < b.id);
+    });
+
+    elems.erase(std::unique(elems.begin(), elems.end(),
+        [](const MeshNeigElem& a, const MeshNeigElem& b) {
+            return a.type == b.type && a.id == b.id;
+    }), elems.end());
+}
+
+void QualityCache::update(const MeshNeigElem& elem, double quality)
+{
+    double& cached = _qualities[elem.type][elem.id];
+
+    if(_hasHistogram)
+    {
+        if(!std::isnan(cached))
+            _histogram.remove(cached);
+
+        if(!std::isnan(quality))
+            _histogram.add(quality);
+
+        updateMinimum(_leafBases[elem.type] + elem.id,
+            std::isnan(quality) ? INFINITY : quality);
+
+        _histogram.setMinimumQuality(std::min(1.0, _minTree[1]));
+    }
+
+    cached = quality;
+}
+
+void QualityCache::updateMinimum(size_t leaf, double quality)
+{
+    size_t n = _minTree.size() / 2 + leaf;
+    _minTree[n] = quality;
+
+    while(n > 1)
+    {
+        n /= 2;
+        _minTree[n] = std::min(_minTree[2*n], _minTree[2*n+1]);
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef GPUMESH_QUALITYCACHE
+#define GPUMESH_QUALITYCACHE
+
+#include <cmath>
+#include <vector>
+
+#include "QualityHistogram.h"
+
+#ifndef uint
+typedef unsigned int uint;
+#endif // uint
+
+class Mesh;
+struct MeshNeigElem;
+
+
+/// Element qualities kept between full mesh evaluations.
+///
+/// Full evaluations store the quality of every element they compute and
+/// patch evaluations read them back. Smoothers flag the vertices they move
+/// so that their incident elements read as dirty until the next full
+/// evaluation stores them again and commits the moves.
+///
+/// Once built, the histogram of the cached qualities is maintained as
+/// dirty elements are updated : its buckets and inverse quality sum are
+/// patched and its minimum is read from a tournament tree over elements.
+///
+/// The cache is only enabled for the duration of a CPU smoothing run, where
+/// every vertex move goes through the smoothers. Positions must not be
+/// modified otherwise while it is enabled.
+class QualityCache
+{
+public:
+    QualityCache();
+    virtual ~QualityCache();
+
+
+    bool isEnabled() const;
+
+    // Sizes the cache after mesh's elements with every element dirty
+    virtual void enable(const Mesh& mesh);
+    virtual void disable();
+
+    // Forgets cached qualities, e.g. after topology modifications
+    virtual void invalidate(const Mesh& mesh);
+
+
+    // Vertex was moved : its incident elements are dirty until next
+    // commit. Distinct vertices may be moved concurrently. No-ops
+    // while the cache is disabled.
+    void moveVertex(uint vId);
+
+    // Qualities of dirty elements have all been stored
+    virtual void commitMoves();
+
+
+    // Quality stored for the element, NaN if it's dirty
+    template<typename Elem>
+    double quality(const Elem& elem, size_t eId) const;
+
+    template<typename Elem>
+    void store(size_t eId, double quality);
+
+
+    // Histogram of every cached quality, built once they are all stored
+    bool hasHistogram() const;
+    const QualityHistogram& histogram() const;
+    virtual void buildHistogram(std::size_t bucketCount);
+
+    // Incident elements of the vertices moved since last commit
+    virtual void collectDirtyElements(
+            const Mesh& mesh,
+            std::vector<MeshNeigElem>& elems) const;
+
+    // Replaces element's quality in the cache and in the histogram.
+    // Must not be called concurrently.
+    virtual void update(const MeshNeigElem& elem, double quality);
+
+
+private:
+    static const int ELEMENT_TYPE_COUNT = 4;
+
+    void updateMinimum(size_t leaf, double quality);
+
+    bool _isEnabled;
+    std::vector<double> _qualities[ELEMENT_TYPE_COUNT];
+
+    // Min tournament tree over all elements : leaves are in
+    // [leafCount, 2*leafCount) and parents of node n are n/2
+    bool _hasHistogram;
+    QualityHistogram _histogram;
+    size_t _leafBases[ELEMENT_TYPE_COUNT];
+    std::vector<double> _minTree;
+
+    // Bytes rather than packed bits for concurrent updates
+    std::vector<unsigned char> _movedVerts;
+};
+
+
+
+// IMPLEMENTATION //
+inline bool QualityCache::isEnabled() const
+{
+    return _isEnabled;
+}
+
+inline void QualityCache::moveVertex(uint vId)
+{
+    if(_isEnabled)
+        _movedVerts[vId] = 1;
+}
+
+inline bool QualityCache::hasHistogram() const
+{
+    return _hasHistogram;
+}
+
+inline const QualityHistogram& QualityCache::histogram() const
+{
+    return _histogram;
+}
+
+template<typename Elem>
+inline double QualityCache::quality(const Elem& elem, size_t eId) const
+{
+    for(uint v=0; v < Elem::VERTEX_COUNT; ++v)
+    {
+        if(_movedVerts[elem.v[v]])
+            return NAN;
+    }
+
+    return _qualities[Elem::ELEMENT_TYPE][eId];
+}
+
+template<typename Elem>
+inline void QualityCache::store(size_t eId, double quality)
+{
+    _qualities[Elem::ELEMENT_TYPE][eId] = quality;
+}
+
+#endif // GPUMESH_QUALITYCACHE
@@ -7,7 +7,8 @@ QualityHistogram::QualityHistogram() :
     _buckets(20, 0),
     _sampleCount(0),
     _minimumQuality(1.0),
-    _invQualitySum(0.0)
+    _invQualitySum(0.0),
+    _invalidCount(0)
 {
 
 }
@@ -16,7 +17,8 @@ QualityHistogram::QualityHistogram(std::size_t bucketCount) :
     _buckets(bucketCount, 0),
     _sampleCount(0),
     _minimumQuality(1.0),
-    _invQualitySum(0.0)
+    _invQualitySum(0.0),
+    _invalidCount(0)
 {
 
 }
@@ -31,6 +33,7 @@ void QualityHistogram::clear()
     _sampleCount = 0;
     _minimumQuality = 1.0;
     _invQualitySum = 0.0;
+    _invalidCount = 0;
     std::fill(_buckets.begin(), _buckets.end(), 0);
 }
 
@@ -68,11 +71,21 @@ void QualityHistogram::add(double value)
     if(value > 0.0)
         _invQualitySum += 1.0 / value;
     else
-        _invQualitySum = INFINITY;
+        ++_invalidCount;
 
-    size_t bucketCount = _buckets.size();
-    size_t b = glm::clamp(size_t(value * bucketCount), size_t(0), bucketCount-1);
-    _buckets[b] += 1;
+    _buckets[bucketIndex(value)] += 1;
+}
+
+void QualityHistogram::remove(double value)
+{
+    --_sampleCount;
+
+    if(value > 0.0)
+        _invQualitySum -= 1.0 / value;
+    else
+        --_invalidCount;
+
+    _buckets[bucketIndex(value)] -= 1;
 }
 
 void QualityHistogram::merge(const QualityHistogram& histogram)
@@ -85,6 +98,7 @@ void QualityHistogram::merge(const QualityHistogram& histogram)
     _sampleCount += histogram._sampleCount;
     _minimumQuality = glm::min(_minimumQuality, histogram._minimumQuality);
     _invQualitySum += histogram._invQualitySum;
+    _invalidCount += histogram._invalidCount;
 
     size_t bucketCount = _buckets.size();
     for(size_t i=0; i < bucketCount; ++i)
@@ -95,3 +109,9 @@ double QualityHistogram::computeGain(const QualityHistogram& reference) const
 {
     return harmonicMean() - reference.harmonicMean();
 }
+
+std::size_t QualityHistogram::bucketIndex(double value) const
+{
+    size_t bucketCount = _buckets.size();
+    return glm::clamp(size_t(value * bucketCount), size_t(0), bucketCount-1);
+}
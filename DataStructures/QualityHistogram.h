@@ -34,15 +34,26 @@ public:
 
     virtual void add(double value);
 
+    // Removes a value previously added. The minimum quality can't be
+    // recovered from the buckets : maintainers of a histogram that values
+    // are removed from must track it themselves and set it back.
+    virtual void remove(double value);
+
     virtual void merge(const QualityHistogram& histogram);
 
     virtual double computeGain(const QualityHistogram& reference) const;
 
 private:
+    std::size_t bucketIndex(double value) const;
+
     std::vector<int> _buckets;
     std::size_t _sampleCount;
     double _minimumQuality;
+
+    // Sum over positive qualities only, so that removing the
+    // last invalid element brings the harmonic mean back
     double _invQualitySum;
+    std::size_t _invalidCount;
 };
 
 
@@ -71,7 +82,7 @@ inline double QualityHistogram::minimumQuality() const
 
 inline double QualityHistogram::harmonicMean() const
 {
-    return sampleCount() / _invQualitySum;
+    return sampleCount() / (_invalidCount == 0 ? _invQualitySum : INFINITY);
 }
 
 #endif // GPUMESH_QUALITYHISTOGRAM
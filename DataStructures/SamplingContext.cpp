@@ -0,0 +1,66 @@
+#include "SamplingContext.h"
+
+#include <mutex>
+#include <algorithm>
+
+
+// Live contexts, summed when search stats are reported
+static std::mutex g_contextsMutex;
+static std::vector<SamplingContext*> g_contexts;
+
+
+SamplingContext::SearchStats::SearchStats() :
+    searchCount(0),
+    searchDepthSum(0),
+    maxSearchDepth(0),
+    overflowCount(0)
+{
+
+}
+
+SamplingContext::SamplingContext() :
+    _refTetRevision(0),
+    _refTet(0),
+    _searchRevision(0),
+    _searchCount(0),
+    _searchDepthSum(0),
+    _maxSearchDepth(0),
+    _overflowCount(0)
+{
+    std::lock_guard<std::mutex> lock(g_contextsMutex);
+    g_contexts.push_back(this);
+}
+
+SamplingContext::~SamplingContext()
+{
+    std::lock_guard<std::mutex> lock(g_contextsMutex);
+    g_contexts.erase(std::remove(g_contexts.begin(), g_contexts.end(), this),
+                     g_contexts.end());
+}
+
+SamplingContext& SamplingContext::local()
+{
+    thread_local SamplingContext context;
+    return context;
+}
+
+SamplingContext::SearchStats SamplingContext::searchStats(unsigned int revision)
+{
+    const std::memory_order relaxed = std::memory_order_relaxed;
+
+    SearchStats stats;
+    std::lock_guard<std::mutex> lock(g_contextsMutex);
+    for(const SamplingContext* context : g_contexts)
+    {
+        if(context->_searchRevision.load(std::memory_order_acquire) != revision)
+            continue;
+
+        stats.searchCount += context->_searchCount.load(relaxed);
+        stats.searchDepthSum += context->_searchDepthSum.load(relaxed);
+        stats.maxSearchDepth = std::max(stats.maxSearchDepth,
+            context->_maxSearchDepth.load(relaxed));
+        stats.overflowCount += context->_overflowCount.load(relaxed);
+    }
+
+    return stats;
+}
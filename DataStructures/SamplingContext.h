@@ -0,0 +1,133 @@
+#ifndef GPUMESH_SAMPLINGCONTEXT
+#define GPUMESH_SAMPLINGCONTEXT
+
+#include <atomic>
+#include <vector>
+
+#include <GLM/glm.hpp>
+
+#ifndef uint
+typedef unsigned int uint;
+#endif // uint
+
+
+/// Point location hints and scratch memory owned by a single thread.
+///
+/// Samplers and measurers reach the calling thread's context through
+/// SamplingContext::local(). What one query learns is kept there for the
+/// next queries of the same thread instead of being written back in mesh
+/// elements, which threads share. Element cache fields (MeshTet::c,
+/// MeshVert::c, ...) are only read as starting points.
+///
+/// Entries are tagged with the metric revision of the sampler that
+/// produced them and are ignored once that revision is outdated.
+class SamplingContext
+{
+public:
+    SamplingContext();
+    ~SamplingContext();
+
+    // Calling thread's context
+    static SamplingContext& local();
+
+
+    // Background mesh tet located by the last query of the thread
+    // on a sampler at the given metric revision
+    bool refTetHint(unsigned int revision, uint& refTet) const;
+    void setRefTetHint(unsigned int revision, uint refTet);
+
+
+    // Length of an edge, keyed on its endpoints
+    struct EdgeLength
+    {
+        glm::dvec3 a;
+        glm::dvec3 b;
+        unsigned int revision;
+        int pointCount;
+        double length;
+    };
+
+    // Scratch table of the edge lengths last measured by the thread.
+    // Empty until its user sizes it.
+    std::vector<EdgeLength>& edgeLengths();
+
+
+    // Point location walks, counted per thread on the sampler
+    // at the given metric revision. Counts restart on a new one.
+    struct SearchStats
+    {
+        SearchStats();
+
+        size_t searchCount;
+        size_t searchDepthSum;
+        int maxSearchDepth;
+        size_t overflowCount;
+    };
+
+    void recordSearch(unsigned int revision, int depth, bool isOverflow);
+
+    // Sums the walks of every live thread at the given revision
+    static SearchStats searchStats(unsigned int revision);
+
+
+private:
+    unsigned int _refTetRevision;
+    uint _refTet;
+
+    std::vector<EdgeLength> _edgeLengths;
+
+    // Only written by the owning thread
+    std::atomic<unsigned int> _searchRevision;
+    std::atomic<size_t> _searchCount;
+    std::atomic<size_t> _searchDepthSum;
+    std::atomic<int> _maxSearchDepth;
+    std::atomic<size_t> _overflowCount;
+};
+
+
+
+// IMPLEMENTATION //
+inline bool SamplingContext::refTetHint(unsigned int revision, uint& refTet) const
+{
+    if(_refTetRevision != revision)
+        return false;
+
+    refTet = _refTet;
+    return true;
+}
+
+inline void SamplingContext::setRefTetHint(unsigned int revision, uint refTet)
+{
+    _refTetRevision = revision;
+    _refTet = refTet;
+}
+
+inline std::vector<SamplingContext::EdgeLength>& SamplingContext::edgeLengths()
+{
+    return _edgeLengths;
+}
+
+inline void SamplingContext::recordSearch(
+        unsigned int revision, int depth, bool isOverflow)
+{
+    // Plain load/store pairs : no other thread writes these counters
+    const std::memory_order relaxed = std::memory_order_relaxed;
+
+    if(_searchRevision.load(relaxed) != revision)
+    {
+        _searchCount.store(0, relaxed);
+        _searchDepthSum.store(0, relaxed);
+        _maxSearchDepth.store(0, relaxed);
+        _overflowCount.store(0, relaxed);
+        _searchRevision.store(revision, std::memory_order_release);
+    }
+
+    _searchCount.store(_searchCount.load(relaxed) + 1, relaxed);
+    _searchDepthSum.store(_searchDepthSum.load(relaxed) + depth, relaxed);
+    if(depth > _maxSearchDepth.load(relaxed))
+        _maxSearchDepth.store(depth, relaxed);
+    if(isOverflow)
+        _overflowCount.store(_overflowCount.load(relaxed) + 1, relaxed);
+}
+
+#endif // GPUMESH_SAMPLINGCONTEXT
@@ -5,10 +5,14 @@ Schedule::Schedule() :
     autoPilotEnabled(false),
     minQualThreshold(0.001),
     qualMeanThreshold(0.000),
+    sampledConvergenceEnabled(false),
+    convergenceSampleCount(20000),
+    convergenceWorstCount(256),
     topoOperationEnabled(true),
     topoOperationPassCount(5),
     globalPassCount(5),
-    relocationPassCount(10)
+    relocationPassCount(10),
+    activeSetEnabled(true)
 {
 
 }
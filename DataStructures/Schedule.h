@@ -10,12 +10,22 @@ public:
     double minQualThreshold;
     double qualMeanThreshold;
 
+    // Convergence is checked on a stratified sample of elements plus the
+    // worst elements seen so far. The mesh is fully evaluated at the end.
+    bool sampledConvergenceEnabled;
+    int convergenceSampleCount;
+    int convergenceWorstCount;
+
     bool topoOperationEnabled;
     int topoOperationPassCount;
     int refinementSweepCount;
 
     int globalPassCount;
     int relocationPassCount;
+
+    // Relocation passes only revisit vertices that moved
+    // during the previous pass and their neighbors
+    bool activeSetEnabled;
 };
 
 #endif // GPUMESH_SCHEDULE
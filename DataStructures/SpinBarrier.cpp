@@ -0,0 +1,80 @@
+#include "SpinBarrier.h"
+
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+
+const uint SPIN_COUNT = 4000;
+
+
+SpinBarrier::SpinBarrier(uint participantCount) :
+    SpinBarrier(participantCount, defaultSpinCount(participantCount))
+{
+
+}
+
+SpinBarrier::SpinBarrier(uint participantCount, uint spinCount) :
+    _participantCount(participantCount),
+    _spinCount(spinCount),
+    _arrived(0),
+    _phase(0),
+    _sleepers(0)
+{
+
+}
+
+void SpinBarrier::wait()
+{
+    uint phase = _phase.load(memory_order_acquire);
+
+    if(_arrived.fetch_add(1, memory_order_acq_rel) == _participantCount-1)
+    {
+        // Last one in : reset the count and flip the phase
+        _arrived.store(0, memory_order_relaxed);
+        _phase.store(phase + 1, memory_order_seq_cst);
+
+        if(_sleepers.load(memory_order_seq_cst) > 0)
+        {
+            // Sleepers check the phase under the lock before waiting
+            { lock_guard<mutex> lk(_sleepMutex); }
+            _sleepCv.notify_all();
+        }
+
+        return;
+    }
+
+    for(uint s=0; s < _spinCount; ++s)
+    {
+        if(_phase.load(memory_order_acquire) != phase)
+            return;
+
+        cpuRelax();
+    }
+
+    unique_lock<mutex> lk(_sleepMutex);
+    _sleepers.fetch_add(1, memory_order_seq_cst);
+    _sleepCv.wait(lk, [&](){
+        return _phase.load(memory_order_seq_cst) != phase; });
+    _sleepers.fetch_sub(1, memory_order_relaxed);
+}
+
+uint SpinBarrier::defaultSpinCount(uint participantCount)
+{
+    // Spinning while oversubscribed only delays the late participants
+    uint coreCount = thread::hardware_concurrency();
+    return participantCount <= coreCount ? SPIN_COUNT : 0;
+}
+
+void SpinBarrier::cpuRelax()
+{
+#if defined(_MSC_VER)
+    _mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
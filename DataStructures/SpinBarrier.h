@@ -0,0 +1,55 @@
+#ifndef GPUMESH_SPINBARRIER
+#define GPUMESH_SPINBARRIER
+
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#ifndef uint
+typedef unsigned int uint;
+#endif // uint
+
+
+// Reusable barrier for a fixed number of participants.
+// Arriving threads spin on the barrier's phase for a bounded number of
+// iterations, then sleep until the last participant flips the phase.
+class SpinBarrier
+{
+public:
+    explicit SpinBarrier(uint participantCount);
+    SpinBarrier(uint participantCount, uint spinCount);
+    SpinBarrier(const SpinBarrier&) = delete;
+    SpinBarrier& operator = (const SpinBarrier&) = delete;
+
+    uint participantCount() const;
+
+    void wait();
+
+    // Spin iterations before sleeping when there are no more
+    // participants than hardware threads, zero otherwise.
+    static uint defaultSpinCount(uint participantCount);
+
+
+private:
+    static void cpuRelax();
+
+    const uint _participantCount;
+    const uint _spinCount;
+
+    std::atomic<uint> _arrived;
+    std::atomic<uint> _phase;
+
+    std::atomic<uint> _sleepers;
+    std::mutex _sleepMutex;
+    std::condition_variable _sleepCv;
+};
+
+
+
+// IMPLEMENTATION //
+inline uint SpinBarrier::participantCount() const
+{
+    return _participantCount;
+}
+
+#endif // GPUMESH_SPINBARRIER
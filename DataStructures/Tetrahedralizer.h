@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "Mesh.h"
+#include "ThreadPool.h"
 
 
 const uint PRI_ROT[6][6] = {
@@ -35,6 +36,148 @@ const uint HEX_F1 = 0b010;
 const uint HEX_F2 = 0b001;
 
 
+// Tets of a prism, written in tets[0, 3)
+template<typename Tet>
+void tetrahedrizePri(
+        const MeshPri& pri,
+        Tet tets[])
+{
+    uint smallestId = 0;
+    if(pri.v[1] < pri.v[smallestId]) smallestId = 1;
+    if(pri.v[2] < pri.v[smallestId]) smallestId = 2;
+    if(pri.v[3] < pri.v[smallestId]) smallestId = 3;
+    if(pri.v[4] < pri.v[smallestId]) smallestId = 4;
+    if(pri.v[5] < pri.v[smallestId]) smallestId = 5;
+
+    uint vIds[6] = {
+        pri.v[PRI_ROT[smallestId][0]],
+        pri.v[PRI_ROT[smallestId][1]],
+        pri.v[PRI_ROT[smallestId][2]],
+        pri.v[PRI_ROT[smallestId][3]],
+        pri.v[PRI_ROT[smallestId][4]],
+        pri.v[PRI_ROT[smallestId][5]],
+    };
+
+    if(glm::min(vIds[1], vIds[5]) < glm::min(vIds[2], vIds[4]))
+    {
+        tets[0] = Tet(vIds[0], vIds[1], vIds[2], vIds[5]);
+        tets[1] = Tet(vIds[0], vIds[1], vIds[5], vIds[4]);
+        tets[2] = Tet(vIds[0], vIds[4], vIds[5], vIds[3]);
+    }
+    else
+    {
+        tets[0] = Tet(vIds[0], vIds[1], vIds[2], vIds[4]);
+        tets[1] = Tet(vIds[0], vIds[4], vIds[2], vIds[5]);
+        tets[2] = Tet(vIds[0], vIds[4], vIds[5], vIds[3]);
+    }
+}
+
+// Tets of a hex, written in tets[0, 6). Returns their count : 5 or 6.
+template<typename Tet>
+uint tetrahedrizeHex(
+        const MeshHex& hex,
+        Tet tets[])
+{
+    uint smallestId = 0;
+    if(hex.v[1] < hex.v[smallestId]) smallestId = 1;
+    if(hex.v[2] < hex.v[smallestId]) smallestId = 2;
+    if(hex.v[3] < hex.v[smallestId]) smallestId = 3;
+    if(hex.v[4] < hex.v[smallestId]) smallestId = 4;
+    if(hex.v[5] < hex.v[smallestId]) smallestId = 5;
+    if(hex.v[6] < hex.v[smallestId]) smallestId = 6;
+    if(hex.v[7] < hex.v[smallestId]) smallestId = 7;
+
+    uint vIds[8] = {
+        hex.v[HEX_ROT[smallestId][0]],
+        hex.v[HEX_ROT[smallestId][1]],
+        hex.v[HEX_ROT[smallestId][2]],
+        hex.v[HEX_ROT[smallestId][3]],
+        hex.v[HEX_ROT[smallestId][4]],
+        hex.v[HEX_ROT[smallestId][5]],
+        hex.v[HEX_ROT[smallestId][6]],
+        hex.v[HEX_ROT[smallestId][7]]
+    };
+
+    uint diag = 0;
+    if(glm::min(vIds[1], vIds[6]) < glm::min(vIds[2], vIds[5]))
+    {
+        diag |= HEX_F0;
+    }
+    if(glm::min(vIds[3], vIds[6]) < glm::min(vIds[2], vIds[7]))
+    {
+        diag |= HEX_F1;
+    }
+    if(glm::min(vIds[4], vIds[6]) < glm::min(vIds[5], vIds[7]))
+    {
+        diag |= HEX_F2;
+    }
+
+    uint tmp;
+    switch(HEX_LOOP[diag])
+    {
+    case 0 : break; // No rotation
+    case 120:
+        tmp = vIds[1]; vIds[1] = vIds[4]; vIds[4] = vIds[3]; vIds[3] = tmp;
+        tmp = vIds[5]; vIds[5] = vIds[7]; vIds[7] = vIds[2]; vIds[2] = tmp;
+        break;
+
+    case 240:
+        tmp = vIds[1]; vIds[1] = vIds[3]; vIds[3] = vIds[4]; vIds[4] = tmp;
+        tmp = vIds[5]; vIds[5] = vIds[2]; vIds[2] = vIds[7]; vIds[7] = tmp;
+        break;
+
+    default:
+        assert(false /* Hex can only be rotated by 120 or 240 degrees */);
+    }
+
+    uint sum = (diag & HEX_F2) + ((diag & HEX_F1) >> 1) + ((diag & HEX_F0) >> 2);
+    switch(sum)
+    {
+    case 0 :
+        tets[0] = Tet(vIds[0], vIds[1], vIds[2], vIds[5]);
+        tets[1] = Tet(vIds[0], vIds[2], vIds[7], vIds[5]);
+        tets[2] = Tet(vIds[0], vIds[2], vIds[3], vIds[7]);
+        tets[3] = Tet(vIds[0], vIds[5], vIds[7], vIds[4]);
+        tets[4] = Tet(vIds[2], vIds[7], vIds[5], vIds[6]);
+        return 5;
+
+    case 1 :
+        tets[0] = Tet(vIds[0], vIds[5], vIds[7], vIds[4]);
+        tets[1] = Tet(vIds[0], vIds[1], vIds[7], vIds[5]);
+        tets[2] = Tet(vIds[1], vIds[6], vIds[7], vIds[5]);
+        tets[3] = Tet(vIds[0], vIds[7], vIds[2], vIds[3]);
+        tets[4] = Tet(vIds[0], vIds[7], vIds[1], vIds[2]);
+        tets[5] = Tet(vIds[1], vIds[7], vIds[6], vIds[2]);
+        return 6;
+
+    case 2 :
+        tets[0] = Tet(vIds[0], vIds[4], vIds[5], vIds[6]);
+        tets[1] = Tet(vIds[0], vIds[3], vIds[7], vIds[6]);
+        tets[2] = Tet(vIds[0], vIds[7], vIds[4], vIds[6]);
+        tets[3] = Tet(vIds[0], vIds[1], vIds[2], vIds[5]);
+        tets[4] = Tet(vIds[0], vIds[3], vIds[6], vIds[2]);
+        tets[5] = Tet(vIds[0], vIds[6], vIds[5], vIds[2]);
+        return 6;
+
+    case 3 :
+        tets[0] = Tet(vIds[0], vIds[2], vIds[3], vIds[6]);
+        tets[1] = Tet(vIds[0], vIds[3], vIds[7], vIds[6]);
+        tets[2] = Tet(vIds[0], vIds[7], vIds[4], vIds[6]);
+        tets[3] = Tet(vIds[0], vIds[5], vIds[6], vIds[4]);
+        tets[4] = Tet(vIds[1], vIds[5], vIds[6], vIds[0]);
+        tets[5] = Tet(vIds[1], vIds[6], vIds[2], vIds[0]);
+        return 6;
+
+    default:
+        assert(false /* There are only 3 bits to be summed */);
+    }
+
+    return 0;
+}
+
+// Appends the tets of mesh's elements to 'tets'. Elements' cache ids are
+// set to their first tet. Elements are split concurrently : each chunk of
+// hexs counts its tets before any chunk writes its own.
 template<typename Tet>
 void tetrahedrize(
         std::vector<Tet>& tets,
@@ -43,167 +186,73 @@ void tetrahedrize(
     size_t tetCount = mesh.tets.size();
     size_t priCount = mesh.pris.size();
     size_t hexCount = mesh.hexs.size();
-    size_t maxTetCount = tetCount +
-        priCount * 3 + hexCount * 6;
 
-    tets.reserve(maxTetCount);
+    ThreadPool& pool = getThreadPool();
+    size_t chunkCount = pool.concurrency();
 
 
-    // Tets
-    for(const MeshTet& tet : mesh.tets)
-    {
-        tet.c[0] = tets.size();
-        tets.push_back(Tet(tet));
-    }
+    // Hexs
+    std::vector<size_t> hexBases(chunkCount + 1, 0);
+    pool.parallelFor(chunkCount, [&](size_t c){
+        size_t hexBeg = (hexCount * c) / chunkCount;
+        size_t hexEnd = (hexCount * (c+1)) / chunkCount;
 
+        Tet hexTets[6];
+        size_t count = 0;
+        for(size_t h=hexBeg; h < hexEnd; ++h)
+            count += tetrahedrizeHex(mesh.hexs[h], hexTets);
 
-    // Prisms
-    for(const MeshPri& pri : mesh.pris)
-    {
-        pri.c[0] = tets.size();
-        pri.c[1] = tets.size();
-        pri.c[2] = tets.size();
-        pri.c[3] = tets.size();
-        pri.c[4] = tets.size();
-        pri.c[5] = tets.size();
-
-        uint smallestId = 0;
-        if(pri.v[1] < pri.v[smallestId]) smallestId = 1;
-        if(pri.v[2] < pri.v[smallestId]) smallestId = 2;
-        if(pri.v[3] < pri.v[smallestId]) smallestId = 3;
-        if(pri.v[4] < pri.v[smallestId]) smallestId = 4;
-        if(pri.v[5] < pri.v[smallestId]) smallestId = 5;
-
-        uint vIds[6] = {
-            pri.v[PRI_ROT[smallestId][0]],
-            pri.v[PRI_ROT[smallestId][1]],
-            pri.v[PRI_ROT[smallestId][2]],
-            pri.v[PRI_ROT[smallestId][3]],
-            pri.v[PRI_ROT[smallestId][4]],
-            pri.v[PRI_ROT[smallestId][5]],
-        };
-
-        if(glm::min(vIds[1], vIds[5]) < glm::min(vIds[2], vIds[4]))
-        {
-            tets.push_back(Tet(vIds[0], vIds[1], vIds[2], vIds[5]));
-            tets.push_back(Tet(vIds[0], vIds[1], vIds[5], vIds[4]));
-            tets.push_back(Tet(vIds[0], vIds[4], vIds[5], vIds[3]));
-        }
-        else
-        {
-            tets.push_back(Tet(vIds[0], vIds[1], vIds[2], vIds[4]));
-            tets.push_back(Tet(vIds[0], vIds[4], vIds[2], vIds[5]));
-            tets.push_back(Tet(vIds[0], vIds[4], vIds[5], vIds[3]));
-        }
-    }
+        hexBases[c+1] = count;
+    });
 
+    size_t tetBase = tets.size();
+    size_t priBase = tetBase + tetCount;
+    hexBases[0] = priBase + priCount * 3;
+    for(size_t c=0; c < chunkCount; ++c)
+        hexBases[c+1] += hexBases[c];
 
-    // Hexs
-    for(const MeshHex& hex : mesh.hexs)
-    {
-        hex.c[0] = tets.size();
-        hex.c[1] = tets.size();
-        hex.c[2] = tets.size();
-        hex.c[3] = tets.size();
-        hex.c[4] = tets.size();
-        hex.c[5] = tets.size();
-        hex.c[6] = tets.size();
-        hex.c[7] = tets.size();
-
-        uint smallestId = 0;
-        if(hex.v[1] < hex.v[smallestId]) smallestId = 1;
-        if(hex.v[2] < hex.v[smallestId]) smallestId = 2;
-        if(hex.v[3] < hex.v[smallestId]) smallestId = 3;
-        if(hex.v[4] < hex.v[smallestId]) smallestId = 4;
-        if(hex.v[5] < hex.v[smallestId]) smallestId = 5;
-        if(hex.v[6] < hex.v[smallestId]) smallestId = 6;
-        if(hex.v[7] < hex.v[smallestId]) smallestId = 7;
-
-        uint vIds[8] = {
-            hex.v[HEX_ROT[smallestId][0]],
-            hex.v[HEX_ROT[smallestId][1]],
-            hex.v[HEX_ROT[smallestId][2]],
-            hex.v[HEX_ROT[smallestId][3]],
-            hex.v[HEX_ROT[smallestId][4]],
-            hex.v[HEX_ROT[smallestId][5]],
-            hex.v[HEX_ROT[smallestId][6]],
-            hex.v[HEX_ROT[smallestId][7]]
-        };
-
-        uint diag = 0;
-        if(glm::min(vIds[1], vIds[6]) < glm::min(vIds[2], vIds[5]))
-        {
-            diag |= HEX_F0;
-        }
-        if(glm::min(vIds[3], vIds[6]) < glm::min(vIds[2], vIds[7]))
-        {
-            diag |= HEX_F1;
-        }
-        if(glm::min(vIds[4], vIds[6]) < glm::min(vIds[5], vIds[7]))
+    tets.resize(hexBases[chunkCount]);
+
+
+    pool.parallelFor(chunkCount, [&](size_t c){
+        // Tets
+        size_t tetBeg = (tetCount * c) / chunkCount;
+        size_t tetEnd = (tetCount * (c+1)) / chunkCount;
+        for(size_t t=tetBeg; t < tetEnd; ++t)
         {
-            diag |= HEX_F2;
+            const MeshTet& tet = mesh.tets[t];
+            tet.c[0] = tetBase + t;
+            tets[tetBase + t] = Tet(tet);
         }
 
-        uint tmp;
-        switch(HEX_LOOP[diag])
+
+        // Prisms
+        size_t priBeg = (priCount * c) / chunkCount;
+        size_t priEnd = (priCount * (c+1)) / chunkCount;
+        for(size_t p=priBeg; p < priEnd; ++p)
         {
-        case 0 : break; // No rotation
-        case 120:
-            tmp = vIds[1]; vIds[1] = vIds[4]; vIds[4] = vIds[3]; vIds[3] = tmp;
-            tmp = vIds[5]; vIds[5] = vIds[7]; vIds[7] = vIds[2]; vIds[2] = tmp;
-            break;
-
-        case 240:
-            tmp = vIds[1]; vIds[1] = vIds[3]; vIds[3] = vIds[4]; vIds[4] = tmp;
-            tmp = vIds[5]; vIds[5] = vIds[2]; vIds[2] = vIds[7]; vIds[7] = tmp;
-            break;
-
-        default:
-            assert(false /* Hex can only be rotated by 120 or 240 degrees */);
+            const MeshPri& pri = mesh.pris[p];
+            uint first = priBase + p * 3;
+            for(uint v=0; v < MeshPri::VERTEX_COUNT; ++v)
+                pri.c[v] = first;
+
+            tetrahedrizePri(pri, &tets[first]);
         }
 
-        uint sum = (diag & HEX_F2) + ((diag & HEX_F1) >> 1) + ((diag & HEX_F0) >> 2);
-        switch(sum)
+
+        // Hexs
+        size_t hexBeg = (hexCount * c) / chunkCount;
+        size_t hexEnd = (hexCount * (c+1)) / chunkCount;
+        size_t next = hexBases[c];
+        for(size_t h=hexBeg; h < hexEnd; ++h)
         {
-        case 0 :
-            tets.push_back(Tet(vIds[0], vIds[1], vIds[2], vIds[5]));
-            tets.push_back(Tet(vIds[0], vIds[2], vIds[7], vIds[5]));
-            tets.push_back(Tet(vIds[0], vIds[2], vIds[3], vIds[7]));
-            tets.push_back(Tet(vIds[0], vIds[5], vIds[7], vIds[4]));
-            tets.push_back(Tet(vIds[2], vIds[7], vIds[5], vIds[6]));
-            break;
-
-        case 1 :
-            tets.push_back(Tet(vIds[0], vIds[5], vIds[7], vIds[4]));
-            tets.push_back(Tet(vIds[0], vIds[1], vIds[7], vIds[5]));
-            tets.push_back(Tet(vIds[1], vIds[6], vIds[7], vIds[5]));
-            tets.push_back(Tet(vIds[0], vIds[7], vIds[2], vIds[3]));
-            tets.push_back(Tet(vIds[0], vIds[7], vIds[1], vIds[2]));
-            tets.push_back(Tet(vIds[1], vIds[7], vIds[6], vIds[2]));
-            break;
-
-        case 2 :
-            tets.push_back(Tet(vIds[0], vIds[4], vIds[5], vIds[6]));
-            tets.push_back(Tet(vIds[0], vIds[3], vIds[7], vIds[6]));
-            tets.push_back(Tet(vIds[0], vIds[7], vIds[4], vIds[6]));
-            tets.push_back(Tet(vIds[0], vIds[1], vIds[2], vIds[5]));
-            tets.push_back(Tet(vIds[0], vIds[3], vIds[6], vIds[2]));
-            tets.push_back(Tet(vIds[0], vIds[6], vIds[5], vIds[2]));
-            break;
-
-        case 3 :
-            tets.push_back(Tet(vIds[0], vIds[2], vIds[3], vIds[6]));
-            tets.push_back(Tet(vIds[0], vIds[3], vIds[7], vIds[6]));
-            tets.push_back(Tet(vIds[0], vIds[7], vIds[4], vIds[6]));
-            tets.push_back(Tet(vIds[0], vIds[5], vIds[6], vIds[4]));
-            tets.push_back(Tet(vIds[1], vIds[5], vIds[6], vIds[0]));
-            tets.push_back(Tet(vIds[1], vIds[6], vIds[2], vIds[0]));
-            break;
-
-        default:
-            assert(false /* There are only 3 bits to be summed */);
+            const MeshHex& hex = mesh.hexs[h];
+            for(uint v=0; v < MeshHex::VERTEX_COUNT; ++v)
+                hex.c[v] = next;
+
+            next += tetrahedrizeHex(hex, &tets[next]);
         }
-    }
+    });
 }
 
 
@@ -0,0 +1,341 @@
+#include "ThreadPool.h"
+
+#include <iterator>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <CellarWorkbench/Misc/Log.h>
+
+using namespace std;
+using namespace cellar;
+
+
+const int ThreadPool::NO_QUEUE = -1;
+
+// Pool the current thread works for, if any
+thread_local const ThreadPool* workerPool = nullptr;
+
+ThreadPool::ThreadPool(uint workerCount) :
+    _workerCount(0),
+    _pinning(false),
+    _pendingJobs(0),
+    _nextQueue(0),
+    _reservedWorkers(0),
+    _stopping(false)
+{
+    setWorkerCount(workerCount);
+}
+
+ThreadPool::~ThreadPool()
+{
+    stopWorkers();
+}
+
+void ThreadPool::setWorkerCount(uint count)
+{
+    if(count == 0)
+    {
+        uint coreCount = thread::hardware_concurrency();
+        count = coreCount > 1 ? coreCount - 1 : 1;
+    }
+
+    if(count == _workerCount && !_workers.empty())
+        return;
+
+    stopWorkers();
+    _workerCount = count;
+    startWorkers();
+
+    getLog().postMessage(new Message('I', false,
+        "Thread pool worker count: " + to_string(_workerCount) +
+        (_pinning ? " (pinned)" : ""), "ThreadPool"));
+}
+
+void ThreadPool::setPinning(bool enabled)
+{
+    if(_pinning == enabled)
+        return;
+
+    _pinning = enabled;
+
+    stopWorkers();
+    startWorkers();
+}
+
+void ThreadPool::parallelFor(size_t taskCount, const Task& task)
+{
+    if(taskCount == 0)
+        return;
+
+    if(taskCount == 1)
+    {
+        task(0);
+        return;
+    }
+
+    Batch batch;
+    batch.task = &task;
+    batch.remaining = taskCount;
+
+    pushJobs(batch, taskCount);
+    waitBatch(batch, true);
+}
+
+uint ThreadPool::reserveTeam(uint teamSize)
+{
+    // A worker waiting on its team can't run members
+    uint callerCount = workerPool == this ? 1 : 0;
+
+    uint granted = 0;
+    uint reserved = _reservedWorkers.load();
+    do
+    {
+        uint taken = reserved + callerCount;
+        granted = _workerCount > taken ?
+            std::min(teamSize, _workerCount - taken) : 0;
+    }
+    while(!_reservedWorkers.compare_exchange_weak(
+            reserved, reserved + granted + callerCount));
+
+    return granted;
+}
+
+void ThreadPool::releaseTeam(uint teamSize)
+{
+    uint callerCount = workerPool == this ? 1 : 0;
+    _reservedWorkers.fetch_sub(teamSize + callerCount);
+}
+
+bool ThreadPool::runTeam(size_t teamSize, const Task& task,
+                         const std::function<void()>& callerTask)
+{
+    // Members of an oversized team would wait forever on each other
+    if(teamSize > _reservedWorkers.load() || teamSize > _workerCount)
+    {
+        getLog().postMessage(new Message('E', false,
+            "Team of " + to_string(teamSize) + " workers exceeds the " +
+            "reserved workers", "ThreadPool"));
+        return false;
+    }
+
+    Batch batch;
+    batch.task = &task;
+    batch.remaining = teamSize;
+
+    pushJobs(batch, teamSize);
+
+    if(callerTask)
+        callerTask();
+
+    // Members may be blocked on the caller : don't
+    // let the caller steal the last members' jobs.
+    waitBatch(batch, false);
+
+    return true;
+}
+
+void ThreadPool::startWorkers()
+{
+    _stopping = false;
+    _pendingJobs = 0;
+
+    _queues.clear();
+    for(uint w=0; w < _workerCount; ++w)
+        _queues.push_back(unique_ptr<WorkQueue>(new WorkQueue()));
+
+    for(uint w=0; w < _workerCount; ++w)
+    {
+        _workers.push_back(thread(&ThreadPool::workerLoop, this, w));
+
+        if(_pinning)
+            pinWorker(w);
+    }
+}
+
+void ThreadPool::stopWorkers()
+{
+    {
+        lock_guard<mutex> lk(_sleepMutex);
+        _stopping = true;
+    }
+    _sleepCv.notify_all();
+
+    for(thread& worker : _workers)
+        worker.join();
+
+    _workers.clear();
+}
+
+void ThreadPool::pinWorker(uint wId)
+{
+    uint coreCount = thread::hardware_concurrency();
+    if(coreCount == 0)
+        return;
+
+    // Core 0 is left to the calling thread
+    uint core = (wId + 1) % coreCount;
+
+#if defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(core, &cpuSet);
+    pthread_setaffinity_np(_workers[wId].native_handle(),
+                           sizeof(cpu_set_t), &cpuSet);
+#elif defined(_WIN32)
+    SetThreadAffinityMask(_workers[wId].native_handle(),
+                          DWORD_PTR(1) << core);
+#else
+    (void) core;
+    if(wId == 0)
+    {
+        getLog().postMessage(new Message('W', false,
+            "Thread pinning is not supported on this platform", "ThreadPool"));
+    }
+#endif
+}
+
+void ThreadPool::workerLoop(uint wId)
+{
+    workerPool = this;
+
+    while(true)
+    {
+        Job job;
+        if(popJob(wId, job))
+        {
+            runJob(job);
+            continue;
+        }
+
+        unique_lock<mutex> lk(_sleepMutex);
+        _sleepCv.wait(lk, [this](){
+            return _stopping || _pendingJobs.load() > 0; });
+
+        if(_stopping && _pendingJobs.load() <= 0)
+            return;
+    }
+}
+
+void ThreadPool::pushJobs(Batch& batch, size_t jobCount)
+{
+    {
+        // Announce jobs before they're queued so
+        // that no worker goes to sleep in between
+        lock_guard<mutex> lk(_sleepMutex);
+        _pendingJobs.fetch_add(int(jobCount));
+    }
+
+    uint first = _nextQueue.fetch_add(1) % _workerCount;
+    for(size_t j=0; j < jobCount; ++j)
+    {
+        WorkQueue& queue = *_queues[(first + j) % _workerCount];
+        lock_guard<mutex> lk(queue.mutex);
+        queue.jobs.push_back(Job{&batch, j});
+    }
+
+    _sleepCv.notify_all();
+}
+
+bool ThreadPool::popJob(int ownQueue, Job& job)
+{
+    // Own queue's front first
+    if(ownQueue != NO_QUEUE)
+    {
+        WorkQueue& queue = *_queues[ownQueue];
+        lock_guard<mutex> lk(queue.mutex);
+        if(!queue.jobs.empty())
+        {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+            _pendingJobs.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Then steal from the back of the others' queues
+    uint first = ownQueue != NO_QUEUE ? ownQueue + 1 : 0;
+    for(uint q=0; q < _workerCount; ++q)
+    {
+        uint qId = (first + q) % _workerCount;
+        if(int(qId) == ownQueue)
+            continue;
+
+        WorkQueue& queue = *_queues[qId];
+        lock_guard<mutex> lk(queue.mutex);
+        if(!queue.jobs.empty())
+        {
+            job = queue.jobs.back();
+            queue.jobs.pop_back();
+            _pendingJobs.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ThreadPool::popBatchJob(const Batch& batch, Job& job)
+{
+    // Jobs of other batches may be team members that would block
+    // the caller, or be blocked by it : they are left to the workers.
+    for(uint qId=0; qId < _workerCount; ++qId)
+    {
+        WorkQueue& queue = *_queues[qId];
+        lock_guard<mutex> lk(queue.mutex);
+        for(auto it = queue.jobs.rbegin(); it != queue.jobs.rend(); ++it)
+        {
+            if(it->batch == &batch)
+            {
+                job = *it;
+                queue.jobs.erase(std::next(it).base());
+                _pendingJobs.fetch_sub(1);
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::runJob(const Job& job)
+{
+    Batch& batch = *job.batch;
+    (*batch.task)(job.index);
+
+    // The batch lives on its caller's stack : notify
+    // while holding the lock so it outlives the notification
+    lock_guard<mutex> lk(batch.mutex);
+    if(--batch.remaining == 0)
+        batch.doneCv.notify_all();
+}
+
+void ThreadPool::waitBatch(Batch& batch, bool help)
+{
+    if(help)
+    {
+        Job job;
+        while(popBatchJob(batch, job))
+        {
+            runJob(job);
+
+            lock_guard<mutex> lk(batch.mutex);
+            if(batch.remaining == 0)
+                return;
+        }
+    }
+
+    unique_lock<mutex> lk(batch.mutex);
+    batch.doneCv.wait(lk, [&batch](){ return batch.remaining == 0; });
+}
+
+ThreadPool& getThreadPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
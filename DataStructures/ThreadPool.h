@@ -0,0 +1,129 @@
+#ifndef GPUMESH_THREADPOOL
+#define GPUMESH_THREADPOOL
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+
+#ifndef uint
+typedef unsigned int uint;
+#endif // uint
+
+
+class ThreadPool
+{
+public:
+    typedef std::function<void(size_t)> Task;
+
+    // A worker count of 0 stands for one less than the hardware
+    // concurrency since the calling thread takes part in parallelFor()
+    explicit ThreadPool(uint workerCount = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator = (const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    uint workerCount() const;
+    void setWorkerCount(uint count);
+
+    // Workers plus the calling thread
+    uint concurrency() const;
+
+    bool pinning() const;
+    void setPinning(bool enabled);
+
+
+    // Runs task(i) for i in [0, taskCount) and returns once they are all
+    // done. Tasks are dealt to the workers' queues, idle workers steal
+    // from the others' queues and the calling thread helps with its own
+    // tasks while waiting.
+    void parallelFor(size_t taskCount, const Task& task);
+
+    // Takes up to teamSize workers that no other team holds. A worker
+    // calling this also holds itself until released. Returns how many
+    // workers were taken, which may be less than requested.
+    uint reserveTeam(uint teamSize);
+    void releaseTeam(uint teamSize);
+
+    // Runs task(m) for m in [0, teamSize) on distinct workers at once, so
+    // that members may synchronize with each other and with the calling
+    // thread, which runs callerTask meanwhile. The team's workers must be
+    // reserved : returns false without running anything otherwise.
+    bool runTeam(size_t teamSize, const Task& task,
+                 const std::function<void()>& callerTask);
+
+
+private:
+    struct Batch
+    {
+        const Task* task;
+        size_t remaining;
+        std::mutex mutex;
+        std::condition_variable doneCv;
+    };
+
+    struct Job
+    {
+        Batch* batch;
+        size_t index;
+    };
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    static const int NO_QUEUE;
+
+    void startWorkers();
+    void stopWorkers();
+    void pinWorker(uint wId);
+    void workerLoop(uint wId);
+
+    void pushJobs(Batch& batch, size_t jobCount);
+    bool popJob(int ownQueue, Job& job);
+    bool popBatchJob(const Batch& batch, Job& job);
+    void runJob(const Job& job);
+    void waitBatch(Batch& batch, bool help);
+
+    uint _workerCount;
+    bool _pinning;
+
+    std::vector<std::thread> _workers;
+    std::vector<std::unique_ptr<WorkQueue>> _queues;
+
+    std::mutex _sleepMutex;
+    std::condition_variable _sleepCv;
+    std::atomic<int> _pendingJobs;
+    std::atomic<uint> _nextQueue;
+    std::atomic<uint> _reservedWorkers;
+    bool _stopping;
+};
+
+// Process-wide pool shared by the "Thread" implementations
+ThreadPool& getThreadPool();
+
+
+
+// IMPLEMENTATION //
+inline uint ThreadPool::workerCount() const
+{
+    return _workerCount;
+}
+
+inline uint ThreadPool::concurrency() const
+{
+    return _workerCount + 1;
+}
+
+inline bool ThreadPool::pinning() const
+{
+    return _pinning;
+}
+
+#endif // GPUMESH_THREADPOOL
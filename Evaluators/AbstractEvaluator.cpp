@@ -1,7 +1,7 @@
 #include "AbstractEvaluator.h"
 
-#include <future>
 #include <chrono>
+#include <algorithm>
 #include <sstream>
 #include <fstream>
 #include <iomanip>
@@ -10,10 +10,14 @@
 
 #include "DataStructures/GpuMesh.h"
 #include "DataStructures/MeshCrew.h"
+#include "DataStructures/QualityCache.h"
 #include "DataStructures/QualityHistogram.h"
+#include "DataStructures/ThreadPool.h"
 #include "Samplers/AbstractSampler.h"
 #include "Measurers/AbstractMeasurer.h"
 
+#include "Pipeline.h"
+
 using namespace cellar;
 using namespace std;
 
@@ -22,6 +26,8 @@ const std::string AbstractEvaluator::THREAD_IMPL_NAME = "Thread";
 const std::string AbstractEvaluator::GLSL_IMPL_NAME = "GLSL";
 const std::string AbstractEvaluator::CUDA_IMPL_NAME = "CUDA";
 
+const size_t AbstractEvaluator::QUALITY_BATCH_SIZE = 256;
+
 const double AbstractEvaluator::VALIDITY_EPSILON = 1e-6;
 const double AbstractEvaluator::MAX_INTEGER_VALUE = 2147483647.0;
 
@@ -131,6 +137,14 @@ void AbstractEvaluator::initialize(
     glGenBuffers(1, &_histSsbo);
 }
 
+std::shared_ptr<AbstractPipeline> AbstractEvaluator::createPipeline(
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer) const
+{
+    return std::shared_ptr<AbstractPipeline>(
+        new VirtualPipeline(*this, measurer, sampler));
+}
+
 void AbstractEvaluator::installPlugin(
         const Mesh& mesh,
         cellar::GlProgram& program) const
@@ -233,6 +247,39 @@ double AbstractEvaluator::hexQuality(
     return hexQuality(sampler, measurer, vp, hex);
 }
 
+void AbstractEvaluator::tetQualities(
+        const Mesh& mesh,
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        size_t first, size_t last,
+        double qualities[]) const
+{
+    for(size_t i=first; i < last; ++i)
+        qualities[i - first] = tetQuality(mesh, sampler, measurer, mesh.tets[i]);
+}
+
+void AbstractEvaluator::priQualities(
+        const Mesh& mesh,
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        size_t first, size_t last,
+        double qualities[]) const
+{
+    for(size_t i=first; i < last; ++i)
+        qualities[i - first] = priQuality(mesh, sampler, measurer, mesh.pris[i]);
+}
+
+void AbstractEvaluator::hexQualities(
+        const Mesh& mesh,
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        size_t first, size_t last,
+        double qualities[]) const
+{
+    for(size_t i=first; i < last; ++i)
+        qualities[i - first] = hexQuality(mesh, sampler, measurer, mesh.hexs[i]);
+}
+
 double AbstractEvaluator::patchQuality(
             const Mesh& mesh,
             const AbstractSampler& sampler,
@@ -243,36 +290,52 @@ double AbstractEvaluator::patchQuality(
     const std::vector<MeshPri>& pris = mesh.pris;
     const std::vector<MeshHex>& hexs = mesh.hexs;
 
-    const MeshTopo& topo = mesh.topos[vId];
+    const MeshNeigRange<MeshNeigElem> neigElems = mesh.neighborElems(vId);
 
-    size_t neigElemCount = topo.neighborElems.size();
+    // Patches are evaluated at trial positions : cached
+    // qualities are read but computed ones aren't stored
+    const QualityCache& cache = mesh.qualityCache();
+    bool useCache = cache.isEnabled();
+
+    size_t neigElemCount = neigElems.size();
 
     double patchWeight = 0.0;
     double patchQuality = 0.0;
     for(size_t n=0; n < neigElemCount; ++n)
     {
-        const MeshNeigElem& neigElem = topo.neighborElems[n];
+        const MeshNeigElem& neigElem = neigElems[n];
 
+        double elemQuality = NAN;
         switch(neigElem.type)
         {
         case MeshTet::ELEMENT_TYPE:
-            accumulatePatchQuality(
-                patchQuality, patchWeight,
-                tetQuality(mesh, sampler, measurer, tets[neigElem.id]));
+            if(useCache)
+                elemQuality = cache.quality(tets[neigElem.id], neigElem.id);
+            if(std::isnan(elemQuality))
+                elemQuality = tetQuality(mesh, sampler, measurer, tets[neigElem.id]);
             break;
 
         case MeshPri::ELEMENT_TYPE:
-            accumulatePatchQuality(
-                patchQuality, patchWeight,
-                priQuality(mesh, sampler, measurer, pris[neigElem.id]));
+            if(useCache)
+                elemQuality = cache.quality(pris[neigElem.id], neigElem.id);
+            if(std::isnan(elemQuality))
+                elemQuality = priQuality(mesh, sampler, measurer, pris[neigElem.id]);
             break;
 
         case MeshHex::ELEMENT_TYPE:
-            accumulatePatchQuality(
-                patchQuality, patchWeight,
-                hexQuality(mesh, sampler, measurer, hexs[neigElem.id]));
+            if(useCache)
+                elemQuality = cache.quality(hexs[neigElem.id], neigElem.id);
+            if(std::isnan(elemQuality))
+                elemQuality = hexQuality(mesh, sampler, measurer, hexs[neigElem.id]);
             break;
+
+        default:
+            continue;
         }
+
+        accumulatePatchQuality(
+            patchQuality, patchWeight,
+            elemQuality);
     }
 
     return finalizePatchQuality(patchQuality, patchWeight);
@@ -387,18 +450,12 @@ void AbstractEvaluator::evaluateMeshQualitySerial(
         const AbstractMeasurer& measurer,
         QualityHistogram& histogram) const
 {
-    int tetCount = mesh.tets.size();
-    int priCount = mesh.pris.size();
-    int hexCount = mesh.hexs.size();
-
-    for(int i=0; i < tetCount; ++i)
-        histogram.add(tetQuality(mesh, sampler, measurer, mesh.tets[i]));
-
-    for(int i=0; i < priCount; ++i)
-        histogram.add(priQuality(mesh, sampler, measurer, mesh.pris[i]));
+    size_t tetCount = mesh.tets.size();
+    size_t priCount = mesh.pris.size();
+    size_t hexCount = mesh.hexs.size();
 
-    for(int i=0; i < hexCount; ++i)
-        histogram.add(hexQuality(mesh, sampler, measurer, mesh.hexs[i]));
+    evaluateElementRanges(mesh, sampler, measurer,
+        0, tetCount, 0, priCount, 0, hexCount, histogram);
 }
 
 void AbstractEvaluator::evaluateMeshQualityThread(
@@ -407,49 +464,87 @@ void AbstractEvaluator::evaluateMeshQualityThread(
         const AbstractMeasurer& measurer,
         QualityHistogram& histogram) const
 {
-    int tetCount = mesh.tets.size();
-    int priCount = mesh.pris.size();
-    int hexCount = mesh.hexs.size();
+    size_t tetCount = mesh.tets.size();
+    size_t priCount = mesh.pris.size();
+    size_t hexCount = mesh.hexs.size();
 
     if((tetCount + priCount + hexCount) == 0)
     {
         return;
     }
 
-    vector<future<QualityHistogram>> futures;
-    uint coreCountHint = thread::hardware_concurrency();
-    for(uint t=0; t < coreCountHint; ++t)
+    ThreadPool& pool = getThreadPool();
+    uint coreCountHint = pool.concurrency();
+    vector<QualityHistogram> coreHists(coreCountHint,
+        QualityHistogram(histogram.bucketCount()));
+
+    pool.parallelFor(coreCountHint, [&](size_t t){
+        size_t tetBeg = (tetCount * t) / coreCountHint;
+        size_t tetEnd = (tetCount * (t+1)) / coreCountHint;
+        size_t priBeg = (priCount * t) / coreCountHint;
+        size_t priEnd = (priCount * (t+1)) / coreCountHint;
+        size_t hexBeg = (hexCount * t) / coreCountHint;
+        size_t hexEnd = (hexCount * (t+1)) / coreCountHint;
+
+        evaluateElementRanges(mesh, sampler, measurer,
+            tetBeg, tetEnd, priBeg, priEnd, hexBeg, hexEnd,
+            coreHists[t]);
+    });
+
+
+    // Combine workers' results
+    for(uint i=0; i < coreCountHint; ++i)
     {
-        futures.push_back(async(launch::async, [&, t](){
-            QualityHistogram coreHist(histogram.bucketCount());
+        histogram.merge(coreHists[i]);
+    }
+}
 
-            int tetBeg = (tetCount * t) / coreCountHint;
-            int tetEnd = (tetCount * (t+1)) / coreCountHint;
-            int priBeg = (priCount * t) / coreCountHint;
-            int priEnd = (priCount * (t+1)) / coreCountHint;
-            int hexBeg = (hexCount * t) / coreCountHint;
-            int hexEnd = (hexCount * (t+1)) / coreCountHint;
+void AbstractEvaluator::updateMeshQualitySerial(
+        const Mesh& mesh,
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        QualityHistogram& histogram) const
+{
+    QualityCache& cache = mesh.qualityCache();
 
-            for(int i=tetBeg; i < tetEnd; ++i)
-                coreHist.add(tetQuality(mesh, sampler, measurer, mesh.tets[i]));
+    vector<MeshNeigElem> dirtyElems;
+    cache.collectDirtyElements(mesh, dirtyElems);
 
-            for(int i=priBeg; i < priEnd; ++i)
-                coreHist.add(priQuality(mesh, sampler, measurer, mesh.pris[i]));
+    for(const MeshNeigElem& elem : dirtyElems)
+        cache.update(elem, elementQuality(mesh, sampler, measurer, elem));
 
-            for(int i=hexBeg; i < hexEnd; ++i)
-                coreHist.add(hexQuality(mesh, sampler, measurer, mesh.hexs[i]));
+    histogram = cache.histogram();
+}
 
-            return coreHist;
-        }));
-    }
+void AbstractEvaluator::updateMeshQualityThread(
+        const Mesh& mesh,
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        QualityHistogram& histogram) const
+{
+    QualityCache& cache = mesh.qualityCache();
 
+    vector<MeshNeigElem> dirtyElems;
+    cache.collectDirtyElements(mesh, dirtyElems);
+    size_t dirtyCount = dirtyElems.size();
 
-    // Combine workers' results
-    for(uint i=0; i < coreCountHint; ++i)
-    {
-        QualityHistogram coreHist = futures[i].get();
-        histogram.merge(coreHist);
-    }
+    ThreadPool& pool = getThreadPool();
+    uint coreCountHint = pool.concurrency();
+    vector<double> qualities(dirtyCount);
+
+    pool.parallelFor(coreCountHint, [&](size_t t){
+        size_t beg = (dirtyCount * t) / coreCountHint;
+        size_t end = (dirtyCount * (t+1)) / coreCountHint;
+
+        for(size_t i=beg; i < end; ++i)
+            qualities[i] = elementQuality(mesh, sampler, measurer, dirtyElems[i]);
+    });
+
+    // The histogram and its min tree are updated serially
+    for(size_t i=0; i < dirtyCount; ++i)
+        cache.update(dirtyElems[i], qualities[i]);
+
+    histogram = cache.histogram();
 }
 
 void AbstractEvaluator::evaluateMeshQualityGlsl(
@@ -775,6 +870,101 @@ void AbstractEvaluator::benchmark(
         "AbstractEvaluator"));
 }
 
+double AbstractEvaluator::elementQuality(
+        const Mesh& mesh,
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        const MeshNeigElem& elem) const
+{
+    switch(elem.type)
+    {
+    case MeshTet::ELEMENT_TYPE:
+        return tetQuality(mesh, sampler, measurer, mesh.tets[elem.id]);
+    case MeshPri::ELEMENT_TYPE:
+        return priQuality(mesh, sampler, measurer, mesh.pris[elem.id]);
+    case MeshHex::ELEMENT_TYPE:
+        return hexQuality(mesh, sampler, measurer, mesh.hexs[elem.id]);
+    }
+
+    return NAN;
+}
+
+void AbstractEvaluator::evaluateElementRanges(
+        const Mesh& mesh,
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        size_t tetBeg, size_t tetEnd,
+        size_t priBeg, size_t priEnd,
+        size_t hexBeg, size_t hexEnd,
+        QualityHistogram& histogram) const
+{
+    evaluateElementRange(mesh, mesh.tets, sampler, measurer, tetBeg, tetEnd,
+        &AbstractEvaluator::tetQualities, histogram);
+
+    evaluateElementRange(mesh, mesh.pris, sampler, measurer, priBeg, priEnd,
+        &AbstractEvaluator::priQualities, histogram);
+
+    evaluateElementRange(mesh, mesh.hexs, sampler, measurer, hexBeg, hexEnd,
+        &AbstractEvaluator::hexQualities, histogram);
+}
+
+template<typename Elem>
+void AbstractEvaluator::evaluateElementRange(
+        const Mesh& mesh,
+        const std::vector<Elem>& elems,
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        size_t first, size_t last,
+        BatchQualityFunc batchQualities,
+        QualityHistogram& histogram) const
+{
+    // Elements are evaluated in batches so that
+    // evaluators can process many of them at once
+    double qualities[QUALITY_BATCH_SIZE];
+
+    QualityCache& cache = mesh.qualityCache();
+    if(!cache.isEnabled())
+    {
+        for(size_t b=first; b < last; b += QUALITY_BATCH_SIZE)
+        {
+            size_t e = std::min(b + QUALITY_BATCH_SIZE, last);
+            (this->*batchQualities)(mesh, sampler, measurer, b, e, qualities);
+            for(size_t i=0; i < e - b; ++i)
+                histogram.add(qualities[i]);
+        }
+
+        return;
+    }
+
+    // Clean elements are read from the cache. Runs
+    // of dirty ones are evaluated, then stored.
+    size_t i = first;
+    while(i < last)
+    {
+        double quality = cache.quality(elems[i], i);
+        if(!std::isnan(quality))
+        {
+            histogram.add(quality);
+            ++i;
+            continue;
+        }
+
+        size_t e = i + 1;
+        size_t eMax = std::min(i + QUALITY_BATCH_SIZE, last);
+        while(e < eMax && std::isnan(cache.quality(elems[e], e)))
+            ++e;
+
+        (this->*batchQualities)(mesh, sampler, measurer, i, e, qualities);
+        for(size_t j=i; j < e; ++j)
+        {
+            histogram.add(qualities[j - i]);
+            cache.store<Elem>(j, qualities[j - i]);
+        }
+
+        i = e;
+    }
+}
+
 void AbstractEvaluator::accumulatePatchQuality(
         double& patchQuality,
         double& patchWeight,
@@ -8,6 +8,7 @@
 
 class AbstractSampler;
 class AbstractMeasurer;
+class AbstractPipeline;
 class MeshCrew;
 
 class QualityHistogram;
@@ -32,6 +33,13 @@ public:
             const Mesh& mesh,
             const MeshCrew& crew);
 
+    // Pipeline bound to the given measurer and sampler. Evaluators that
+    // provide element quality templates return one specialized on their
+    // concrete types. Defaults to the virtual interface.
+    virtual std::shared_ptr<AbstractPipeline> createPipeline(
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer) const;
+
 
     // GLSL Plug-in interface
     virtual void installPlugin(
@@ -85,6 +93,29 @@ public:
             const glm::dvec3 vp[],
             const MeshHex& hex) const = 0;
 
+    // Qualities of elements [first, last) written in qualities[0, last-first).
+    // Evaluators may override these to evaluate several elements at once.
+    virtual void tetQualities(
+            const Mesh& mesh,
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer,
+            size_t first, size_t last,
+            double qualities[]) const;
+
+    virtual void priQualities(
+            const Mesh& mesh,
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer,
+            size_t first, size_t last,
+            double qualities[]) const;
+
+    virtual void hexQualities(
+            const Mesh& mesh,
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer,
+            size_t first, size_t last,
+            double qualities[]) const;
+
     virtual double patchQuality(
             const Mesh& mesh,
             const AbstractSampler& sampler,
@@ -115,6 +146,21 @@ public:
             const AbstractMeasurer& measurer,
             QualityHistogram& histogram) const;
 
+    // Evaluates again the elements around the vertices moved since the
+    // last commit of mesh's quality cache, whose histogram must be built.
+    // Histogram is set to the cache's updated histogram.
+    virtual void updateMeshQualitySerial(
+            const Mesh& mesh,
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer,
+            QualityHistogram& histogram) const;
+
+    virtual void updateMeshQualityThread(
+            const Mesh& mesh,
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer,
+            QualityHistogram& histogram) const;
+
     virtual void evaluateMeshQualityGlsl(
             const Mesh& mesh,
             const AbstractSampler& sampler,
@@ -136,6 +182,11 @@ public:
 
 
 protected:
+    friend class AbstractPipeline;
+
+    template<typename Evaluator, typename Measurer, typename Sampler>
+    friend class Pipeline;
+
     virtual void accumulatePatchQuality(
             double& patchQuality,
             double& patchWeight,
@@ -145,11 +196,46 @@ protected:
             double patchQuality,
             double patchWeight) const;
 
+    double elementQuality(
+            const Mesh& mesh,
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer,
+            const MeshNeigElem& elem) const;
+
+    void evaluateElementRanges(
+            const Mesh& mesh,
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer,
+            size_t tetBeg, size_t tetEnd,
+            size_t priBeg, size_t priEnd,
+            size_t hexBeg, size_t hexEnd,
+            QualityHistogram& histogram) const;
+
+    typedef void (AbstractEvaluator::*BatchQualityFunc)(
+            const Mesh&,
+            const AbstractSampler&,
+            const AbstractMeasurer&,
+            size_t, size_t,
+            double[]) const;
+
+    // Reads clean elements from mesh's quality cache when it is enabled
+    template<typename Elem>
+    void evaluateElementRange(
+            const Mesh& mesh,
+            const std::vector<Elem>& elems,
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer,
+            size_t first, size_t last,
+            BatchQualityFunc batchQualities,
+            QualityHistogram& histogram) const;
+
     static const std::string SERIAL_IMPL_NAME;
     static const std::string THREAD_IMPL_NAME;
     static const std::string GLSL_IMPL_NAME;
     static const std::string CUDA_IMPL_NAME;
 
+    static const size_t QUALITY_BATCH_SIZE;
+
     static const double VALIDITY_EPSILON;
     static const double MAX_INTEGER_VALUE;
 
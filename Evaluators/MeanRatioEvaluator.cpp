@@ -1,6 +1,17 @@
 #include "MeanRatioEvaluator.h"
 
-#include "Measurers/AbstractMeasurer.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <typeinfo>
+
+#include "Measurers/MetricFreeMeasurer.h"
+#include "Measurers/MetricWiseMeasurer.h"
+#include "Samplers/AnalyticSampler.h"
+#include "Samplers/TextureSampler.h"
+#include "Samplers/UniformSampler.h"
+
+#include "Pipeline.h"
 
 using namespace glm;
 
@@ -9,6 +20,319 @@ using namespace glm;
 void installCudaMeanRatioEvaluator();
 
 
+// Batch kernels for the metric free case. Elements are evaluated W at a time
+// : their vertices are gathered in packs of W doubles per component and the
+// corner matrices' determinant and Frobenius norm are computed pack-wise.
+// GCC and Clang get AVX2 (4 lanes) and AVX-512 (8 lanes) versions selected
+// at runtime, other compilers and CPUs run the same code one lane at a time.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MEANRATIO_SIMD
+#define MEANRATIO_INLINE inline __attribute__((always_inline))
+typedef double dpack4 __attribute__((vector_size(4 * sizeof(double))));
+typedef double dpack8 __attribute__((vector_size(8 * sizeof(double))));
+#else
+#define MEANRATIO_INLINE inline
+#endif
+
+namespace
+{
+    // Nonzero entries of Fr_TET_INV and Fr_PRI_INV
+    const double FR_INV_10 = -0.5773502691896257645091;
+    const double FR_INV_11 =  1.154700538379251529018;
+    const double FR_INV_20 = -0.4082482904638630163662;
+    const double FR_INV_22 =  1.224744871391589049099;
+
+    template<typename V>
+    struct PackVec3
+    {
+        V x, y, z;
+    };
+
+    template<typename V>
+    MEANRATIO_INLINE PackVec3<V> operator - (
+            const PackVec3<V>& a, const PackVec3<V>& b)
+    {
+        return {a.x - b.x, a.y - b.y, a.z - b.z};
+    }
+
+    template<typename V>
+    MEANRATIO_INLINE PackVec3<V> operator - (const PackVec3<V>& a)
+    {
+        return {-a.x, -a.y, -a.z};
+    }
+
+    // a*sa + b*sb
+    template<typename V>
+    MEANRATIO_INLINE PackVec3<V> combine(
+            const PackVec3<V>& a, double sa,
+            const PackVec3<V>& b, double sb)
+    {
+        return {a.x*sa + b.x*sb, a.y*sa + b.y*sb, a.z*sa + b.z*sb};
+    }
+
+    template<typename V, int W, typename Elem, int N>
+    MEANRATIO_INLINE void gatherVerts(
+            const MeshVert* verts,
+            const Elem* elems,
+            size_t elemCount,
+            PackVec3<V> vp[N])
+    {
+        double x[N][W], y[N][W], z[N][W];
+
+        // Trailing lanes repeat the last element
+        for(int l=0; l < W; ++l)
+        {
+            const Elem& elem = elems[std::min(size_t(l), elemCount-1)];
+
+            for(int k=0; k < N; ++k)
+            {
+                const glm::dvec3& p = verts[elem.v[k]].p;
+                x[k][l] = p.x;
+                y[k][l] = p.y;
+                z[k][l] = p.z;
+            }
+        }
+
+        for(int k=0; k < N; ++k)
+        {
+            std::memcpy(&vp[k].x, x[k], sizeof(V));
+            std::memcpy(&vp[k].y, y[k], sizeof(V));
+            std::memcpy(&vp[k].z, z[k], sizeof(V));
+        }
+    }
+
+    // Determinant and squared Frobenius norm of Fk = (c0, c1, c2)
+    template<typename V, int W>
+    MEANRATIO_INLINE void cornerTerms(
+            const PackVec3<V>& c0,
+            const PackVec3<V>& c1,
+            const PackVec3<V>& c2,
+            double det[W],
+            double frob2[W])
+    {
+        V d = c0.x * (c1.y*c2.z - c1.z*c2.y) +
+              c0.y * (c1.z*c2.x - c1.x*c2.z) +
+              c0.z * (c1.x*c2.y - c1.y*c2.x);
+
+        V f = c0.x*c0.x + c0.y*c0.y + c0.z*c0.z +
+              c1.x*c1.x + c1.y*c1.y + c1.z*c1.z +
+              c2.x*c2.x + c2.y*c2.y + c2.z*c2.z;
+
+        std::memcpy(det, &d, sizeof(V));
+        std::memcpy(frob2, &f, sizeof(V));
+    }
+
+    // Prism corners are mapped through Fr_PRI_INV
+    template<typename V, int W>
+    MEANRATIO_INLINE void priCornerTerms(
+            const PackVec3<V>& a,
+            const PackVec3<V>& b,
+            const PackVec3<V>& c,
+            double det[W],
+            double frob2[W])
+    {
+        cornerTerms<V, W>(a, combine(a, FR_INV_10, b, FR_INV_11), c, det, frob2);
+    }
+
+    inline double cornerMeanRatio(double det, double frob2)
+    {
+        // Cube root squared is cheaper than pow(|det|, 2/3)
+        double cbrtDet = std::cbrt(std::abs(det));
+        return std::copysign(3.0 * cbrtDet * cbrtDet / frob2, det);
+    }
+
+    template<int K, int W>
+    inline double elementMeanRatio(
+            const double det[K][W],
+            const double frob2[K][W],
+            int lane)
+    {
+        double qualMin = 0.0;
+        double invSum = 0.0;
+        for(int k=0; k < K; ++k)
+        {
+            double qual = cornerMeanRatio(det[k][lane], frob2[k][lane]);
+            if(k == 0 || qual < qualMin) qualMin = qual;
+            invSum += 1.0 / qual;
+        }
+
+        // Minimum of invalid elements' corners, harmonic mean otherwise
+        if(qualMin <= 0.0)
+            return qualMin;
+        else
+            return K / invSum;
+    }
+
+    template<typename V, int W>
+    MEANRATIO_INLINE void tetMeanRatios(
+            const MeshVert* verts,
+            const MeshTet* tets,
+            size_t tetCount,
+            double qualities[])
+    {
+        for(size_t b=0; b < tetCount; b += W)
+        {
+            size_t laneCount = std::min(size_t(W), tetCount - b);
+
+            PackVec3<V> vp[4];
+            gatherVerts<V, W, MeshTet, 4>(verts, tets + b, laneCount, vp);
+
+            PackVec3<V> e03 = vp[3] - vp[0];
+            PackVec3<V> e13 = vp[3] - vp[1];
+            PackVec3<V> e23 = vp[3] - vp[2];
+
+            // Fk0 = dmat3(e03, e13, e23) * Fr_TET_INV
+            PackVec3<V> Fk1 = combine(e03, FR_INV_10, e13, FR_INV_11);
+            PackVec3<V> Fk2 = combine(e03, FR_INV_20, e13, FR_INV_20);
+            Fk2 = combine(Fk2, 1.0, e23, FR_INV_22);
+
+            double det[1][W], frob2[1][W];
+            cornerTerms<V, W>(e03, Fk1, Fk2, det[0], frob2[0]);
+
+            for(size_t l=0; l < laneCount; ++l)
+                qualities[b + l] = cornerMeanRatio(det[0][l], frob2[0][l]);
+        }
+    }
+
+    template<typename V, int W>
+    MEANRATIO_INLINE void priMeanRatios(
+            const MeshVert* verts,
+            const MeshPri* pris,
+            size_t priCount,
+            double qualities[])
+    {
+        for(size_t b=0; b < priCount; b += W)
+        {
+            size_t laneCount = std::min(size_t(W), priCount - b);
+
+            PackVec3<V> vp[6];
+            gatherVerts<V, W, MeshPri, 6>(verts, pris + b, laneCount, vp);
+
+            PackVec3<V> e03 = vp[3] - vp[0];
+            PackVec3<V> e14 = vp[4] - vp[1];
+            PackVec3<V> e25 = vp[5] - vp[2];
+            PackVec3<V> e01 = vp[1] - vp[0];
+            PackVec3<V> e12 = vp[2] - vp[1];
+            PackVec3<V> e20 = vp[0] - vp[2];
+            PackVec3<V> e34 = vp[4] - vp[3];
+            PackVec3<V> e45 = vp[5] - vp[4];
+            PackVec3<V> e53 = vp[3] - vp[5];
+
+            double det[6][W], frob2[6][W];
+            priCornerTerms<V, W>(-e01, e20, e03, det[0], frob2[0]);
+            priCornerTerms<V, W>(-e12, e01, e14, det[1], frob2[1]);
+            priCornerTerms<V, W>(-e20, e12, e25, det[2], frob2[2]);
+            priCornerTerms<V, W>(-e34, e53, e03, det[3], frob2[3]);
+            priCornerTerms<V, W>(-e45, e34, e14, det[4], frob2[4]);
+            priCornerTerms<V, W>(-e53, e45, e25, det[5], frob2[5]);
+
+            for(size_t l=0; l < laneCount; ++l)
+                qualities[b + l] = elementMeanRatio<6, W>(det, frob2, l);
+        }
+    }
+
+    template<typename V, int W>
+    MEANRATIO_INLINE void hexMeanRatios(
+            const MeshVert* verts,
+            const MeshHex* hexs,
+            size_t hexCount,
+            double qualities[])
+    {
+        for(size_t b=0; b < hexCount; b += W)
+        {
+            size_t laneCount = std::min(size_t(W), hexCount - b);
+
+            PackVec3<V> vp[8];
+            gatherVerts<V, W, MeshHex, 8>(verts, hexs + b, laneCount, vp);
+
+            PackVec3<V> e01 = vp[1] - vp[0];
+            PackVec3<V> e03 = vp[3] - vp[0];
+            PackVec3<V> e04 = vp[4] - vp[0];
+            PackVec3<V> e12 = vp[2] - vp[1];
+            PackVec3<V> e15 = vp[5] - vp[1];
+            PackVec3<V> e23 = vp[3] - vp[2];
+            PackVec3<V> e26 = vp[6] - vp[2];
+            PackVec3<V> e37 = vp[7] - vp[3];
+            PackVec3<V> e45 = vp[5] - vp[4];
+            PackVec3<V> e47 = vp[7] - vp[4];
+            PackVec3<V> e56 = vp[6] - vp[5];
+            PackVec3<V> e67 = vp[7] - vp[6];
+
+            double det[8][W], frob2[8][W];
+            cornerTerms<V, W>(e01,  e04, -e03, det[0], frob2[0]);
+            cornerTerms<V, W>(e01,  e12,  e15, det[1], frob2[1]);
+            cornerTerms<V, W>(e12,  e26, -e23, det[2], frob2[2]);
+            cornerTerms<V, W>(e03,  e23,  e37, det[3], frob2[3]);
+            cornerTerms<V, W>(e04,  e45,  e47, det[4], frob2[4]);
+            cornerTerms<V, W>(e15, -e56,  e45, det[5], frob2[5]);
+            cornerTerms<V, W>(e26,  e56,  e67, det[6], frob2[6]);
+            cornerTerms<V, W>(e37,  e67, -e47, det[7], frob2[7]);
+
+            for(size_t l=0; l < laneCount; ++l)
+                qualities[b + l] = elementMeanRatio<8, W>(det, frob2, l);
+        }
+    }
+
+
+    struct MeanRatioKernels
+    {
+        void (*tets)(const MeshVert*, const MeshTet*, size_t, double[]);
+        void (*pris)(const MeshVert*, const MeshPri*, size_t, double[]);
+        void (*hexs)(const MeshVert*, const MeshHex*, size_t, double[]);
+    };
+
+    void tetMeanRatiosScalar(const MeshVert* verts, const MeshTet* tets, size_t count, double qualities[])
+        { tetMeanRatios<double, 1>(verts, tets, count, qualities); }
+    void priMeanRatiosScalar(const MeshVert* verts, const MeshPri* pris, size_t count, double qualities[])
+        { priMeanRatios<double, 1>(verts, pris, count, qualities); }
+    void hexMeanRatiosScalar(const MeshVert* verts, const MeshHex* hexs, size_t count, double qualities[])
+        { hexMeanRatios<double, 1>(verts, hexs, count, qualities); }
+
+#if defined(MEANRATIO_SIMD)
+    __attribute__((target("avx2,fma")))
+    void tetMeanRatiosAvx2(const MeshVert* verts, const MeshTet* tets, size_t count, double qualities[])
+        { tetMeanRatios<dpack4, 4>(verts, tets, count, qualities); }
+    __attribute__((target("avx2,fma")))
+    void priMeanRatiosAvx2(const MeshVert* verts, const MeshPri* pris, size_t count, double qualities[])
+        { priMeanRatios<dpack4, 4>(verts, pris, count, qualities); }
+    __attribute__((target("avx2,fma")))
+    void hexMeanRatiosAvx2(const MeshVert* verts, const MeshHex* hexs, size_t count, double qualities[])
+        { hexMeanRatios<dpack4, 4>(verts, hexs, count, qualities); }
+
+    __attribute__((target("avx512f")))
+    void tetMeanRatiosAvx512(const MeshVert* verts, const MeshTet* tets, size_t count, double qualities[])
+        { tetMeanRatios<dpack8, 8>(verts, tets, count, qualities); }
+    __attribute__((target("avx512f")))
+    void priMeanRatiosAvx512(const MeshVert* verts, const MeshPri* pris, size_t count, double qualities[])
+        { priMeanRatios<dpack8, 8>(verts, pris, count, qualities); }
+    __attribute__((target("avx512f")))
+    void hexMeanRatiosAvx512(const MeshVert* verts, const MeshHex* hexs, size_t count, double qualities[])
+        { hexMeanRatios<dpack8, 8>(verts, hexs, count, qualities); }
+#endif
+
+    MeanRatioKernels selectMeanRatioKernels()
+    {
+#if defined(MEANRATIO_SIMD)
+        __builtin_cpu_init();
+
+        if(__builtin_cpu_supports("avx512f"))
+            return {tetMeanRatiosAvx512, priMeanRatiosAvx512, hexMeanRatiosAvx512};
+
+        if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return {tetMeanRatiosAvx2, priMeanRatiosAvx2, hexMeanRatiosAvx2};
+#endif
+
+        return {tetMeanRatiosScalar, priMeanRatiosScalar, hexMeanRatiosScalar};
+    }
+
+    const MeanRatioKernels& meanRatioKernels()
+    {
+        static const MeanRatioKernels kernels = selectMeanRatioKernels();
+        return kernels;
+    }
+}
+
+
 MeanRatioEvaluator::MeanRatioEvaluator() :
     AbstractEvaluator(":/glsl/compute/Evaluating/MeanRatio.glsl", installCudaMeanRatioEvaluator)
 {
@@ -19,6 +343,50 @@ MeanRatioEvaluator::~MeanRatioEvaluator()
 
 }
 
+std::shared_ptr<AbstractPipeline> MeanRatioEvaluator::createPipeline(
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer) const
+{
+    // Subclasses may compute qualities differently
+    if(typeid(*this) != typeid(MeanRatioEvaluator))
+        return AbstractEvaluator::createPipeline(sampler, measurer);
+
+    if(typeid(measurer) == typeid(MetricFreeMeasurer) &&
+       typeid(sampler) == typeid(UniformSampler))
+    {
+        return std::shared_ptr<AbstractPipeline>(
+            new Pipeline<MeanRatioEvaluator, MetricFreeMeasurer, UniformSampler>(
+                *this,
+                static_cast<const MetricFreeMeasurer&>(measurer),
+                static_cast<const UniformSampler&>(sampler)));
+    }
+    else if(typeid(measurer) == typeid(MetricWiseMeasurer))
+    {
+        const MetricWiseMeasurer& metricWise =
+            static_cast<const MetricWiseMeasurer&>(measurer);
+
+        // metricAt() is final in these samplers : their
+        // subclasses (e.g. computed textures) are covered too
+        if(const TextureSampler* texture =
+                dynamic_cast<const TextureSampler*>(&sampler))
+        {
+            return std::shared_ptr<AbstractPipeline>(
+                new Pipeline<MeanRatioEvaluator, MetricWiseMeasurer, TextureSampler>(
+                    *this, metricWise, *texture));
+        }
+        else if(const AnalyticSampler* analytic =
+                dynamic_cast<const AnalyticSampler*>(&sampler))
+        {
+            return std::shared_ptr<AbstractPipeline>(
+                new Pipeline<MeanRatioEvaluator, MetricWiseMeasurer, AnalyticSampler>(
+                    *this, metricWise, *analytic));
+        }
+    }
+
+    // Point locating samplers spend their time searching, not dispatching
+    return AbstractEvaluator::createPipeline(sampler, measurer);
+}
+
 double MeanRatioEvaluator::cornerQuality(const dmat3& Fk) const
 {
     double Fk_det = determinant(Fk);
@@ -31,9 +399,10 @@ double MeanRatioEvaluator::cornerQuality(const dmat3& Fk) const
     return sign(Fk_det) * 3.0 * pow(abs(Fk_det), 2.0/3.0) / Fk_frobenius2;
 }
 
+template<typename Sampler, typename Measurer>
 double MeanRatioEvaluator::tetQuality(
-        const AbstractSampler& sampler,
-        const AbstractMeasurer& measurer,
+        const Sampler& sampler,
+        const Measurer& measurer,
         const dvec3 vp[],
         const MeshTet& tet) const
 {
@@ -49,10 +418,11 @@ double MeanRatioEvaluator::tetQuality(
     return qual0;
 }
 
+template<typename Sampler, typename Measurer>
 double MeanRatioEvaluator::priQuality(
-        const AbstractSampler& sampler,
-        const AbstractMeasurer& measurer,
-        const glm::dvec3 vp[],
+        const Sampler& sampler,
+        const Measurer& measurer,
+        const dvec3 vp[],
         const MeshPri& pri) const
 {
     glm::dvec3 e03 = measurer.riemannianSegment(sampler, vp[0], vp[3], pri.c[0]);
@@ -103,10 +473,11 @@ double MeanRatioEvaluator::priQuality(
     }
 }
 
+template<typename Sampler, typename Measurer>
 double MeanRatioEvaluator::hexQuality(
-        const AbstractSampler& sampler,
-        const AbstractMeasurer& measurer,
-        const glm::dvec3 vp[],
+        const Sampler& sampler,
+        const Measurer& measurer,
+        const dvec3 vp[],
         const MeshHex& hex) const
 {
     // Since hex's corner matrix is the identity matrix,
@@ -165,3 +536,88 @@ double MeanRatioEvaluator::hexQuality(
         return mean;
     }
 }
+
+double MeanRatioEvaluator::tetQuality(
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        const dvec3 vp[],
+        const MeshTet& tet) const
+{
+    return tetQuality<AbstractSampler, AbstractMeasurer>(
+        sampler, measurer, vp, tet);
+}
+
+double MeanRatioEvaluator::priQuality(
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        const dvec3 vp[],
+        const MeshPri& pri) const
+{
+    return priQuality<AbstractSampler, AbstractMeasurer>(
+        sampler, measurer, vp, pri);
+}
+
+double MeanRatioEvaluator::hexQuality(
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        const dvec3 vp[],
+        const MeshHex& hex) const
+{
+    return hexQuality<AbstractSampler, AbstractMeasurer>(
+        sampler, measurer, vp, hex);
+}
+
+void MeanRatioEvaluator::tetQualities(
+        const Mesh& mesh,
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        size_t first, size_t last,
+        double qualities[]) const
+{
+    if(!measurer.isMetricFree())
+    {
+        AbstractEvaluator::tetQualities(
+            mesh, sampler, measurer, first, last, qualities);
+        return;
+    }
+
+    // Mean ratio is scale invariant : sampler's scaling is left out
+    meanRatioKernels().tets(mesh.verts.data(),
+        mesh.tets.data() + first, last - first, qualities);
+}
+
+void MeanRatioEvaluator::priQualities(
+        const Mesh& mesh,
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        size_t first, size_t last,
+        double qualities[]) const
+{
+    if(!measurer.isMetricFree())
+    {
+        AbstractEvaluator::priQualities(
+            mesh, sampler, measurer, first, last, qualities);
+        return;
+    }
+
+    meanRatioKernels().pris(mesh.verts.data(),
+        mesh.pris.data() + first, last - first, qualities);
+}
+
+void MeanRatioEvaluator::hexQualities(
+        const Mesh& mesh,
+        const AbstractSampler& sampler,
+        const AbstractMeasurer& measurer,
+        size_t first, size_t last,
+        double qualities[]) const
+{
+    if(!measurer.isMetricFree())
+    {
+        AbstractEvaluator::hexQualities(
+            mesh, sampler, measurer, first, last, qualities);
+        return;
+    }
+
+    meanRatioKernels().hexs(mesh.verts.data(),
+        mesh.hexs.data() + first, last - first, qualities);
+}
@@ -10,6 +10,11 @@ public:
     MeanRatioEvaluator();
     virtual ~MeanRatioEvaluator();
 
+    // Specialized on the uniform and the texture and analytic samplers
+    virtual std::shared_ptr<AbstractPipeline> createPipeline(
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer) const override;
+
     virtual double tetQuality(
             const AbstractSampler& sampler,
             const AbstractMeasurer& measurer,
@@ -28,8 +33,54 @@ public:
             const glm::dvec3 vp[],
             const MeshHex& hex) const override;
 
+    // Overloads on concrete sampler and measurer types, chosen over the
+    // virtual ones by pipelines. Only defined in this class' source file.
+    template<typename Sampler, typename Measurer>
+    double tetQuality(
+            const Sampler& sampler,
+            const Measurer& measurer,
+            const glm::dvec3 vp[],
+            const MeshTet& tet) const;
+
+    template<typename Sampler, typename Measurer>
+    double priQuality(
+            const Sampler& sampler,
+            const Measurer& measurer,
+            const glm::dvec3 vp[],
+            const MeshPri& pri) const;
+
+    template<typename Sampler, typename Measurer>
+    double hexQuality(
+            const Sampler& sampler,
+            const Measurer& measurer,
+            const glm::dvec3 vp[],
+            const MeshHex& hex) const;
+
+    // Metric free measurers are evaluated by batch kernels
+    // that inline cornerQuality() over many elements at once
+    virtual void tetQualities(
+            const Mesh& mesh,
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer,
+            size_t first, size_t last,
+            double qualities[]) const override;
+
+    virtual void priQualities(
+            const Mesh& mesh,
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer,
+            size_t first, size_t last,
+            double qualities[]) const override;
+
+    virtual void hexQualities(
+            const Mesh& mesh,
+            const AbstractSampler& sampler,
+            const AbstractMeasurer& measurer,
+            size_t first, size_t last,
+            double qualities[]) const override;
+
 protected:
-    virtual double cornerQuality(const glm::dmat3& Fk) const;
+    double cornerQuality(const glm::dmat3& Fk) const;
 };
 
 #endif // GPUMESH_MEANRATIOEVALUATOR
@@ -0,0 +1,71 @@
+#include "Pipeline.h"
+
+#include "AbstractEvaluator.h"
+#include "Measurers/AbstractMeasurer.h"
+#include "Samplers/AbstractSampler.h"
+
+
+const size_t AbstractPipeline::PATCH_BATCH_SIZE;
+
+
+AbstractPipeline::~AbstractPipeline()
+{
+
+}
+
+
+VirtualPipeline::VirtualPipeline(
+        const AbstractEvaluator& evaluator,
+        const AbstractMeasurer& measurer,
+        const AbstractSampler& sampler) :
+    _evaluator(evaluator),
+    _measurer(measurer),
+    _sampler(sampler)
+{
+
+}
+
+VirtualPipeline::~VirtualPipeline()
+{
+
+}
+
+double VirtualPipeline::tetQuality(
+        const glm::dvec3 vp[],
+        const MeshTet& tet) const
+{
+    return _evaluator.tetQuality(_sampler, _measurer, vp, tet);
+}
+
+double VirtualPipeline::priQuality(
+        const glm::dvec3 vp[],
+        const MeshPri& pri) const
+{
+    return _evaluator.priQuality(_sampler, _measurer, vp, pri);
+}
+
+double VirtualPipeline::hexQuality(
+        const glm::dvec3 vp[],
+        const MeshHex& hex) const
+{
+    return _evaluator.hexQuality(_sampler, _measurer, vp, hex);
+}
+
+double VirtualPipeline::patchQuality(
+        const Mesh& mesh,
+        size_t vId) const
+{
+    return _evaluator.patchQuality(mesh, _sampler, _measurer, vId);
+}
+
+void VirtualPipeline::patchQualities(
+        const Mesh& mesh,
+        size_t vId,
+        const glm::dvec3 positions[],
+        size_t count,
+        double qualities[]) const
+{
+    evaluatePatchQualities(
+        _evaluator, _measurer, _sampler,
+        mesh, vId, positions, count, qualities);
+}
@@ -0,0 +1,444 @@
+#ifndef GPUMESH_PIPELINE
+#define GPUMESH_PIPELINE
+
+#include "DataStructures/Mesh.h"
+#include "DataStructures/QualityCache.h"
+
+class AbstractSampler;
+class AbstractMeasurer;
+class AbstractEvaluator;
+
+
+/// Element and patch qualities as computed by a crew's evaluator, measurer
+/// and sampler. Smoothers call them in their hot loops through a single
+/// virtual call, behind which implementations are free to bind the crew's
+/// components statically.
+class AbstractPipeline
+{
+public:
+    virtual ~AbstractPipeline();
+
+
+    virtual double tetQuality(
+            const glm::dvec3 vp[],
+            const MeshTet& tet) const = 0;
+
+    virtual double priQuality(
+            const glm::dvec3 vp[],
+            const MeshPri& pri) const = 0;
+
+    virtual double hexQuality(
+            const glm::dvec3 vp[],
+            const MeshHex& hex) const = 0;
+
+    virtual double patchQuality(
+            const Mesh& mesh,
+            size_t vId) const = 0;
+
+    // Qualities of vertex's patch with the vertex moved to each of the
+    // candidate positions. Mesh is not modified : candidates are only
+    // substituted in the copies of the patch's element positions.
+    virtual void patchQualities(
+            const Mesh& mesh,
+            size_t vId,
+            const glm::dvec3 positions[],
+            size_t count,
+            double qualities[]) const = 0;
+
+    double patchQuality(
+            const Mesh& mesh,
+            size_t vId,
+            const glm::dvec3& position) const;
+
+protected:
+    // Patch elements are visited once per batch of candidates : fixed
+    // vertices are loaded once and only the moving one is replaced
+    template<typename Evaluator, typename Measurer, typename Sampler>
+    static void evaluatePatchQualities(
+            const Evaluator& evaluator,
+            const Measurer& measurer,
+            const Sampler& sampler,
+            const Mesh& mesh,
+            size_t vId,
+            const glm::dvec3 positions[],
+            size_t count,
+            double qualities[]);
+
+    // Returns the index of vId in the element
+    template<typename Elem>
+    static uint gatherPatchElement(
+            const Mesh& mesh,
+            const Elem& elem,
+            size_t vId,
+            glm::dvec3 vp[]);
+
+    static const size_t PATCH_BATCH_SIZE = 64;
+};
+
+
+/// Generic pipeline going through the crew's virtual interfaces
+class VirtualPipeline : public AbstractPipeline
+{
+public:
+    VirtualPipeline(
+            const AbstractEvaluator& evaluator,
+            const AbstractMeasurer& measurer,
+            const AbstractSampler& sampler);
+    virtual ~VirtualPipeline();
+
+
+    virtual double tetQuality(
+            const glm::dvec3 vp[],
+            const MeshTet& tet) const override;
+
+    virtual double priQuality(
+            const glm::dvec3 vp[],
+            const MeshPri& pri) const override;
+
+    virtual double hexQuality(
+            const glm::dvec3 vp[],
+            const MeshHex& hex) const override;
+
+    virtual double patchQuality(
+            const Mesh& mesh,
+            size_t vId) const override;
+
+    virtual void patchQualities(
+            const Mesh& mesh,
+            size_t vId,
+            const glm::dvec3 positions[],
+            size_t count,
+            double qualities[]) const override;
+
+private:
+    const AbstractEvaluator& _evaluator;
+    const AbstractMeasurer& _measurer;
+    const AbstractSampler& _sampler;
+};
+
+
+/// Pipeline instantiated on the crew's concrete types. Evaluator must provide
+/// element quality overloads on the Measurer and Sampler types, and Measurer
+/// riemannian segment overloads on the Sampler type, so that every call
+/// below the pipeline's is resolved at compile time.
+///
+/// Evaluators instantiate it in their own translation unit, where their
+/// element quality templates are defined (see createPipeline()).
+template<typename Evaluator, typename Measurer, typename Sampler>
+class Pipeline : public AbstractPipeline
+{
+public:
+    Pipeline(
+            const Evaluator& evaluator,
+            const Measurer& measurer,
+            const Sampler& sampler);
+
+
+    virtual double tetQuality(
+            const glm::dvec3 vp[],
+            const MeshTet& tet) const override;
+
+    virtual double priQuality(
+            const glm::dvec3 vp[],
+            const MeshPri& pri) const override;
+
+    virtual double hexQuality(
+            const glm::dvec3 vp[],
+            const MeshHex& hex) const override;
+
+    virtual double patchQuality(
+            const Mesh& mesh,
+            size_t vId) const override;
+
+    virtual void patchQualities(
+            const Mesh& mesh,
+            size_t vId,
+            const glm::dvec3 positions[],
+            size_t count,
+            double qualities[]) const override;
+
+private:
+    template<typename Elem>
+    static void gatherPositions(
+            const Mesh& mesh,
+            const Elem& elem,
+            glm::dvec3 vp[]);
+
+    const Evaluator& _evaluator;
+    const Measurer& _measurer;
+    const Sampler& _sampler;
+};
+
+
+
+// IMPLEMENTATION //
+inline double AbstractPipeline::patchQuality(
+        const Mesh& mesh,
+        size_t vId,
+        const glm::dvec3& position) const
+{
+    double quality;
+    patchQualities(mesh, vId, &position, 1, &quality);
+    return quality;
+}
+
+template<typename Evaluator, typename Measurer, typename Sampler>
+void AbstractPipeline::evaluatePatchQualities(
+        const Evaluator& evaluator,
+        const Measurer& measurer,
+        const Sampler& sampler,
+        const Mesh& mesh,
+        size_t vId,
+        const glm::dvec3 positions[],
+        size_t count,
+        double qualities[])
+{
+    const std::vector<MeshTet>& tets = mesh.tets;
+    const std::vector<MeshPri>& pris = mesh.pris;
+    const std::vector<MeshHex>& hexs = mesh.hexs;
+
+    const MeshNeigRange<MeshNeigElem> neigElems = mesh.neighborElems(vId);
+    size_t neigElemCount = neigElems.size();
+
+    // Every element of the patch moves with the vertex :
+    // none of them can be read from the quality cache
+    for(size_t first=0; first < count; first += PATCH_BATCH_SIZE)
+    {
+        size_t batchCount = count - first;
+        if(batchCount > PATCH_BATCH_SIZE)
+            batchCount = PATCH_BATCH_SIZE;
+
+        const glm::dvec3* candidates = positions + first;
+        double* patchQualities = qualities + first;
+        double patchWeights[PATCH_BATCH_SIZE];
+
+        for(size_t c=0; c < batchCount; ++c)
+        {
+            patchQualities[c] = 0.0;
+            patchWeights[c] = 0.0;
+        }
+
+        for(size_t n=0; n < neigElemCount; ++n)
+        {
+            const MeshNeigElem& neigElem = neigElems[n];
+
+            switch(neigElem.type)
+            {
+            case MeshTet::ELEMENT_TYPE:
+            {
+                const MeshTet& tet = tets[neigElem.id];
+                glm::dvec3 vp[MeshTet::VERTEX_COUNT];
+                uint slot = gatherPatchElement(mesh, tet, vId, vp);
+
+                for(size_t c=0; c < batchCount; ++c)
+                {
+                    vp[slot] = candidates[c];
+                    evaluator.accumulatePatchQuality(
+                        patchQualities[c], patchWeights[c],
+                        evaluator.tetQuality(sampler, measurer, vp, tet));
+                }
+                break;
+            }
+
+            case MeshPri::ELEMENT_TYPE:
+            {
+                const MeshPri& pri = pris[neigElem.id];
+                glm::dvec3 vp[MeshPri::VERTEX_COUNT];
+                uint slot = gatherPatchElement(mesh, pri, vId, vp);
+
+                for(size_t c=0; c < batchCount; ++c)
+                {
+                    vp[slot] = candidates[c];
+                    evaluator.accumulatePatchQuality(
+                        patchQualities[c], patchWeights[c],
+                        evaluator.priQuality(sampler, measurer, vp, pri));
+                }
+                break;
+            }
+
+            case MeshHex::ELEMENT_TYPE:
+            {
+                const MeshHex& hex = hexs[neigElem.id];
+                glm::dvec3 vp[MeshHex::VERTEX_COUNT];
+                uint slot = gatherPatchElement(mesh, hex, vId, vp);
+
+                for(size_t c=0; c < batchCount; ++c)
+                {
+                    vp[slot] = candidates[c];
+                    evaluator.accumulatePatchQuality(
+                        patchQualities[c], patchWeights[c],
+                        evaluator.hexQuality(sampler, measurer, vp, hex));
+                }
+                break;
+            }
+            }
+        }
+
+        for(size_t c=0; c < batchCount; ++c)
+        {
+            patchQualities[c] = evaluator.finalizePatchQuality(
+                patchQualities[c], patchWeights[c]);
+        }
+    }
+}
+
+template<typename Elem>
+inline uint AbstractPipeline::gatherPatchElement(
+        const Mesh& mesh,
+        const Elem& elem,
+        size_t vId,
+        glm::dvec3 vp[])
+{
+    uint slot = 0;
+    for(uint v=0; v < Elem::VERTEX_COUNT; ++v)
+    {
+        vp[v] = mesh.verts[elem.v[v]].p;
+        if(elem.v[v] == vId)
+            slot = v;
+    }
+
+    return slot;
+}
+
+template<typename Evaluator, typename Measurer, typename Sampler>
+Pipeline<Evaluator, Measurer, Sampler>::Pipeline(
+        const Evaluator& evaluator,
+        const Measurer& measurer,
+        const Sampler& sampler) :
+    _evaluator(evaluator),
+    _measurer(measurer),
+    _sampler(sampler)
+{
+
+}
+
+template<typename Evaluator, typename Measurer, typename Sampler>
+double Pipeline<Evaluator, Measurer, Sampler>::tetQuality(
+        const glm::dvec3 vp[],
+        const MeshTet& tet) const
+{
+    return _evaluator.tetQuality(_sampler, _measurer, vp, tet);
+}
+
+template<typename Evaluator, typename Measurer, typename Sampler>
+double Pipeline<Evaluator, Measurer, Sampler>::priQuality(
+        const glm::dvec3 vp[],
+        const MeshPri& pri) const
+{
+    return _evaluator.priQuality(_sampler, _measurer, vp, pri);
+}
+
+template<typename Evaluator, typename Measurer, typename Sampler>
+double Pipeline<Evaluator, Measurer, Sampler>::hexQuality(
+        const glm::dvec3 vp[],
+        const MeshHex& hex) const
+{
+    return _evaluator.hexQuality(_sampler, _measurer, vp, hex);
+}
+
+template<typename Evaluator, typename Measurer, typename Sampler>
+double Pipeline<Evaluator, Measurer, Sampler>::patchQuality(
+        const Mesh& mesh,
+        size_t vId) const
+{
+    const std::vector<MeshTet>& tets = mesh.tets;
+    const std::vector<MeshPri>& pris = mesh.pris;
+    const std::vector<MeshHex>& hexs = mesh.hexs;
+
+    const MeshNeigRange<MeshNeigElem> neigElems = mesh.neighborElems(vId);
+
+    // Same as AbstractEvaluator::patchQuality()
+    const QualityCache& cache = mesh.qualityCache();
+    bool useCache = cache.isEnabled();
+
+    size_t neigElemCount = neigElems.size();
+
+    double patchWeight = 0.0;
+    double patchQuality = 0.0;
+    for(size_t n=0; n < neigElemCount; ++n)
+    {
+        const MeshNeigElem& neigElem = neigElems[n];
+
+        double elemQuality = NAN;
+        switch(neigElem.type)
+        {
+        case MeshTet::ELEMENT_TYPE:
+        {
+            const MeshTet& tet = tets[neigElem.id];
+            if(useCache)
+                elemQuality = cache.quality(tet, neigElem.id);
+            if(std::isnan(elemQuality))
+            {
+                glm::dvec3 vp[MeshTet::VERTEX_COUNT];
+                gatherPositions(mesh, tet, vp);
+                elemQuality = _evaluator.tetQuality(_sampler, _measurer, vp, tet);
+            }
+            break;
+        }
+
+        case MeshPri::ELEMENT_TYPE:
+        {
+            const MeshPri& pri = pris[neigElem.id];
+            if(useCache)
+                elemQuality = cache.quality(pri, neigElem.id);
+            if(std::isnan(elemQuality))
+            {
+                glm::dvec3 vp[MeshPri::VERTEX_COUNT];
+                gatherPositions(mesh, pri, vp);
+                elemQuality = _evaluator.priQuality(_sampler, _measurer, vp, pri);
+            }
+            break;
+        }
+
+        case MeshHex::ELEMENT_TYPE:
+        {
+            const MeshHex& hex = hexs[neigElem.id];
+            if(useCache)
+                elemQuality = cache.quality(hex, neigElem.id);
+            if(std::isnan(elemQuality))
+            {
+                glm::dvec3 vp[MeshHex::VERTEX_COUNT];
+                gatherPositions(mesh, hex, vp);
+                elemQuality = _evaluator.hexQuality(_sampler, _measurer, vp, hex);
+            }
+            break;
+        }
+
+        default:
+            continue;
+        }
+
+        _evaluator.Evaluator::accumulatePatchQuality(
+            patchQuality, patchWeight,
+            elemQuality);
+    }
+
+    return _evaluator.Evaluator::finalizePatchQuality(
+        patchQuality, patchWeight);
+}
+
+template<typename Evaluator, typename Measurer, typename Sampler>
+void Pipeline<Evaluator, Measurer, Sampler>::patchQualities(
+        const Mesh& mesh,
+        size_t vId,
+        const glm::dvec3 positions[],
+        size_t count,
+        double qualities[]) const
+{
+    evaluatePatchQualities(
+        _evaluator, _measurer, _sampler,
+        mesh, vId, positions, count, qualities);
+}
+
+template<typename Evaluator, typename Measurer, typename Sampler>
+template<typename Elem>
+inline void Pipeline<Evaluator, Measurer, Sampler>::gatherPositions(
+        const Mesh& mesh,
+        const Elem& elem,
+        glm::dvec3 vp[])
+{
+    for(uint v=0; v < Elem::VERTEX_COUNT; ++v)
+        vp[v] = mesh.verts[elem.v[v]].p;
+}
+
+#endif // GPUMESH_PIPELINE
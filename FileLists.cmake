@@ -26,13 +26,17 @@ SET(GpuMesh_DATASTRUCTURES_HEADERS
     ${GpuMesh_SRC_DIR}/DataStructures/OptionMap.h
     ${GpuMesh_SRC_DIR}/DataStructures/OptimizationPlot.h
     ${GpuMesh_SRC_DIR}/DataStructures/Schedule.h
+    ${GpuMesh_SRC_DIR}/DataStructures/SpinBarrier.h
     ${GpuMesh_SRC_DIR}/DataStructures/Tetrahedralizer.h
     ${GpuMesh_SRC_DIR}/DataStructures/Tetrahedron.h
     ${GpuMesh_SRC_DIR}/DataStructures/TetList.h
     ${GpuMesh_SRC_DIR}/DataStructures/TetPool.h
+    ${GpuMesh_SRC_DIR}/DataStructures/ThreadPool.h
     ${GpuMesh_SRC_DIR}/DataStructures/Triangle.h
     ${GpuMesh_SRC_DIR}/DataStructures/TriSet.h
-    ${GpuMesh_SRC_DIR}/DataStructures/QualityHistogram.h)
+    ${GpuMesh_SRC_DIR}/DataStructures/QualityCache.h
+    ${GpuMesh_SRC_DIR}/DataStructures/QualityHistogram.h
+    ${GpuMesh_SRC_DIR}/DataStructures/SamplingContext.h)
 
 SET(GpuMesh_SAMPLERS_HEADERS
     ${GpuMesh_SRC_DIR}/Samplers/AbstractSampler.h
@@ -47,7 +51,8 @@ SET(GpuMesh_SAMPLERS_HEADERS
 SET(GpuMesh_EVALUATORS_HEADERS
     ${GpuMesh_SRC_DIR}/Evaluators/AbstractEvaluator.h
     ${GpuMesh_SRC_DIR}/Evaluators/MeanRatioEvaluator.h
-    ${GpuMesh_SRC_DIR}/Evaluators/MetricConformityEvaluator.h)
+    ${GpuMesh_SRC_DIR}/Evaluators/MetricConformityEvaluator.h
+    ${GpuMesh_SRC_DIR}/Evaluators/Pipeline.h)
 
 SET(GpuMesh_MEASURERS_HEADERS
     ${GpuMesh_SRC_DIR}/Measurers/AbstractMeasurer.h
@@ -162,10 +167,14 @@ SET(GpuMesh_DATASTRUCTURES_SOURCES
     ${GpuMesh_SRC_DIR}/DataStructures/NodeGroups.cpp
     ${GpuMesh_SRC_DIR}/DataStructures/OptimizationPlot.cpp
     ${GpuMesh_SRC_DIR}/DataStructures/Schedule.cpp
+    ${GpuMesh_SRC_DIR}/DataStructures/SpinBarrier.cpp
     ${GpuMesh_SRC_DIR}/DataStructures/TetList.cpp
     ${GpuMesh_SRC_DIR}/DataStructures/TetPool.cpp
+    ${GpuMesh_SRC_DIR}/DataStructures/ThreadPool.cpp
     ${GpuMesh_SRC_DIR}/DataStructures/TriSet.cpp
-    ${GpuMesh_SRC_DIR}/DataStructures/QualityHistogram.cpp)
+    ${GpuMesh_SRC_DIR}/DataStructures/QualityCache.cpp
+    ${GpuMesh_SRC_DIR}/DataStructures/QualityHistogram.cpp
+    ${GpuMesh_SRC_DIR}/DataStructures/SamplingContext.cpp)
 
 SET(GpuMesh_SAMPLERS_SOURCES
     ${GpuMesh_SRC_DIR}/Samplers/AbstractSampler.cpp
@@ -180,7 +189,8 @@ SET(GpuMesh_SAMPLERS_SOURCES
 SET(GpuMesh_EVALUATORS_SOURCES
     ${GpuMesh_SRC_DIR}/Evaluators/AbstractEvaluator.cpp
     ${GpuMesh_SRC_DIR}/Evaluators/MeanRatioEvaluator.cpp
-    ${GpuMesh_SRC_DIR}/Evaluators/MetricConformityEvaluator.cpp)
+    ${GpuMesh_SRC_DIR}/Evaluators/MetricConformityEvaluator.cpp
+    ${GpuMesh_SRC_DIR}/Evaluators/Pipeline.cpp)
 
 SET(GpuMesh_MEASURERS_SOURCES
     ${GpuMesh_SRC_DIR}/Measurers/AbstractMeasurer.cpp
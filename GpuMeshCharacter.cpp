@@ -21,6 +21,8 @@
 #include <Scaena/StageManagement/Event/StageTime.h>
 
 #include "DataStructures/GpuMesh.h"
+#include "DataStructures/NodeGroups.h"
+#include "DataStructures/ThreadPool.h"
 #include "Samplers/AnalyticSampler.h"
 #include "Samplers/UniformSampler.h"
 #include "Samplers/TextureSampler.h"
@@ -73,6 +75,7 @@ GpuMeshCharacter::GpuMeshCharacter() :
     _camAltitude(0),
     _camDistance(4.0),
     _cameraMan(ECameraMan::Sphere),
+    _renumbering(ERenumbering::None),
     _lightAzimuth(-glm::pi<float>() * 3.5 / 8.0),
     _lightAltitude(-glm::pi<float>() * 2.0 / 4.0),
     _lightDistance(1.0),
@@ -100,6 +103,8 @@ GpuMeshCharacter::GpuMeshCharacter() :
     _availableRenderers("Available Renderers"),
     _availableCameraMen("Available Camera Men"),
     _availableCutTypes("Available Cut Types"),
+    _availableRenumberings("Available Renumberings"),
+    _availableGroupColorings("Available Group Colorings"),
     _availableSerializers("Available Mesh Serializers"),
     _availableDeserializers("Available Mesh Deserializers")
 {
@@ -163,6 +168,19 @@ GpuMeshCharacter::GpuMeshCharacter() :
         {string("Inverted Elements"), ECutType::InvertedElements},
     });
 
+    _availableRenumberings.setDefault("None");
+    _availableRenumberings.setContent({
+        {string("None"),    ERenumbering::None},
+        {string("Morton"),  ERenumbering::Morton},
+        {string("Hilbert"), ERenumbering::Hilbert},
+    });
+
+    _availableGroupColorings.setDefault("Serial");
+    _availableGroupColorings.setContent({
+        {string("Serial"),      EGroupColoring::Serial},
+        {string("Partitioned"), EGroupColoring::Partitioned},
+    });
+
     _availableSerializers.setDefault("json");
     _availableSerializers.setContent({
         {string("json"), shared_ptr<AbstractSerializer>(new JsonSerializer())},
@@ -479,6 +497,16 @@ OptionMapDetails GpuMeshCharacter::availableCutTypes() const
     return _availableCutTypes.details();
 }
 
+OptionMapDetails GpuMeshCharacter::availableRenumberings() const
+{
+    return _availableRenumberings.details();
+}
+
+OptionMapDetails GpuMeshCharacter::availableGroupColorings() const
+{
+    return _availableGroupColorings.details();
+}
+
 void GpuMeshCharacter::generateMesh(
         const std::string& mesherName,
         const std::string& modelName,
@@ -565,6 +593,7 @@ bool GpuMeshCharacter::loadMesh(
             if(metrics.empty()) metrics.resize(getNodeCount(), MeshMetric());
             _computedMetricSmapler->buildBackgroundMesh(*_mesh, metrics);
 
+            _mesh->renumber(_renumbering);
             _mesh->compileTopology();
 
             updateSampling();
@@ -582,6 +611,65 @@ bool GpuMeshCharacter::loadMesh(
     return false;
 }
 
+void GpuMeshCharacter::useRenumbering(const std::string& renumberingName)
+{
+    _availableRenumberings.select(renumberingName, _renumbering);
+}
+
+void GpuMeshCharacter::renumberMesh(const std::string& renumberingName)
+{
+    printStep("Mesh Renumbering "\
+              ": curve=" + renumberingName);
+
+    ERenumbering renumbering;
+    if(_availableRenumberings.select(renumberingName, renumbering))
+    {
+        _mesh->renumber(renumbering);
+        _mesh->compileTopology();
+
+        updateSampling();
+        updateMeshMeasures();
+    }
+}
+
+void GpuMeshCharacter::useGroupColoring(const std::string& coloringName)
+{
+    EGroupColoring coloring;
+    if(_availableGroupColorings.select(coloringName, coloring))
+    {
+        _mesh->nodeGroups().setColoring(coloring);
+
+        // Groups of the current mesh are built again right away
+        if(!_mesh->verts.empty())
+        {
+            printStep("Node Groups Coloring "\
+                      ": coloring=" + coloringName);
+
+            _mesh->compileTopology();
+
+            updateSampling();
+            updateMeshMeasures();
+        }
+    }
+}
+
+void GpuMeshCharacter::setGroupBalancing(bool enabled)
+{
+    _mesh->nodeGroups().setBalancing(enabled);
+
+    // Groups of the current mesh are built again right away
+    if(!_mesh->verts.empty())
+    {
+        printStep(string("Node Groups Balancing ") +
+                  ": " + (enabled ? "on" : "off"));
+
+        _mesh->compileTopology();
+
+        updateSampling();
+        updateMeshMeasures();
+    }
+}
+
 void GpuMeshCharacter::evaluateMesh(
             const std::string& evaluatorName,
             const std::string& implementationName)
@@ -610,6 +698,19 @@ void GpuMeshCharacter::evaluateMesh(
             ": min=" + to_string(histogram.minimumQuality()) +
             ", mean=" + to_string(histogram.harmonicMean()),
              "GpuMeshCharacter"));
+
+        const LocalSampler* localSampler =
+            dynamic_cast<const LocalSampler*>(&_meshCrew->sampler());
+        if(localSampler != nullptr)
+        {
+            getLog().postMessage(new Message('I', false,
+                "Point location walks "\
+                ": count=" + to_string(localSampler->searchCount()) +
+                ", mean=" + to_string(localSampler->averageSearchDepth()) +
+                ", max=" + to_string(localSampler->maxSearchDepth()) +
+                ", overflows=" + to_string(localSampler->walkOverflowCount()),
+                 "GpuMeshCharacter"));
+        }
     }
 }
 
@@ -672,6 +773,22 @@ void GpuMeshCharacter::setMetricDiscretizationDepth(int depth)
     updateMeshMeasures();
 }
 
+OptionMapDetails GpuMeshCharacter::availableMetricIntegrations() const
+{
+    return _meshCrew->availableMetricIntegrations();
+}
+
+void GpuMeshCharacter::useMetricIntegration(const std::string& integrationName)
+{
+    getLog().postMessage(new Message('I', false,
+        "Using metric integration " + integrationName,
+        "GpuMeshCharacter"));
+
+    _meshCrew->setMetricIntegration(*_mesh, integrationName);
+
+    updateMeshMeasures();
+}
+
 void GpuMeshCharacter::setGlslEvaluatorThreadCount(uint threadCount)
 {
     getLog().postMessage(new Message('I', false,
@@ -708,6 +825,25 @@ void GpuMeshCharacter::setCudaSmootherThreadCount(uint threadCount)
     _cudaSmootherThreadCount = threadCount;
 }
 
+void GpuMeshCharacter::setCpuWorkerCount(uint workerCount)
+{
+    getLog().postMessage(new Message('I', false,
+        "Setting CPU worker count to " +
+        (workerCount == 0 ? string("default") : to_string(workerCount)),
+        "GpuMeshCharacter"));
+
+    getThreadPool().setWorkerCount(workerCount);
+}
+
+void GpuMeshCharacter::setCpuWorkerPinning(bool enabled)
+{
+    getLog().postMessage(new Message('I', false,
+        string("Setting CPU worker pinning ") + (enabled ? "on" : "off"),
+        "GpuMeshCharacter"));
+
+    getThreadPool().setPinning(enabled);
+}
+
 void GpuMeshCharacter::smoothMesh(
         const std::string& smootherName,
         const std::string& implementationName,
@@ -1007,10 +1143,11 @@ void GpuMeshCharacter::updateMeshMeasures()
     if(_meshCrew->initialized())
     {
         size_t tetCount = _mesh->tets.size();
+        _mesh->tetValues.resize(tetCount);
         for(size_t e=0; e < tetCount; ++e)
         {
-            MeshTet& elem = _mesh->tets[e];
-            elem.value = _meshCrew->evaluator().tetQuality(
+            const MeshTet& elem = _mesh->tets[e];
+            _mesh->tetValues[e] = _meshCrew->evaluator().tetQuality(
                 *_mesh,
                 _meshCrew->sampler(),
                 _meshCrew->measurer(),
@@ -1018,10 +1155,11 @@ void GpuMeshCharacter::updateMeshMeasures()
         }
 
         size_t priCount = _mesh->pris.size();
+        _mesh->priValues.resize(priCount);
         for(size_t e=0; e < priCount; ++e)
         {
-            MeshPri& elem = _mesh->pris[e];
-            elem.value = _meshCrew->evaluator().priQuality(
+            const MeshPri& elem = _mesh->pris[e];
+            _mesh->priValues[e] = _meshCrew->evaluator().priQuality(
                 *_mesh,
                 _meshCrew->sampler(),
                 _meshCrew->measurer(),
@@ -1029,10 +1167,11 @@ void GpuMeshCharacter::updateMeshMeasures()
         }
 
         size_t hexCount = _mesh->hexs.size();
+        _mesh->hexValues.resize(hexCount);
         for(size_t e=0; e < hexCount; ++e)
         {
-            MeshHex& elem = _mesh->hexs[e];
-            elem.value = _meshCrew->evaluator().hexQuality(
+            const MeshHex& elem = _mesh->hexs[e];
+            _mesh->hexValues[e] = _meshCrew->evaluator().hexQuality(
                 *_mesh,
                 _meshCrew->sampler(),
                 _meshCrew->measurer(),
@@ -1060,8 +1199,7 @@ void GpuMeshCharacter::updateMeshMeasures()
         int vertCount = _mesh->verts.size();
         for(int v=0; v < vertCount; ++v)
         {
-            const MeshTopo& topo = _mesh->topos[v];
-            for(const MeshNeigVert& n : topo.neighborVerts)
+            for(const MeshNeigVert& n : _mesh->neighborVerts(v))
             {
                 if(v < n.v)
                 {
@@ -29,6 +29,8 @@ class AbstractSerializer;
 class AbstractDeserializer;
 class MastersTestSuite;
 enum class ECutType;
+enum class ERenumbering;
+enum class EGroupColoring;
 
 typedef glm::dmat3 MeshMetric;
 
@@ -67,6 +69,8 @@ public:
     virtual OptionMapDetails availableMastersTests() const;
     virtual OptionMapDetails availableCameraMen() const;
     virtual OptionMapDetails availableCutTypes() const;
+    virtual OptionMapDetails availableRenumberings() const;
+    virtual OptionMapDetails availableGroupColorings() const;
 
 
     // Mesh
@@ -85,6 +89,17 @@ public:
     virtual bool loadMesh(
             const std::string& fileName);
 
+    // Curve along which loaded meshes are renumbered
+    virtual void useRenumbering(const std::string& renumberingName);
+
+    virtual void renumberMesh(const std::string& renumberingName);
+
+    // Node groups are built again on the current mesh, if any
+    virtual void useGroupColoring(const std::string& coloringName);
+
+    // Same as useGroupColoring()
+    virtual void setGroupBalancing(bool enabled);
+
 
     // Evaluate
     virtual void evaluateMesh(
@@ -102,6 +117,9 @@ public:
 
     virtual void setMetricDiscretizationDepth(int depth);
 
+    virtual OptionMapDetails availableMetricIntegrations() const;
+    virtual void useMetricIntegration(const std::string& integrationName);
+
     virtual void setGlslEvaluatorThreadCount(uint threadCount);
     virtual void setCudaEvaluatorThreadCount(uint threadCount);
 
@@ -110,6 +128,10 @@ public:
     virtual void setGlslSmootherThreadCount(uint threadCount);
     virtual void setCudaSmootherThreadCount(uint threadCount);
 
+    // A worker count of 0 stands for the hardware's default
+    virtual void setCpuWorkerCount(uint workerCount);
+    virtual void setCpuWorkerPinning(bool enabled);
+
     virtual void smoothMesh(
             const std::string& smootherName,
             const std::string& implementationName,
@@ -169,6 +191,7 @@ protected:
     float _camDistance;
     ECameraMan _cameraMan;
     ECutType _cutType;
+    ERenumbering _renumbering;
     bool _displayBackdrop;
 
     float _lightAzimuth;
@@ -226,6 +249,8 @@ private:
 
     OptionMap<ECameraMan> _availableCameraMen;
     OptionMap<ECutType> _availableCutTypes;
+    OptionMap<ERenumbering> _availableRenumberings;
+    OptionMap<EGroupColoring> _availableGroupColorings;
 };
 
 #endif //GpuMesh_CHARACTER
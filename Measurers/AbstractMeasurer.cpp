@@ -58,6 +58,11 @@ void AbstractMeasurer::setPluginCudaUniforms(
 
 }
 
+bool AbstractMeasurer::isMetricFree() const
+{
+    return false;
+}
+
 double AbstractMeasurer::tetEuclideanVolume(
         const Mesh& mesh,
         const MeshTet& tet)
@@ -141,8 +146,7 @@ double AbstractMeasurer::computeLocalElementSize(
     const std::vector<MeshVert>& verts = mesh.verts;
 
     const glm::dvec3& pos = verts[vId].p;
-    const MeshTopo& topo = mesh.topos[vId];
-    const vector<MeshNeigVert>& neigVerts = topo.neighborVerts;
+    const MeshNeigRange<MeshNeigVert> neigVerts = mesh.neighborVerts(vId);
 
     double totalSize = 0.0;
     size_t neigVertCount = neigVerts.size();
@@ -46,6 +46,11 @@ public:
             const Mesh& mesh) const;
 
 
+    // Metric free measurers reduce riemannian segments to
+    // scaled euclidean ones, which lets evaluators skip sampling
+    virtual bool isMetricFree() const;
+
+
     // Distances
     virtual double riemannianDistance(
             const AbstractSampler& sampler,
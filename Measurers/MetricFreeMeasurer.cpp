@@ -24,13 +24,19 @@ MetricFreeMeasurer::~MetricFreeMeasurer()
 
 }
 
+bool MetricFreeMeasurer::isMetricFree() const
+{
+    return true;
+}
+
 double MetricFreeMeasurer::riemannianDistance(
         const AbstractSampler& sampler,
         const glm::dvec3& a,
         const glm::dvec3& b,
         uint& cachedRefTet) const
 {
-    return glm::distance(a, b) * sampler.scaling();
+    return riemannianDistance<AbstractSampler>(
+        sampler, a, b, cachedRefTet);
 }
 
 glm::dvec3 MetricFreeMeasurer::riemannianSegment(
@@ -39,7 +45,8 @@ glm::dvec3 MetricFreeMeasurer::riemannianSegment(
         const glm::dvec3& b,
         uint& cachedRefTet) const
 {
-    return (b - a) * sampler.scaling();
+    return riemannianSegment<AbstractSampler>(
+        sampler, a, b, cachedRefTet);
 }
 
 double MetricFreeMeasurer::tetVolume(
@@ -114,17 +121,17 @@ glm::dvec3 MetricFreeMeasurer::computeVertexEquilibrium(
     const std::vector<MeshPri>& pris = mesh.pris;
     const std::vector<MeshHex>& hexs = mesh.hexs;
 
-    const MeshTopo& topo = mesh.topos[vId];
+    const MeshNeigRange<MeshNeigElem> neigElems = mesh.neighborElems(vId);
 
 
     double totalWeight = 0.0;
     glm::dvec3 displacement(0.0);
     const glm::dvec3& pos = verts[vId].p;
 
-    uint neigElemCount = topo.neighborElems.size();
+    uint neigElemCount = neigElems.size();
     for(uint n=0; n < neigElemCount; ++n)
     {
-        const MeshNeigElem& neigElem = topo.neighborElems[n];
+        const MeshNeigElem& neigElem = neigElems[n];
 
         switch(neigElem.type)
         {
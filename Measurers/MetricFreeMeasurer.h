@@ -3,6 +3,8 @@
 
 #include "AbstractMeasurer.h"
 
+#include "Samplers/AbstractSampler.h"
+
 
 class MetricFreeMeasurer : public AbstractMeasurer
 {
@@ -11,6 +13,9 @@ public:
     virtual ~MetricFreeMeasurer();
 
 
+    virtual bool isMetricFree() const override;
+
+
     // Distances
     virtual double riemannianDistance(
             const AbstractSampler& sampler,
@@ -24,6 +29,22 @@ public:
             const glm::dvec3& b,
             uint& cachedRefTet) const override;
 
+    // Overloads on concrete sampler types, chosen over
+    // the virtual ones by evaluation pipelines
+    template<typename Sampler>
+    double riemannianDistance(
+            const Sampler& sampler,
+            const glm::dvec3& a,
+            const glm::dvec3& b,
+            uint& cachedRefTet) const;
+
+    template<typename Sampler>
+    glm::dvec3 riemannianSegment(
+            const Sampler& sampler,
+            const glm::dvec3& a,
+            const glm::dvec3& b,
+            uint& cachedRefTet) const;
+
 
     // Volumes
     virtual double tetVolume(
@@ -51,4 +72,27 @@ public:
 protected:
 };
 
+
+
+// IMPLEMENTATION //
+template<typename Sampler>
+inline double MetricFreeMeasurer::riemannianDistance(
+        const Sampler& sampler,
+        const glm::dvec3& a,
+        const glm::dvec3& b,
+        uint& cachedRefTet) const
+{
+    return glm::distance(a, b) * sampler.scaling();
+}
+
+template<typename Sampler>
+inline glm::dvec3 MetricFreeMeasurer::riemannianSegment(
+        const Sampler& sampler,
+        const glm::dvec3& a,
+        const glm::dvec3& b,
+        uint& cachedRefTet) const
+{
+    return (b - a) * sampler.scaling();
+}
+
 #endif // GPUMESH_METRICFREEMEASURER
@@ -1,23 +1,40 @@
 #include "MetricWiseMeasurer.h"
 
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
 #include "DataStructures/Mesh.h"
 
 #include "Samplers/AbstractSampler.h"
 #include "Evaluators/AbstractEvaluator.h"
 
 
-const double DIFF_THRESHOLD = 0.01;
-
 void installCudaMetricWiseMeasurer();
 
 
+const double MetricWiseMeasurer::DIFF_THRESHOLD = 0.01;
+const size_t MetricWiseMeasurer::EDGE_CACHE_SIZE = 1 << 14;
+const size_t MetricWiseMeasurer::ERROR_ESTIMATE_VERT_COUNT = 4096;
+
+const std::string ADAPTIVE_INTEGRATION = "Adaptive";
+
+
 MetricWiseMeasurer::MetricWiseMeasurer() :
     AbstractMeasurer(
         "Metric Wise",
         ":/glsl/compute/Measuring/MetricWise.glsl",
-        installCudaMetricWiseMeasurer)
+        installCudaMetricWiseMeasurer),
+    _integrations("Metric Integrations"),
+    _quadPointCount(0)
 {
-
+    _integrations.setDefault(ADAPTIVE_INTEGRATION);
+    _integrations.setContent({
+        {ADAPTIVE_INTEGRATION, 0},
+        {"Gauss-Legendre 2", 2},
+        {"Gauss-Legendre 3", 3},
+        {"Gauss-Legendre 5", 5}
+    });
 }
 
 MetricWiseMeasurer::~MetricWiseMeasurer()
@@ -25,95 +42,108 @@ MetricWiseMeasurer::~MetricWiseMeasurer()
 
 }
 
-/* Global segment division
-double MetricWiseMeasurer::riemannianDistance(
-        const AbstractSampler& sampler,
-        const glm::dvec3& a,
-        const glm::dvec3& b,
-        uint& cachedRefTet) const
+OptionMapDetails MetricWiseMeasurer::availableIntegrations() const
 {
-    glm::dvec3 abDiff = b - a;
-    glm::dvec3 middle = (a + b) / 2.0;
-    Metric origMetric = sampler.metricAt(middle, cachedRefTet);
-    double dist = glm::sqrt(glm::dot(abDiff, origMetric * abDiff));
-
-    int segmentCount = 1;
-    double err = 1.0;
-    while(err > 1e-5)
-    {
-        segmentCount *= 2;
-        glm::dvec3 segBeg = a;
-        glm::dvec3 ds = abDiff / double(segmentCount);
-        glm::dvec3 half_ds = ds / 2.0;
+    return _integrations.details();
+}
 
-        double newDist = 0.0;
-        for(int i=0; i < segmentCount; ++i)
-        {
-            Metric metric = sampler.metricAt(segBeg + half_ds, cachedRefTet);
-            newDist += glm::sqrt(glm::dot(ds, metric * ds));
-            segBeg += ds;
-        }
+void MetricWiseMeasurer::setIntegration(const std::string& integrationName)
+{
+    int pointCount;
+    if(!_integrations.select(integrationName, pointCount))
+        return;
 
-        err = glm::abs(newDist - dist);
-        dist = newDist;
+    // Gauss-Legendre abscissas and weights on [-1, 1]
+    std::vector<double> x, w;
+    switch(pointCount)
+    {
+    case 2 :
+        x = {-glm::sqrt(1.0/3.0), glm::sqrt(1.0/3.0)};
+        w = {1.0, 1.0};
+        break;
+    case 3 :
+        x = {-glm::sqrt(3.0/5.0), 0.0, glm::sqrt(3.0/5.0)};
+        w = {5.0/9.0, 8.0/9.0, 5.0/9.0};
+        break;
+    case 5 :
+    {
+        double x1 = glm::sqrt(5.0 - 2.0*glm::sqrt(10.0/7.0)) / 3.0;
+        double x2 = glm::sqrt(5.0 + 2.0*glm::sqrt(10.0/7.0)) / 3.0;
+        double w1 = (322.0 + 13.0*glm::sqrt(70.0)) / 900.0;
+        double w2 = (322.0 - 13.0*glm::sqrt(70.0)) / 900.0;
+        x = {-x2, -x1, 0.0, x1, x2};
+        w = {w2, w1, 128.0/225.0, w1, w2};
+        break;
+    }
     }
 
-    return dist;
+    // Mapped on segment's parameter range [0, 1]
+    _quadNodes.clear();
+    _quadWeights.clear();
+    for(size_t i=0; i < x.size(); ++i)
+    {
+        _quadNodes.push_back((1.0 + x[i]) / 2.0);
+        _quadWeights.push_back(w[i] / 2.0);
+    }
+
+    _quadPointCount = pointCount;
 }
 
-/*/ // Localize segment division
-double MetricWiseMeasurer::riemannianDistance(
+void MetricWiseMeasurer::estimateIntegrationError(
+        const Mesh& mesh,
         const AbstractSampler& sampler,
-        const glm::dvec3& a,
-        const glm::dvec3& b,
-        uint& cachedRefTet) const
+        double& meanError,
+        double& maxError) const
 {
-    int curr = 0;
-    int base = 2;
+    meanError = 0.0;
+    maxError = 0.0;
 
-    double len = 0.0;
+    if(_quadPointCount == 0)
+        return;
 
-    glm::dvec3 d = b-a;
-    glm::dvec3 bv = d / double(base);
+    // Edges are gathered from evenly spaced vertices
+    // to bound the cost of the adaptive reference
+    size_t vertCount = mesh.verts.size();
+    size_t stride = std::max(size_t(1), vertCount / ERROR_ESTIMATE_VERT_COUNT);
 
-    while(curr < base)
+    size_t sampleCount = 0;
+    for(size_t vId = 0; vId < vertCount; vId += stride)
     {
-        double p0 = (curr + 0.5) / base;
-        double p1 = (curr + 1.5) / base;
+        const glm::dvec3& a = mesh.verts[vId].p;
+        uint cachedRefTet = mesh.verts[vId].c;
 
-        MeshMetric M0 = sampler.metricAt(a + p0*d, cachedRefTet);
-        MeshMetric M1 = sampler.metricAt(a + p1*d, cachedRefTet);
-
-        double l0 = glm::sqrt(glm::dot(bv, M0 * bv));
-        double l1 = glm::sqrt(glm::dot(bv, M1 * bv));
-
-        double sum = (l0 + l1);
-        double diff = glm::abs(l0 - l1) / (sum/2.0);
-
-        if(diff < DIFF_THRESHOLD)
+        for(const MeshNeigVert& n : mesh.neighborVerts(vId))
         {
-            len += sum;
-            curr += 2;
+            if(n.v < vId)
+                continue;
+
+            const glm::dvec3& b = mesh.verts[n.v].p;
+            double ref = integrateDistance(sampler, a, b, cachedRefTet);
+            double len = quadratureDistance(sampler, a, b, cachedRefTet);
 
-            if((curr & 0b10) == 0)
+            if(ref > 0.0)
             {
-                base >>= 1;
-                curr >>= 1;
+                double err = glm::abs(len - ref) / ref;
+                maxError = glm::max(maxError, err);
+                meanError += err;
+                ++sampleCount;
             }
-
-            bv = d / double(base);
-        }
-        else
-        {
-            base <<= 1;
-            curr <<= 1;
-            bv /= 2.0;
         }
     }
 
-    return len;
+    if(sampleCount != 0)
+        meanError /= sampleCount;
+}
+
+double MetricWiseMeasurer::riemannianDistance(
+        const AbstractSampler& sampler,
+        const glm::dvec3& a,
+        const glm::dvec3& b,
+        uint& cachedRefTet) const
+{
+    return riemannianDistance<AbstractSampler>(
+        sampler, a, b, cachedRefTet);
 }
-// */
 
 glm::dvec3 MetricWiseMeasurer::riemannianSegment(
         const AbstractSampler& sampler,
@@ -121,8 +151,36 @@ glm::dvec3 MetricWiseMeasurer::riemannianSegment(
         const glm::dvec3& b,
         uint& cachedRefTet) const
 {
-    return glm::normalize(b - a) *
-            riemannianDistance(sampler, a, b, cachedRefTet);
+    return riemannianSegment<AbstractSampler>(
+        sampler, a, b, cachedRefTet);
+}
+
+MetricWiseMeasurer::EdgeLength& MetricWiseMeasurer::edgeLengthSlot(
+        const glm::dvec3& a,
+        const glm::dvec3& b)
+{
+    // Direct mapped : a colliding edge simply replaces the entry.
+    // Each thread owns its table, hence no synchronization.
+    std::vector<EdgeLength>& edgeLengths =
+        SamplingContext::local().edgeLengths();
+    if(edgeLengths.size() != EDGE_CACHE_SIZE)
+    {
+        edgeLengths.assign(EDGE_CACHE_SIZE,
+            EdgeLength{glm::dvec3(), glm::dvec3(), 0, 0, 0.0});
+    }
+
+    const double coords[] = {a.x, a.y, a.z, b.x, b.y, b.z};
+
+    uint64_t hash = 14695981039346656037ULL;
+    for(double c : coords)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &c, sizeof(bits));
+        hash = (hash ^ bits) * 1099511628211ULL;
+    }
+    hash ^= hash >> 29;
+
+    return edgeLengths[hash & (EDGE_CACHE_SIZE - 1)];
 }
 
 double MetricWiseMeasurer::tetVolume(
@@ -217,17 +275,17 @@ glm::dvec3 MetricWiseMeasurer::computeVertexEquilibrium(
     const std::vector<MeshPri>& pris = mesh.pris;
     const std::vector<MeshHex>& hexs = mesh.hexs;
 
-    const MeshTopo& topo = mesh.topos[vId];
+    const MeshNeigRange<MeshNeigElem> neigElems = mesh.neighborElems(vId);
 
 
     double totalWeight = 0.0;
     glm::dvec3 displacement(0.0);
     const glm::dvec3& pos = verts[vId].p;
 
-    uint neigElemCount = topo.neighborElems.size();
+    uint neigElemCount = neigElems.size();
     for(uint d=0; d < neigElemCount; ++d)
     {
-        const MeshNeigElem& neigElem = topo.neighborElems[d];
+        const MeshNeigElem& neigElem = neigElems[d];
 
         switch(neigElem.type)
         {
@@ -3,6 +3,10 @@
 
 #include "AbstractMeasurer.h"
 
+#include "Samplers/AbstractSampler.h"
+#include "DataStructures/OptionMap.h"
+#include "DataStructures/SamplingContext.h"
+
 
 class MetricWiseMeasurer : public AbstractMeasurer
 {
@@ -11,6 +15,21 @@ public:
     virtual ~MetricWiseMeasurer();
 
 
+    // Edge length integration
+    virtual OptionMapDetails availableIntegrations() const;
+
+    virtual void setIntegration(const std::string& integrationName);
+
+    // Mean and maximum relative differences between the current
+    // integration and the adaptive one over the edges of the mesh.
+    // Both are 0 when the adaptive integration is used.
+    virtual void estimateIntegrationError(
+            const Mesh& mesh,
+            const AbstractSampler& sampler,
+            double& meanError,
+            double& maxError) const;
+
+
     // Distances
     virtual double riemannianDistance(
             const AbstractSampler& sampler,
@@ -24,6 +43,22 @@ public:
             const glm::dvec3& b,
             uint& cachedRefTet) const override;
 
+    // Overloads on concrete sampler types, chosen over the virtual ones
+    // by evaluation pipelines to inline the whole segment computation
+    template<typename Sampler>
+    double riemannianDistance(
+            const Sampler& sampler,
+            const glm::dvec3& a,
+            const glm::dvec3& b,
+            uint& cachedRefTet) const;
+
+    template<typename Sampler>
+    glm::dvec3 riemannianSegment(
+            const Sampler& sampler,
+            const glm::dvec3& a,
+            const glm::dvec3& b,
+            uint& cachedRefTet) const;
+
 
     // Volumes
     virtual double tetVolume(
@@ -47,6 +82,165 @@ public:
             const Mesh& mesh,
             const AbstractSampler& sampler,
             uint vId) const override;
+
+protected:
+    // Adaptive integration of the metric along segment [a, b]
+    template<typename Sampler>
+    double integrateDistance(
+            const Sampler& sampler,
+            const glm::dvec3& a,
+            const glm::dvec3& b,
+            uint& cachedRefTet) const;
+
+    // Fixed order Gauss-Legendre quadrature of the metric along [a, b]
+    template<typename Sampler>
+    double quadratureDistance(
+            const Sampler& sampler,
+            const glm::dvec3& a,
+            const glm::dvec3& b,
+            uint& cachedRefTet) const;
+
+    // Lengths of the edges last measured by the calling thread, kept in
+    // its sampling context. Entries are keyed on endpoint positions and
+    // on the sampler's metric revision : they go stale as soon as an
+    // endpoint moves. The integration's point count is kept so that
+    // lengths measured under another integration are never returned.
+    typedef SamplingContext::EdgeLength EdgeLength;
+
+    static EdgeLength& edgeLengthSlot(
+            const glm::dvec3& a,
+            const glm::dvec3& b);
+
+    static const double DIFF_THRESHOLD;
+    static const size_t EDGE_CACHE_SIZE;
+    static const size_t ERROR_ESTIMATE_VERT_COUNT;
+
+    // Quadrature point count, 0 for adaptive integration
+    OptionMap<int> _integrations;
+    int _quadPointCount;
+    std::vector<double> _quadNodes;
+    std::vector<double> _quadWeights;
 };
 
+
+
+// IMPLEMENTATION //
+template<typename Sampler>
+inline double MetricWiseMeasurer::riemannianDistance(
+        const Sampler& sampler,
+        const glm::dvec3& a,
+        const glm::dvec3& b,
+        uint& cachedRefTet) const
+{
+    // Edges are integrated from their lowest endpoint so that
+    // both orientations share the same length and cache entry
+    bool isFlipped = b.x < a.x || (b.x == a.x &&
+        (b.y < a.y || (b.y == a.y && b.z < a.z)));
+    const glm::dvec3& e0 = isFlipped ? b : a;
+    const glm::dvec3& e1 = isFlipped ? a : b;
+
+    unsigned int revision = sampler.metricRevision();
+    EdgeLength& slot = edgeLengthSlot(e0, e1);
+    if(slot.revision == revision && slot.pointCount == _quadPointCount &&
+       slot.a == e0 && slot.b == e1)
+        return slot.length;
+
+    double len = _quadPointCount == 0 ?
+        integrateDistance(sampler, e0, e1, cachedRefTet) :
+        quadratureDistance(sampler, e0, e1, cachedRefTet);
+
+    slot.a = e0;
+    slot.b = e1;
+    slot.revision = revision;
+    slot.pointCount = _quadPointCount;
+    slot.length = len;
+
+    return len;
+}
+
+// Localize segment division
+template<typename Sampler>
+double MetricWiseMeasurer::integrateDistance(
+        const Sampler& sampler,
+        const glm::dvec3& a,
+        const glm::dvec3& b,
+        uint& cachedRefTet) const
+{
+    int curr = 0;
+    int base = 2;
+
+    double len = 0.0;
+
+    glm::dvec3 d = b-a;
+    glm::dvec3 bv = d / double(base);
+
+    while(curr < base)
+    {
+        double p0 = (curr + 0.5) / base;
+        double p1 = (curr + 1.5) / base;
+
+        MeshMetric M0 = sampler.metricAt(a + p0*d, cachedRefTet);
+        MeshMetric M1 = sampler.metricAt(a + p1*d, cachedRefTet);
+
+        double l0 = glm::sqrt(glm::dot(bv, M0 * bv));
+        double l1 = glm::sqrt(glm::dot(bv, M1 * bv));
+
+        double sum = (l0 + l1);
+        double diff = glm::abs(l0 - l1) / (sum/2.0);
+
+        if(diff < DIFF_THRESHOLD)
+        {
+            len += sum;
+            curr += 2;
+
+            if((curr & 0b10) == 0)
+            {
+                base >>= 1;
+                curr >>= 1;
+            }
+
+            bv = d / double(base);
+        }
+        else
+        {
+            base <<= 1;
+            curr <<= 1;
+            bv /= 2.0;
+        }
+    }
+
+    return len;
+}
+
+// Constant number of metric samples per edge
+template<typename Sampler>
+inline double MetricWiseMeasurer::quadratureDistance(
+        const Sampler& sampler,
+        const glm::dvec3& a,
+        const glm::dvec3& b,
+        uint& cachedRefTet) const
+{
+    glm::dvec3 d = b - a;
+
+    double len = 0.0;
+    for(int i=0; i < _quadPointCount; ++i)
+    {
+        MeshMetric M = sampler.metricAt(a + _quadNodes[i] * d, cachedRefTet);
+        len += _quadWeights[i] * glm::sqrt(glm::dot(d, M * d));
+    }
+
+    return len;
+}
+
+template<typename Sampler>
+inline glm::dvec3 MetricWiseMeasurer::riemannianSegment(
+        const Sampler& sampler,
+        const glm::dvec3& a,
+        const glm::dvec3& b,
+        uint& cachedRefTet) const
+{
+    return glm::normalize(b - a) *
+            riemannianDistance(sampler, a, b, cachedRefTet);
+}
+
 #endif // GPUMESH_METRICWISEMEASURER
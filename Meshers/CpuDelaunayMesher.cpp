@@ -171,10 +171,8 @@ void CpuDelaunayMesher::genShell(Mesh& mesh, size_t vertexCount)
     }
     for(int v=boundSurfCount; v < vertexCount; ++v)
     {
-        const MeshTopo& topo = mesh.topos[v];
-
         bool isOnInSphere = false;
-        for(const MeshNeigVert& vert : topo.neighborVerts)
+        for(const MeshNeigVert& vert : mesh.neighborVerts(v))
             if(vert.v == vertexCount) {isOnInSphere=true; break;}
 
         if(isOnInSphere)
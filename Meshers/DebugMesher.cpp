@@ -407,10 +407,14 @@ void DebugMesher::genRegularPolyhedra(Mesh& mesh, size_t vertexCount)
     mesh.pris.push_back(MeshPri(9, 10, 11, 12, 13, 14));
     mesh.hexs.push_back(MeshHex(15, 16, 17, 18, 19, 20, 21, 22));
 
-    mesh.tets.front().value = 0.90;
-    mesh.pyrs.front().value = 0.90;
-    mesh.pris.front().value = 0.90;
-    mesh.hexs.front().value = 0.90;
+    mesh.tetValues.assign(mesh.tets.size(), 0.0);
+    mesh.pyrValues.assign(mesh.pyrs.size(), 0.0);
+    mesh.priValues.assign(mesh.pris.size(), 0.0);
+    mesh.hexValues.assign(mesh.hexs.size(), 0.0);
+    mesh.tetValues.front() = 0.90;
+    mesh.pyrValues.front() = 0.90;
+    mesh.priValues.front() = 0.90;
+    mesh.hexValues.front() = 0.90;
 }
 
 void DebugMesher::genDegenerateTetra(Mesh& mesh, size_t vertexCount)
@@ -244,7 +244,7 @@ void ScaffoldRenderer::compileBuffers(
     for(int i=0; i < tetCount; ++i)
     {
         const MeshTet& tet = mesh.tets[i];
-        double qual = tet.value;
+        double qual = mesh.tetValues[i];
         if(qual < qualMins[tet.v[0]]) qualMins[tet.v[0]] = qual;
         if(qual < qualMins[tet.v[1]]) qualMins[tet.v[1]] = qual;
         if(qual < qualMins[tet.v[2]]) qualMins[tet.v[2]] = qual;
@@ -256,7 +256,7 @@ void ScaffoldRenderer::compileBuffers(
     for(int i=0; i < pyrCount; ++i)
     {
         const MeshPyr& pyr = mesh.pyrs[i];
-        double qual = pyr.value;
+        double qual = mesh.pyrValues[i];
         if(qual < qualMins[pyr.v[0]]) qualMins[pyr.v[0]] = qual;
         if(qual < qualMins[pyr.v[1]]) qualMins[pyr.v[1]] = qual;
         if(qual < qualMins[pyr.v[2]]) qualMins[pyr.v[2]] = qual;
@@ -269,7 +269,7 @@ void ScaffoldRenderer::compileBuffers(
     for(int i=0; i < priCount; ++i)
     {
         const MeshPri& pri = mesh.pris[i];
-        double qual = pri.value;
+        double qual = mesh.priValues[i];
         if(qual < qualMins[pri.v[0]]) qualMins[pri.v[0]] = qual;
         if(qual < qualMins[pri.v[1]]) qualMins[pri.v[1]] = qual;
         if(qual < qualMins[pri.v[2]]) qualMins[pri.v[2]] = qual;
@@ -283,7 +283,7 @@ void ScaffoldRenderer::compileBuffers(
     for(int i=0; i < hexCount; ++i)
     {
         const MeshHex& hex = mesh.hexs[i];
-        double qual = hex.value;
+        double qual = mesh.hexValues[i];
         if(qual < qualMins[hex.v[0]]) qualMins[hex.v[0]] = qual;
         if(qual < qualMins[hex.v[1]]) qualMins[hex.v[1]] = qual;
         if(qual < qualMins[hex.v[2]]) qualMins[hex.v[2]] = qual;
@@ -314,7 +314,7 @@ void ScaffoldRenderer::compileBuffers(
         if(qualMins[v] >= _qualityCullingMin &&
            qualMins[v] <= _qualityCullingMax)
         {
-            for(const MeshNeigElem& n : mesh.topos[v].neighborElems)
+            for(const MeshNeigElem& n : mesh.neighborElems(v))
             {
                 if((_tetVisibility && n.type == MeshTet::ELEMENT_TYPE) ||
                    (_pyrVisibility && n.type == MeshPyr::ELEMENT_TYPE) ||
@@ -339,10 +339,11 @@ void ScaffoldRenderer::compileBuffers(
     set<pair<GLuint, GLuint>> edgeSet;
     for(size_t i=0; i < vertCount; ++i)
     {
-        size_t neigVertCount = mesh.topos[i].neighborVerts.size();
+        MeshNeigRange<MeshNeigVert> neigVerts = mesh.neighborVerts(i);
+        size_t neigVertCount = neigVerts.size();
         for(size_t n=0; n < neigVertCount; ++n)
         {
-            int neig = mesh.topos[i].neighborVerts[n];
+            int neig = neigVerts[n];
             if(i < neig)
                 edgeSet.insert(pair<GLuint, GLuint>(i, neig));
             else
@@ -317,7 +317,7 @@ void SurfacicRenderer::compileMeshAttributes(
             }
 
 
-            double quality = tet.value;
+            double quality = mesh.tetValues[i];
             if(quality >= _qualityCullingMin &&
                quality <= _qualityCullingMax)
             {
@@ -385,7 +385,7 @@ void SurfacicRenderer::compileMeshAttributes(
             }
 
 
-            double quality = pyr.value;
+            double quality = mesh.pyrValues[i];
             if(quality >= _qualityCullingMin &&
                quality <= _qualityCullingMax)
             {
@@ -455,7 +455,7 @@ void SurfacicRenderer::compileMeshAttributes(
             }
 
 
-            double quality = pri.value;
+            double quality = mesh.priValues[i];
             if(quality >= _qualityCullingMin &&
                quality <= _qualityCullingMax)
             {
@@ -529,7 +529,7 @@ void SurfacicRenderer::compileMeshAttributes(
             }
 
 
-            double quality = hex.value;
+            double quality = mesh.hexValues[i];
             if(quality >= _qualityCullingMin &&
                quality <= _qualityCullingMax)
             {
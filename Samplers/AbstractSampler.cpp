@@ -1,5 +1,7 @@
 #include "AbstractSampler.h"
 
+#include <atomic>
+
 #include <GLM/gtc/constants.hpp>
 #include <GLM/gtc/matrix_transform.hpp>
 
@@ -14,6 +16,11 @@ void setCudaMetricScalingCube(double scalingCube);
 void setCudaMetricAspectRatio(double aspectRatio);
 void setCudaRotMat(const glm::dmat3& rotMat, const glm::dmat3& rotInv);
 
+
+// Revision 0 is never given out : caches may use it for empty entries
+static std::atomic<unsigned int> g_nextMetricRevision(1);
+
+
 AbstractSampler::AbstractSampler(
         const std::string& name,
         const std::string& shader,
@@ -23,6 +30,7 @@ AbstractSampler::AbstractSampler(
     _scaling3(1.0),
     _aspectRatio(1.0),
     _discretizationDepth(-1),
+    _metricRevision(g_nextMetricRevision++),
     _samplingName(name),
     _samplingShader(shader),
     _baseShader(":/glsl/compute/Sampling/Base.glsl"),
@@ -51,16 +59,27 @@ void AbstractSampler::setScaling(double scaling)
     _scaling = scaling;
     _scaling2 = _scaling * scaling;
     _scaling3 = _scaling2 * scaling;
+
+    notifyMetricUpdate();
 }
 
 void AbstractSampler::setAspectRatio(double ratio)
 {
     _aspectRatio = ratio;
+
+    notifyMetricUpdate();
 }
 
 void AbstractSampler::setDiscretizationDepth(int depth)
 {
     _discretizationDepth = depth;
+
+    notifyMetricUpdate();
+}
+
+void AbstractSampler::notifyMetricUpdate()
+{
+    _metricRevision = g_nextMetricRevision++;
 }
 
 std::string AbstractSampler::samplingShader() const
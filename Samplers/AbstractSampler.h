@@ -50,6 +50,11 @@ public:
     int discretizationDepth() const;
     void setDiscretizationDepth(int depth);
 
+    // Changes every time the metric field may have changed. Revisions
+    // are unique across samplers, so that values derived from sampled
+    // metrics can be cached against them.
+    unsigned int metricRevision() const;
+
 
     // GPU Plug-in interface
     virtual std::string samplingShader() const;
@@ -92,6 +97,9 @@ public:
 
 
 protected:
+    // Must be called whenever sampled metrics change
+    void notifyMetricUpdate();
+
     // Give mesh's provided metric
     MeshMetric vertMetric(const Mesh& mesh, unsigned int vId) const;
     MeshMetric vertMetric(const glm::dvec3& position) const;
@@ -110,6 +118,7 @@ private:
     double _scaling3;
     double _aspectRatio;
     int _discretizationDepth;
+    unsigned int _metricRevision;
     std::string _samplingName;
     std::string _samplingShader;
     std::string _baseShader;
@@ -147,4 +156,9 @@ inline int AbstractSampler::discretizationDepth() const
     return _discretizationDepth;
 }
 
+inline unsigned int AbstractSampler::metricRevision() const
+{
+    return _metricRevision;
+}
+
 #endif // GPUMESH_ABSTRACTSAMPLER
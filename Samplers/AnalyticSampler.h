@@ -23,9 +23,10 @@ public:
             const Mesh& mesh,
             const std::shared_ptr<LocalSampler>& sampler) override;
 
+    // Final : evaluation pipelines call it directly
     virtual MeshMetric metricAt(
             const glm::dvec3& position,
-            uint& cachedRefTet) const override;
+            uint& cachedRefTet) const override final;
 
 
     virtual void releaseDebugMesh() override;
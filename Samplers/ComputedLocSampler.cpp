@@ -60,6 +60,8 @@ void ComputedLocSampler::updateComputedMetric(
         const std::shared_ptr<LocalSampler>& sampler)
 {
     _localSampler = sampler;
+
+    notifyMetricUpdate();
 }
 
 MeshMetric ComputedLocSampler::metricAt(
@@ -37,4 +37,6 @@ void ComputedTexSampler::updateComputedMetric(
         const std::shared_ptr<LocalSampler>& sampler)
 {
     buildGrid(mesh, *sampler);
+
+    notifyMetricUpdate();
 }
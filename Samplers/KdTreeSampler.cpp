@@ -121,6 +121,7 @@ void KdTreeSampler::updateAnalyticalMetric(
     // Clear resources
     _debugMesh.reset();
     _rootNode.reset();
+    notifyMetricUpdate();
 
 
     if(vertCount == 0)
@@ -196,15 +197,17 @@ void KdTreeSampler::updateAnalyticalMetric(
 
     std::vector<MeshTet>& tets = const_cast<std::vector<MeshTet>&>(mesh.tets);
 
-    for(MeshTet& t : tets)
+    mesh.tetValues.resize(tets.size());
+    for(size_t i=0; i < tets.size(); ++i)
     {
+        MeshTet& t = tets[i];
         glm::dvec3 mid = 0.25 * (
             mesh.verts[t.v[0]].p +
             mesh.verts[t.v[1]].p +
             mesh.verts[t.v[2]].p +
             mesh.verts[t.v[3]].p);
        MeshMetric m = metricAt(mid, t.c[0]);
-       t.value = m[0][0];
+       mesh.tetValues[i] = m[0][0];
     }
     */
 }
@@ -435,8 +438,8 @@ void KdTreeSampler::meshTree(KdNode* node, Mesh& mesh)
 
             MeshHex hex(baseVert + 0, baseVert + 1, baseVert + 2, baseVert + 3,
                         baseVert + 4, baseVert + 5, baseVert + 6, baseVert + 7);
-            hex.value = glm::sqrt(25.0 / node->metric[0][0]);
             mesh.hexs.push_back(hex);
+            mesh.hexValues.push_back(glm::sqrt(25.0 / node->metric[0][0]));
         }
     }
     else
@@ -1,13 +1,18 @@
 #include "LocalSampler.h"
 
 #include <array>
+#include <queue>
+#include <atomic>
+#include <algorithm>
 
 #include <CellarWorkbench/Misc/Log.h>
 #include <CellarWorkbench/GL/GlProgram.h>
 
 #include <DataStructures/GpuMesh.h>
-#include <DataStructures/TriSet.h>
+#include <DataStructures/SamplingContext.h>
 #include <DataStructures/Tetrahedralizer.h>
+#include <DataStructures/ThreadPool.h>
+#include <DataStructures/Triangle.h>
 
 using namespace cellar;
 
@@ -24,12 +29,26 @@ void updateCudaRefMetrics(
         const std::vector<GpuMetric>& refMetricsBuff);
 
 
+// Point location
+const double START_GRID_TETS_PER_CELL = 4.0;
+const int MAX_WALK_LENGTH = 1024;
+
+inline glm::dvec3 tetCenter(
+        const std::vector<MeshVert>& verts,
+        const MeshLocalTet& tet)
+{
+    return 0.25 * (verts[tet.v[0]].p + verts[tet.v[1]].p +
+                   verts[tet.v[2]].p + verts[tet.v[3]].p);
+}
+
+
 LocalSampler::LocalSampler(const std::string& name) :
     AbstractSampler(name, ":/glsl/compute/Sampling/Local.glsl", installCudaLocalSampler),
     _debugMesh(nullptr),
     _localTetsSsbo(0),
     _refVertsSsbo(0),
-    _refMetricsSsbo(0)
+    _refMetricsSsbo(0),
+    _startGridSize(0)
 {
 }
 
@@ -38,7 +57,8 @@ LocalSampler::LocalSampler() :
     _debugMesh(nullptr),
     _localTetsSsbo(0),
     _refVertsSsbo(0),
-    _refMetricsSsbo(0)
+    _refMetricsSsbo(0),
+    _startGridSize(0)
 {
 }
 
@@ -213,80 +233,97 @@ MeshMetric LocalSampler::metricAt(
         const glm::dvec3& position,
         uint& cachedRefTet) const
 {
-    const MeshLocalTet* tet = &_localTets[cachedRefTet];
+    // The thread's last located tet is usually the closest one
+    // since consecutive queries sample the same neighborhood
+    SamplingContext& context = SamplingContext::local();
+    unsigned int revision = metricRevision();
+
+    uint hintTet;
+    if(!context.refTetHint(revision, hintTet))
+        hintTet = cachedRefTet;
+
+    const MeshLocalTet* tet = &_localTets[hintTet];
 
     double coor[4];
+    int searchDepth = 0;
+    bool isOverflow = false;
     bool isUnreachable = false;
 
-    while(!isUnreachable && !tetParams(_refVerts, *tet, position, coor))
+    if(!tetParams(_refVerts, *tet, position, coor))
     {
-        glm::dvec3 vp[] = {
-            _refVerts[tet->v[0]].p,
-            _refVerts[tet->v[1]].p,
-            _refVerts[tet->v[2]].p,
-            _refVerts[tet->v[3]].p
+        // Hints may be far from the sample when they are stale.
+        // Start from the closest of the hints and the grid's tet.
+        const MeshLocalTet* candidates[] = {
+            &_localTets[cachedRefTet],
+            &_localTets[startTet(position)]
         };
 
-        glm::dvec3 orig = 0.25 * (vp[0] + vp[1] + vp[2] + vp[3]);
-        glm::dvec3 dir = glm::normalize(orig - position);
-
-        int t = 4;
-        int trialCount = -1;
-        while(t == 4 && !isUnreachable)
+        bool isIn = false;
+        glm::dvec3 dist = tetCenter(_refVerts, *tet) - position;
+        double minDist2 = glm::dot(dist, dist);
+        const MeshLocalTet* closestTet = tet;
+        for(const MeshLocalTet* candidate : candidates)
         {
-            // Find exit face
-            for(t = 0; t < 4; ++t)
-            {
-                if(triIntersect(
-                    vp[MeshTet::tris[t].v[0]],
-                    vp[MeshTet::tris[t].v[1]],
-                    vp[MeshTet::tris[t].v[2]],
-                    orig, dir))
-                {
-                    if(tet->n[t] != -1)
-                        tet = &_localTets[tet->n[t]];
-                    else
-                        isUnreachable = true;
+            if(candidate == tet)
+                continue;
 
-                    break;
-                }
+            dist = tetCenter(_refVerts, *candidate) - position;
+            double dist2 = glm::dot(dist, dist);
+            if(dist2 < minDist2)
+            {
+                minDist2 = dist2;
+                closestTet = candidate;
             }
+        }
 
-            // If exit face not found
-            if(t == 4)
-            {
-                // Start from an other position in the tet
-                ++trialCount;
+        if(closestTet != tet)
+        {
+            tet = closestTet;
+            ++searchDepth;
 
-                // If there are still untried positions
-                if(trialCount < 4)
-                {
-                    const double INV_MASS = 1.0 / 10.0;
-                    const double WEIGHTS[] = {1.0, 2.0, 3.0, 4.0};
+            isIn = tetParams(_refVerts, *tet, position, coor);
+        }
 
-                    // Initialize ray from next position
-                    orig = INV_MASS * (
-                        WEIGHTS[(trialCount + 0) % 4] * vp[0] +
-                        WEIGHTS[(trialCount + 1) % 4] * vp[1] +
-                        WEIGHTS[(trialCount + 2) % 4] * vp[2] +
-                        WEIGHTS[(trialCount + 3) % 4] * vp[3]);
+        // Barycentric walk : cross the face opposite to the most
+        // negative coordinate until the sample lies in the tet
+        while(!isIn)
+        {
+            uint exitFace = 4;
+            for(uint f=0; f < 4; ++f)
+            {
+                if(coor[f] < 0.0 && tet->n[f] != -1 &&
+                   (exitFace == 4 || coor[f] < coor[exitFace]))
+                    exitFace = f;
+            }
 
-                    dir = glm::normalize(orig - position);
-                }
-                else
-                {
-                    // Get projection on current tet
-                    getLog().postMessage(new Message('E', false,
-                        "Did not find a way out of the tet...",
-                        "LocalSampler"));
+            if(exitFace == 4)
+            {
+                // Sample is outside the reference mesh
+                isUnreachable = true;
+                break;
+            }
 
-                    isUnreachable = true;
-                    break;
-                }
+            // Overflows are reported once the metric is updated
+            if(searchDepth >= MAX_WALK_LENGTH)
+            {
+                isOverflow = true;
+                isUnreachable = true;
+                break;
             }
+
+            tet = &_localTets[tet->n[exitFace]];
+            ++searchDepth;
+
+            isIn = tetParams(_refVerts, *tet, position, coor);
         }
     }
 
+    context.setRefTetHint(revision, tet - _localTets.data());
+
+
+    if(searchDepth != 0)
+        context.recordSearch(revision, searchDepth, isOverflow);
+
 
     if(isUnreachable)
     {
@@ -310,6 +347,31 @@ MeshMetric LocalSampler::metricAt(
            coor[3] * _refMetrics[tet->v[3]];
 }
 
+size_t LocalSampler::searchCount() const
+{
+    return SamplingContext::searchStats(metricRevision()).searchCount;
+}
+
+double LocalSampler::averageSearchDepth() const
+{
+    SamplingContext::SearchStats stats =
+        SamplingContext::searchStats(metricRevision());
+    if(stats.searchCount == 0)
+        return 0.0;
+
+    return double(stats.searchDepthSum) / stats.searchCount;
+}
+
+int LocalSampler::maxSearchDepth() const
+{
+    return SamplingContext::searchStats(metricRevision()).maxSearchDepth;
+}
+
+size_t LocalSampler::walkOverflowCount() const
+{
+    return SamplingContext::searchStats(metricRevision()).overflowCount;
+}
+
 void LocalSampler::releaseDebugMesh()
 {
     _debugMesh.reset();
@@ -338,7 +400,8 @@ const Mesh& LocalSampler::debugMesh()
                 uint v = _debugMesh->verts.size();
                 _debugMesh->verts.push_back(glm::dvec3(s));
                 _debugMesh->tets.push_back(MeshTet(v, v, v, v));
-                _debugMesh->tets.back().value = s.w;
+                _debugMesh->tetValues.resize(_debugMesh->tets.size());
+                _debugMesh->tetValues.back() = s.w;
             }
 
             _debugMesh->modelName = "Local Sampling Mesh";
@@ -362,6 +425,19 @@ void LocalSampler::buildBackgroundMesh(
     _refVerts.shrink_to_fit();
     _refMetrics = metrics;
     _refMetrics.shrink_to_fit();
+    _startTets.clear();
+    _startTets.shrink_to_fit();
+
+    size_t overflowCount = walkOverflowCount();
+    if(overflowCount != 0)
+    {
+        getLog().postMessage(new Message('E', false,
+            "Did not find the tet containing " + std::to_string(overflowCount) +
+            " samples of the previous background mesh", "LocalSampler"));
+    }
+
+    // Outdates edge lengths, point location hints and stats
+    notifyMetricUpdate();
 
 
     // Break prisms and hex into tetrahedra
@@ -377,53 +453,257 @@ void LocalSampler::buildBackgroundMesh(
 
 
     // Find tets neighbors
-    TriSet triSet;
-    size_t bucketCount = pow(double(triCount), 2.0/3.0);
-    triSet.reset(bucketCount);
+    getLog().postMessage(new Message('I', false,
+        "Finding local tets neighborhood", "LocalSampler"));
 
+    connectLocalTets(mesh);
+
+    size_t remTriCount = _surfTris.size();
     getLog().postMessage(new Message('I', false,
-        "Finding local tets neighborhood (bucket="+
-        std::to_string(bucketCount)+")", "LocalSampler"));
+        "Surface triangle count: " + std::to_string(remTriCount) +
+        " / " + std::to_string(triCount), "LocalSampler"));
 
-    for(size_t t=0; t < tetCount; ++t)
+    buildStartGrid(mesh);
+
+    _failedSamples.clear();
+    if(_debugMesh.get() != nullptr)
+    {
+        releaseDebugMesh();
+        debugMesh();
+    }
+}
+
+void LocalSampler::connectLocalTets(const Mesh& mesh)
+{
+    // Faces are bucketed on their smallest vertex, then sorted on their
+    // two other vertices within buckets : matching faces end up side by
+    // side. Buckets are small and are processed concurrently.
+    ThreadPool& pool = getThreadPool();
+    size_t chunkCount = pool.concurrency();
+    size_t tetCount = _localTets.size();
+    size_t vertCount = _refVerts.size();
+
+    auto faceTri = [this](uint face) {
+        const MeshLocalTet& tet = _localTets[face / MeshTet::TRI_COUNT];
+        const MeshTri& tri = MeshTet::tris[face % MeshTet::TRI_COUNT];
+        return Triangle(tet.v[tri[0]], tet.v[tri[1]], tet.v[tri[2]]);
+    };
+
+    std::unique_ptr<std::atomic<uint>[]> vertCounters(
+        new std::atomic<uint>[vertCount]);
+    for(size_t v=0; v < vertCount; ++v)
+        vertCounters[v].store(0, std::memory_order_relaxed);
+
+
+    // Bucket sizes
+    pool.parallelFor(chunkCount, [&](size_t c){
+        size_t tetBeg = (tetCount * c) / chunkCount;
+        size_t tetEnd = (tetCount * (c+1)) / chunkCount;
+        for(size_t f=tetBeg * MeshTet::TRI_COUNT; f < tetEnd * MeshTet::TRI_COUNT; ++f)
+            vertCounters[faceTri(f).v[0]].fetch_add(1, std::memory_order_relaxed);
+    });
+
+    std::vector<uint> bucketBases(vertCount + 1);
+    uint bucketBase = 0;
+    for(size_t v=0; v < vertCount; ++v)
+    {
+        bucketBases[v] = bucketBase;
+        bucketBase += vertCounters[v].load(std::memory_order_relaxed);
+        vertCounters[v].store(bucketBases[v], std::memory_order_relaxed);
+    }
+    bucketBases[vertCount] = bucketBase;
+
+
+    // Faces dealt to their bucket, keyed on their two other vertices
+    struct FaceKey
     {
-        MeshLocalTet& tet = _localTets[t];
-        for(uint s=0; s < MeshTet::TRI_COUNT; ++s)
+        int v1;
+        int v2;
+        uint face;
+
+        bool operator<(const FaceKey& k) const
+        {
+            return v1 < k.v1 || (v1 == k.v1 &&
+                (v2 < k.v2 || (v2 == k.v2 && face < k.face)));
+        }
+    };
+
+    std::vector<FaceKey> keys(tetCount * MeshTet::TRI_COUNT);
+    pool.parallelFor(chunkCount, [&](size_t c){
+        size_t tetBeg = (tetCount * c) / chunkCount;
+        size_t tetEnd = (tetCount * (c+1)) / chunkCount;
+        for(size_t f=tetBeg * MeshTet::TRI_COUNT; f < tetEnd * MeshTet::TRI_COUNT; ++f)
+        {
+            Triangle tri = faceTri(f);
+            uint slot = vertCounters[tri.v[0]].fetch_add(
+                1, std::memory_order_relaxed);
+            keys[slot] = FaceKey{tri.v[1], tri.v[2], uint(f)};
+        }
+    });
+
+
+    // Faces matched within buckets. Faces shared by more than two tets
+    // are paired in tet order, leaving the last one on the surface.
+    std::vector<std::vector<Triangle>> chunkSurfTris(chunkCount);
+    pool.parallelFor(chunkCount, [&](size_t c){
+        size_t vertBeg = (vertCount * c) / chunkCount;
+        size_t vertEnd = (vertCount * (c+1)) / chunkCount;
+
+        for(size_t v=vertBeg; v < vertEnd; ++v)
         {
-            Triangle tri(tet.v[MeshTet::tris[s][0]],
-                         tet.v[MeshTet::tris[s][1]],
-                         tet.v[MeshTet::tris[s][2]]);
-            glm::uvec2 con = triSet.xOrTri(tri, t, s);
+            uint keyBeg = bucketBases[v];
+            uint keyEnd = bucketBases[v+1];
+            std::sort(keys.begin() + keyBeg, keys.begin() + keyEnd);
 
-            uint owner = con[0];
-            uint side = con[1];
-            tet.n[s] = owner;
+            for(uint k=keyBeg; k < keyEnd;)
+            {
+                if(k+1 < keyEnd &&
+                   keys[k].v1 == keys[k+1].v1 &&
+                   keys[k].v2 == keys[k+1].v2)
+                {
+                    uint f0 = keys[k].face;
+                    uint f1 = keys[k+1].face;
+                    _localTets[f0 / MeshTet::TRI_COUNT].n[f0 % MeshTet::TRI_COUNT] = f1 / MeshTet::TRI_COUNT;
+                    _localTets[f1 / MeshTet::TRI_COUNT].n[f1 % MeshTet::TRI_COUNT] = f0 / MeshTet::TRI_COUNT;
+                    k += 2;
+                }
+                else
+                {
+                    chunkSurfTris[c].push_back(
+                        Triangle(v, keys[k].v1, keys[k].v2));
+                    k += 1;
+                }
+            }
+        }
+    });
 
-            if(owner != TriSet::NO_OWNER)
+    _surfTris.clear();
+    for(const std::vector<Triangle>& tris : chunkSurfTris)
+        _surfTris.insert(_surfTris.end(), tris.begin(), tris.end());
+
+
+    // Vertices start their searches from the last tet they belong to
+    for(size_t v=0; v < vertCount; ++v)
+        vertCounters[v].store(0, std::memory_order_relaxed);
+
+    pool.parallelFor(chunkCount, [&](size_t c){
+        size_t tetBeg = (tetCount * c) / chunkCount;
+        size_t tetEnd = (tetCount * (c+1)) / chunkCount;
+        for(size_t t=tetBeg; t < tetEnd; ++t)
+        {
+            for(uint i=0; i < MeshTet::VERTEX_COUNT; ++i)
             {
-                _localTets[owner].n[side] = t;
+                std::atomic<uint>& vertTet = vertCounters[_localTets[t].v[i]];
+                uint last = vertTet.load(std::memory_order_relaxed);
+                while(last < t && !vertTet.compare_exchange_weak(
+                        last, t, std::memory_order_relaxed));
             }
         }
+    });
+
+    pool.parallelFor(chunkCount, [&](size_t c){
+        size_t vertBeg = (vertCount * c) / chunkCount;
+        size_t vertEnd = (vertCount * (c+1)) / chunkCount;
+        for(size_t v=vertBeg; v < vertEnd; ++v)
+            mesh.verts[v].c = vertCounters[v].load(std::memory_order_relaxed);
+    });
+}
 
-        mesh.verts[tet.v[0]].c = t;
-        mesh.verts[tet.v[1]].c = t;
-        mesh.verts[tet.v[2]].c = t;
-        mesh.verts[tet.v[3]].c = t;
-    }
+void LocalSampler::buildStartGrid(const Mesh& mesh)
+{
+    glm::dvec3 minBounds, maxBounds;
+    boundingBox(mesh, minBounds, maxBounds);
+
+    // Flat meshes still get cells of finite size
+    glm::dvec3 extents = maxBounds - minBounds;
+    double maxExtent = glm::max(extents.x, glm::max(extents.y, extents.z));
+    extents = glm::max(extents, glm::dvec3(maxExtent * 1e-3 + 1e-12));
+
+    size_t tetCount = _localTets.size();
+    double cellCount = tetCount / START_GRID_TETS_PER_CELL;
+    double alpha = glm::pow(cellCount / (extents.x*extents.y*extents.z), 1/3.0);
+    _startGridSize = glm::ivec3(glm::round(glm::max(glm::dvec3(1), alpha * extents)));
+    _startGridMin = minBounds;
+    _startGridInvCellExtents = glm::dvec3(_startGridSize) / extents;
 
-    _surfTris = triSet.gather();
-    size_t remTriCount = _surfTris.size();
     getLog().postMessage(new Message('I', false,
-        "Surface triangle count: " + std::to_string(remTriCount) +
-        " / " + std::to_string(triCount), "LocalSampler"));
-    triSet.releaseMemoryPool();
+        "Point location grid size: (" + std::to_string(_startGridSize.x) + ", " +
+                                        std::to_string(_startGridSize.y) + ", " +
+                                        std::to_string(_startGridSize.z) + ")",
+        "LocalSampler"));
 
-    _failedSamples.clear();
-    if(_debugMesh.get() != nullptr)
+    const uint NO_TET = -1;
+    size_t startCount = size_t(_startGridSize.x) * _startGridSize.y * _startGridSize.z;
+    _startTets.assign(startCount, NO_TET);
+
+
+    // Each cell starts from the tet whose centroid is the closest to its center
+    glm::dvec3 cellExtents = extents / glm::dvec3(_startGridSize);
+    std::vector<double> startDists(startCount, INFINITY);
+    for(size_t t=0; t < tetCount; ++t)
     {
-        releaseDebugMesh();
-        debugMesh();
+        glm::dvec3 center = tetCenter(_refVerts, _localTets[t]);
+
+        glm::ivec3 cell = glm::clamp(
+            glm::ivec3((center - _startGridMin) * _startGridInvCellExtents),
+            glm::ivec3(0), _startGridSize - glm::ivec3(1));
+        size_t c = cell.x + _startGridSize.x * (cell.y + size_t(_startGridSize.y) * cell.z);
+
+        glm::dvec3 cellCenter = _startGridMin + cellExtents * (glm::dvec3(cell) + glm::dvec3(0.5));
+        glm::dvec3 dist = center - cellCenter;
+        double dist2 = glm::dot(dist, dist);
+        if(dist2 < startDists[c])
+        {
+            startDists[c] = dist2;
+            _startTets[c] = t;
+        }
     }
 
-    _maxSearchDepth = 0;
+
+    // Empty cells inherit the tet of their closest filled neighbor
+    std::queue<glm::ivec3> front;
+    for(int k=0; k < _startGridSize.z; ++k)
+        for(int j=0; j < _startGridSize.y; ++j)
+            for(int i=0; i < _startGridSize.x; ++i)
+                if(_startTets[i + _startGridSize.x * (j + size_t(_startGridSize.y) * k)] != NO_TET)
+                    front.push(glm::ivec3(i, j, k));
+
+    const glm::ivec3 STEPS[] = {
+        glm::ivec3(-1, 0, 0), glm::ivec3(1, 0, 0),
+        glm::ivec3(0, -1, 0), glm::ivec3(0, 1, 0),
+        glm::ivec3(0, 0, -1), glm::ivec3(0, 0, 1)
+    };
+
+    while(!front.empty())
+    {
+        glm::ivec3 cell = front.front();
+        front.pop();
+
+        uint t = _startTets[cell.x + _startGridSize.x * (cell.y + size_t(_startGridSize.y) * cell.z)];
+
+        for(const glm::ivec3& step : STEPS)
+        {
+            glm::ivec3 n = cell + step;
+            if(n.x < 0 || n.x >= _startGridSize.x ||
+               n.y < 0 || n.y >= _startGridSize.y ||
+               n.z < 0 || n.z >= _startGridSize.z)
+                continue;
+
+            uint& nt = _startTets[n.x + _startGridSize.x * (n.y + size_t(_startGridSize.y) * n.z)];
+            if(nt == NO_TET)
+            {
+                nt = t;
+                front.push(n);
+            }
+        }
+    }
+}
+
+uint LocalSampler::startTet(const glm::dvec3& position) const
+{
+    glm::ivec3 cell = glm::clamp(
+        glm::ivec3((position - _startGridMin) * _startGridInvCellExtents),
+        glm::ivec3(0), _startGridSize - glm::ivec3(1));
+
+    return _startTets[cell.x + _startGridSize.x * (cell.y + size_t(_startGridSize.y) * cell.z)];
 }
@@ -55,8 +55,23 @@ public:
             const Mesh& mesh,
             const std::vector<MeshMetric>& metrics);
 
+    // Point location statistics since last metric update, summed over
+    // the threads' sampling contexts. Only the searches that left their
+    // starting tet are counted. Overflows are walks that were cut short.
+    size_t searchCount() const;
+    double averageSearchDepth() const;
+    int maxSearchDepth() const;
+    size_t walkOverflowCount() const;
+
 
 protected :
+    // Sets local tets' neighbors and gathers surface triangles
+    void connectLocalTets(const Mesh& mesh);
+
+    // Uniform grid of starting tets for point location
+    void buildStartGrid(const Mesh& mesh);
+    uint startTet(const glm::dvec3& position) const;
+
     std::vector<MeshVert> _refVerts;
     std::vector<MeshMetric>   _refMetrics;
     std::vector<MeshLocalTet> _localTets;
@@ -71,8 +86,12 @@ private:
     mutable GLuint _refVertsSsbo;
     mutable GLuint _refMetricsSsbo;
 
+    glm::ivec3 _startGridSize;
+    glm::dvec3 _startGridMin;
+    glm::dvec3 _startGridInvCellExtents;
+    std::vector<uint> _startTets;
+
     // Debug structures
-    mutable int _maxSearchDepth;
     std::vector<Triangle> _surfTris;
     mutable std::vector<glm::dvec4> _failedSamples;
 };
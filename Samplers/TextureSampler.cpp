@@ -264,6 +264,8 @@ void TextureSampler::updateAnalyticalMetric(
     localSampler.updateAnalyticalMetric(mesh);
 
     buildGrid(mesh, localSampler);
+
+    notifyMetricUpdate();
 }
 
 void TextureSampler::updateComputedMetric(
@@ -562,8 +564,8 @@ void TextureSampler::meshGrid(TextureGrid& grid, Mesh& mesh)
                         xt + yt + zt,
                         xb + yt + zt);
 
-                    hex.value = 26.0 / sqrt(_grid->at(cellId)[0][0]);
                     mesh.hexs.push_back(hex);
+                    mesh.hexValues.push_back(26.0 / sqrt(_grid->at(cellId)[0][0]));
                 }
             }
         }
@@ -54,9 +54,10 @@ protected:
 
 
 public:
+    // Final : evaluation pipelines call it directly
     virtual MeshMetric metricAt(
             const glm::dvec3& position,
-            uint& cachedRefTet) const override;
+            uint& cachedRefTet) const override final;
 
 
     virtual void releaseDebugMesh() override;
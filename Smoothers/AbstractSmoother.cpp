@@ -1,5 +1,6 @@
 #include "AbstractSmoother.h"
 
+#include <algorithm>
 #include <chrono>
 #include <iomanip>
 
@@ -7,8 +8,11 @@
 
 #include "Boundaries/Constraints/AbstractConstraint.h"
 #include "DataStructures/MeshCrew.h"
+#include "DataStructures/QualityCache.h"
 #include "DataStructures/QualityHistogram.h"
 #include "Evaluators/AbstractEvaluator.h"
+#include "Measurers/AbstractMeasurer.h"
+#include "Samplers/AbstractSampler.h"
 #include "Topologists/AbstractTopologist.h"
 
 using namespace std;
@@ -18,10 +22,15 @@ using namespace cellar;
 const int AbstractSmoother::INITIAL_PASS_ID = -1;
 const int AbstractSmoother::COMPARE_PASS_ID = -2;
 
+// 95% two-sided normal confidence
+const double AbstractSmoother::ESTIMATE_CONFIDENCE_Z = 1.96;
+
 AbstractSmoother::AbstractSmoother() :
     _glslThreadCount(256),
     _cudaThreadCount(256),
     _smoothingUtilsShader(":/glsl/compute/Smoothing/Utils.glsl"),
+    _meanLowerBound(0.0),
+    _meanUpperBound(1.0),
     _implementationFuncs("Smoothing Implementations")
 {
     using namespace std::placeholders;
@@ -72,6 +81,9 @@ void AbstractSmoother::smoothMesh(
         implementationFunc(mesh, crew);
         auto tEnd = chrono::high_resolution_clock::now();
 
+        // Vertices may be moved freely past this point
+        mesh.qualityCache().disable();
+
         optImpl.passes = _optimizationPasses;
 
         auto dt = chrono::duration_cast<chrono::milliseconds>(tEnd - tStart);
@@ -102,27 +114,23 @@ bool AbstractSmoother::evaluateMeshQualityCuda(Mesh& mesh,  const MeshCrew& crew
 
 bool AbstractSmoother::evaluateMeshQuality(Mesh& mesh,  const MeshCrew& crew, int impl)
 {
-    QualityHistogram histogram;
-    switch(impl)
+    // Estimates read positions on the CPU side : GPU
+    // implementations keep evaluating the whole mesh
+    bool isSampled = _schedule.sampledConvergenceEnabled && impl <= 1;
+
+    // Element ids change with topology modifications
+    if(_relocPassId == INITIAL_PASS_ID || _relocPassId == 0)
     {
-    case 0 :
-        crew.evaluator().evaluateMeshQualitySerial(
-            mesh, crew.sampler(), crew.measurer(), histogram);
-        break;
-    case 1 :
-        crew.evaluator().evaluateMeshQualityThread(
-            mesh, crew.sampler(), crew.measurer(), histogram);
-        break;
-    case 2 :
-        crew.evaluator().evaluateMeshQualityGlsl(
-            mesh, crew.sampler(), crew.measurer(), histogram);
-        break;
-    case 3 :
-        crew.evaluator().evaluateMeshQualityCuda(
-            mesh, crew.sampler(), crew.measurer(), histogram);
-        break;
+        _sampleElems.clear();
+        _worstElems.clear();
     }
 
+    QualityHistogram histogram;
+    if(isSampled)
+        estimateMeshQuality(mesh, crew, histogram);
+    else
+        computeMeshQuality(mesh, crew, impl, histogram);
+
 
     bool continueSmoothing = true;
     auto statsNow = chrono::high_resolution_clock::now();
@@ -132,7 +140,8 @@ bool AbstractSmoother::evaluateMeshQuality(Mesh& mesh,  const MeshCrew& crew, in
         getLog().postMessage(new Message('I', true,
             std::string("Initial mesh quality : ") +
             "min=" + to_string(histogram.minimumQuality()) +
-            "\t mean=" + to_string(histogram.harmonicMean()),
+            "\t mean=" + to_string(histogram.harmonicMean()) +
+            (isSampled ? estimateBounds() : std::string()),
             "AbstractSmoother"));
 
         _lastPassMinQuality = histogram.minimumQuality();
@@ -148,16 +157,14 @@ bool AbstractSmoother::evaluateMeshQuality(Mesh& mesh,  const MeshCrew& crew, in
     }
     else if(_relocPassId == COMPARE_PASS_ID)
     {
-        getLog().postMessage(new Message('I', true,
-            std::string("Topo/Reloc pass quality " +
-                  to_string(_globalPassId) + " : ") +
-            "min=" + to_string(histogram.minimumQuality()) +
-            "\t mean=" + to_string(histogram.harmonicMean()),
-            "AbstractSmoother"));
-
         double minGain = histogram.minimumQuality() - _lastPassMinQuality;
         double geomGain = histogram.harmonicMean() - _lastPassQualityMean;
 
+        // Topology changed since the last pass : both estimates come
+        // from distinct samples. Gains must exceed the sampling noise.
+        if(isSampled && _meanLowerBound > 0.0)
+            geomGain -= _meanUpperBound - _meanLowerBound;
+
         if(_schedule.autoPilotEnabled)
         {
             continueSmoothing = (geomGain > _schedule.minQualThreshold) ||
@@ -168,6 +175,22 @@ bool AbstractSmoother::evaluateMeshQuality(Mesh& mesh,  const MeshCrew& crew, in
             continueSmoothing = _globalPassId < _schedule.globalPassCount;
         }
 
+        // Last pass is reported exactly
+        if(isSampled && !continueSmoothing)
+        {
+            histogram = QualityHistogram();
+            computeMeshQuality(mesh, crew, impl, histogram);
+            isSampled = false;
+        }
+
+        getLog().postMessage(new Message('I', true,
+            std::string("Topo/Reloc pass quality " +
+                  to_string(_globalPassId) + " : ") +
+            "min=" + to_string(histogram.minimumQuality()) +
+            "\t mean=" + to_string(histogram.harmonicMean()) +
+            (isSampled ? estimateBounds() : std::string()),
+            "AbstractSmoother"));
+
         _lastPassMinQuality = histogram.minimumQuality();
         _lastPassQualityMean = histogram.harmonicMean();
 
@@ -176,13 +199,6 @@ bool AbstractSmoother::evaluateMeshQuality(Mesh& mesh,  const MeshCrew& crew, in
     }
     else
     {
-        getLog().postMessage(new Message('I', true,
-            "Smooth pass " + to_string(_globalPassId) + "|" +
-                             to_string(_relocPassId) + " : " +
-            "min=" + to_string(histogram.minimumQuality()) +
-            "\t mean=" + to_string(histogram.harmonicMean()),
-            "AbstractSmoother"));
-
         double minGain = histogram.minimumQuality() - _lastIterationMinQuality;
         double geomGain = histogram.harmonicMean() - _lastIterationQualityMean;
 
@@ -196,6 +212,22 @@ bool AbstractSmoother::evaluateMeshQuality(Mesh& mesh,  const MeshCrew& crew, in
             continueSmoothing = _relocPassId < _schedule.relocationPassCount;
         }
 
+        // Last pass is reported exactly
+        if(isSampled && !continueSmoothing)
+        {
+            histogram = QualityHistogram();
+            computeMeshQuality(mesh, crew, impl, histogram);
+            isSampled = false;
+        }
+
+        getLog().postMessage(new Message('I', true,
+            "Smooth pass " + to_string(_globalPassId) + "|" +
+                             to_string(_relocPassId) + " : " +
+            "min=" + to_string(histogram.minimumQuality()) +
+            "\t mean=" + to_string(histogram.harmonicMean()) +
+            (isSampled ? estimateBounds() : std::string()),
+            "AbstractSmoother"));
+
         OptimizationPass stats;
         stats.histogram = histogram;
         stats.timeStamp = (statsNow - _implBeginTimeStamp).count() / 1.0e9;
@@ -210,7 +242,206 @@ bool AbstractSmoother::evaluateMeshQuality(Mesh& mesh,  const MeshCrew& crew, in
     return continueSmoothing;
 }
 
+void AbstractSmoother::computeMeshQuality(
+        Mesh& mesh,
+        const MeshCrew& crew,
+        int impl,
+        QualityHistogram& histogram)
+{
+    // CPU evaluations keep element qualities from one pass to the
+    // next : only the elements smoothers moved are evaluated again
+    QualityCache& cache = mesh.qualityCache();
+    if(impl <= 1 && !cache.isEnabled())
+        cache.enable(mesh);
+
+    if(cache.isEnabled() && cache.hasHistogram())
+    {
+        // The cache's histogram is patched with moved elements only
+        if(impl == 0)
+            crew.evaluator().updateMeshQualitySerial(
+                mesh, crew.sampler(), crew.measurer(), histogram);
+        else
+            crew.evaluator().updateMeshQualityThread(
+                mesh, crew.sampler(), crew.measurer(), histogram);
+    }
+    else
+    {
+        switch(impl)
+        {
+        case 0 :
+            crew.evaluator().evaluateMeshQualitySerial(
+                mesh, crew.sampler(), crew.measurer(), histogram);
+            break;
+        case 1 :
+            crew.evaluator().evaluateMeshQualityThread(
+                mesh, crew.sampler(), crew.measurer(), histogram);
+            break;
+        case 2 :
+            crew.evaluator().evaluateMeshQualityGlsl(
+                mesh, crew.sampler(), crew.measurer(), histogram);
+            break;
+        case 3 :
+            crew.evaluator().evaluateMeshQualityCuda(
+                mesh, crew.sampler(), crew.measurer(), histogram);
+            break;
+        }
+    }
+
+    if(cache.isEnabled())
+    {
+        if(!cache.hasHistogram())
+            cache.buildHistogram(histogram.bucketCount());
+
+        cache.commitMoves();
+    }
+}
+
+void AbstractSmoother::estimateMeshQuality(
+        const Mesh& mesh,
+        const MeshCrew& crew,
+        QualityHistogram& histogram)
+{
+    const AbstractEvaluator& evaluator = crew.evaluator();
+    const AbstractSampler& sampler = crew.sampler();
+    const AbstractMeasurer& measurer = crew.measurer();
+
+    auto quality = [&](const MeshNeigElem& e) {
+        switch(e.type)
+        {
+        case MeshTet::ELEMENT_TYPE :
+            return evaluator.tetQuality(mesh, sampler, measurer, mesh.tets[e.id]);
+        case MeshPri::ELEMENT_TYPE :
+            return evaluator.priQuality(mesh, sampler, measurer, mesh.pris[e.id]);
+        default :
+            return evaluator.hexQuality(mesh, sampler, measurer, mesh.hexs[e.id]);
+        }
+    };
+
+    if(_sampleElems.empty())
+    {
+        // Pyramids aren't evaluated
+        size_t tetCount = mesh.tets.size();
+        size_t priCount = mesh.pris.size();
+        size_t elemCount = tetCount + priCount + mesh.hexs.size();
+        size_t sampleCount = std::min(elemCount,
+            size_t(std::max(_schedule.convergenceSampleCount, 1)));
+
+        // One element drawn in each of sampleCount equal strata
+        _sampleElems.reserve(sampleCount);
+        for(size_t s=0; s < sampleCount; ++s)
+        {
+            size_t beg = (s * elemCount) / sampleCount;
+            size_t end = ((s+1) * elemCount) / sampleCount;
+            size_t i = std::uniform_int_distribution<size_t>(
+                        beg, end-1)(_sampleRandom);
+
+            if(i < tetCount)
+                _sampleElems.push_back(MeshNeigElem(
+                    i, MeshTet::ELEMENT_TYPE, -1));
+            else if(i < tetCount + priCount)
+                _sampleElems.push_back(MeshNeigElem(
+                    i - tetCount, MeshPri::ELEMENT_TYPE, -1));
+            else
+                _sampleElems.push_back(MeshNeigElem(
+                    i - tetCount - priCount, MeshHex::ELEMENT_TYPE, -1));
+        }
+    }
+
+    size_t sampleCount = _sampleElems.size();
+    std::vector<std::pair<double, MeshNeigElem>> candidates;
+    candidates.reserve(sampleCount + _worstElems.size());
+
+    double invSum = 0.0;
+    double invSquareSum = 0.0;
+    size_t invalidCount = 0;
+    for(const MeshNeigElem& e : _sampleElems)
+    {
+        double q = quality(e);
+        histogram.add(q);
+        candidates.push_back(std::make_pair(q, e));
+
+        if(q > 0.0)
+        {
+            invSum += 1.0 / q;
+            invSquareSum += 1.0 / (q * q);
+        }
+        else
+        {
+            ++invalidCount;
+        }
+    }
+
+    // Worst elements are tracked across passes but kept out of the
+    // histogram, which would otherwise be biased towards them
+    for(const MeshNeigElem& e : _worstElems)
+        candidates.push_back(std::make_pair(quality(e), e));
+
+    auto elemLess = [](const std::pair<double, MeshNeigElem>& a,
+                       const std::pair<double, MeshNeigElem>& b) {
+        return a.second.type < b.second.type ||
+            (a.second.type == b.second.type && a.second.id < b.second.id);
+    };
+    auto elemEqual = [](const std::pair<double, MeshNeigElem>& a,
+                        const std::pair<double, MeshNeigElem>& b) {
+        return a.second.type == b.second.type && a.second.id == b.second.id;
+    };
+    std::sort(candidates.begin(), candidates.end(), elemLess);
+    candidates.erase(std::unique(candidates.begin(), candidates.end(), elemEqual),
+                     candidates.end());
+
+    size_t worstCount = std::min(candidates.size(),
+        size_t(std::max(_schedule.convergenceWorstCount, 0)));
+    std::nth_element(candidates.begin(), candidates.begin() + worstCount, candidates.end(),
+        [](const std::pair<double, MeshNeigElem>& a,
+           const std::pair<double, MeshNeigElem>& b) {
+            return a.first < b.first;
+    });
+
+    _worstElems.clear();
+    double minQuality = histogram.minimumQuality();
+    for(size_t w=0; w < worstCount; ++w)
+    {
+        minQuality = std::min(minQuality, candidates[w].first);
+        _worstElems.push_back(candidates[w].second);
+    }
+    histogram.setMinimumQuality(minQuality);
+
+
+    // Confidence interval of the mean inverse quality,
+    // mapped back onto the harmonic mean
+    _meanLowerBound = 0.0;
+    _meanUpperBound = 1.0;
+
+    size_t validCount = sampleCount - invalidCount;
+    if(invalidCount == 0 && validCount > 1)
+    {
+        double invMean = invSum / validCount;
+        double invVariance = (invSquareSum - validCount * invMean * invMean) /
+                                (validCount - 1);
+        double invError = ESTIMATE_CONFIDENCE_Z *
+                std::sqrt(std::max(invVariance, 0.0) / validCount);
+
+        _meanLowerBound = 1.0 / (invMean + invError);
+        if(invMean - invError > 1.0)
+            _meanUpperBound = 1.0 / (invMean - invError);
+    }
+}
+
+std::string AbstractSmoother::estimateBounds() const
+{
+    return "\t (estimate, mean in [" +
+            to_string(_meanLowerBound) + ", " +
+            to_string(_meanUpperBound) + "])";
+}
+
 std::string AbstractSmoother::smoothingUtilsShader() const
 {
     return _smoothingUtilsShader;
 }
+
+void AbstractSmoother::addImplementation(
+        const std::string& name,
+        const ImplementationFunc& func)
+{
+    _implementationFuncs.addOption(name, func);
+}
@@ -2,6 +2,7 @@
 #define GPUMESH_ABSTRACTSMOOTHER
 
 #include <functional>
+#include <random>
 
 #include <CellarWorkbench/GL/GlProgram.h>
 
@@ -70,8 +71,30 @@ protected:
     bool evaluateMeshQualityCuda(Mesh& mesh, const MeshCrew& crew);
     bool evaluateMeshQuality(Mesh& mesh, const MeshCrew& crew, int impl);
 
+    void computeMeshQuality(
+            Mesh& mesh,
+            const MeshCrew& crew,
+            int impl,
+            QualityHistogram& histogram);
+
+    // Histogram of a stratified sample of elements whose minimum also
+    // covers the tracked worst elements. Updates the mean's bounds.
+    // The sample is drawn once per relocation stage so that the passes
+    // of a stage are compared on the same elements.
+    void estimateMeshQuality(
+            const Mesh& mesh,
+            const MeshCrew& crew,
+            QualityHistogram& histogram);
+
+    std::string estimateBounds() const;
+
     std::string smoothingUtilsShader() const;
 
+    typedef std::function<void(Mesh&, const MeshCrew&)> ImplementationFunc;
+    void addImplementation(
+            const std::string& name,
+            const ImplementationFunc& func);
+
 
     Schedule _schedule;
 
@@ -88,13 +111,21 @@ protected:
     static const int INITIAL_PASS_ID;
     static const int COMPARE_PASS_ID;
 
+    static const double ESTIMATE_CONFIDENCE_Z;
+
 private:
     std::string _smoothingUtilsShader;
 
+    // Sampled convergence estimates
+    std::mt19937 _sampleRandom;
+    std::vector<MeshNeigElem> _sampleElems;
+    std::vector<MeshNeigElem> _worstElems;
+    double _meanLowerBound;
+    double _meanUpperBound;
+
     std::vector<OptimizationPass> _optimizationPasses;
     std::chrono::high_resolution_clock::time_point _implBeginTimeStamp;
 
-    typedef std::function<void(Mesh&, const MeshCrew&)> ImplementationFunc;
     OptionMap<ImplementationFunc> _implementationFuncs;
 };
 
@@ -1,18 +1,22 @@
 #include "AbstractElementWiseSmoother.h"
 
-#include <thread>
 #include <atomic>
-#include <condition_variable>
+#include <memory>
 #include <iostream>
 #include <algorithm>
 #include <numeric>
+#include <cstdint>
 
 #include "VertexAccum.h"
 #include "Boundaries/AbstractBoundary.h"
 #include "DataStructures/MeshCrew.h"
 #include "DataStructures/NodeGroups.h"
+#include "DataStructures/QualityCache.h"
+#include "DataStructures/SpinBarrier.h"
+#include "DataStructures/ThreadPool.h"
 #include "Samplers/AbstractSampler.h"
 #include "Evaluators/AbstractEvaluator.h"
+#include "Evaluators/Pipeline.h"
 #include "Measurers/AbstractMeasurer.h"
 
 using namespace std;
@@ -31,6 +35,7 @@ void updateCudaSmoothedElementsVertices(
 
 
 const size_t AbstractElementWiseSmoother::WORKGROUP_SIZE = 256;
+const size_t AbstractElementWiseSmoother::ELEMENT_CHUNK_SIZE = 512;
 
 
 AbstractElementWiseSmoother::AbstractElementWiseSmoother(
@@ -38,7 +43,6 @@ AbstractElementWiseSmoother::AbstractElementWiseSmoother(
         const installCudaFct installCuda) :
     _initialized(false),
     _smoothShaders(smoothShaders),
-    _vertexAccums(nullptr),
     _accumSsbo(0)
 {
 
@@ -55,10 +59,7 @@ void AbstractElementWiseSmoother::smoothMeshSerial(
         const MeshCrew& crew)
 {
     // Allocate vertex accumulators
-    size_t vertCount = mesh.verts.size();
-    _vertexAccums = new IVertexAccum*[vertCount];
-    for(size_t i=0; i < vertCount; ++i)
-        _vertexAccums[i] = new NotThreadSafeVertexAccum();
+    _vertexAccums.allocate(mesh.verts.size());
 
     size_t tetCount = mesh.tets.size();
     size_t priCount = mesh.pris.size();
@@ -77,9 +78,7 @@ void AbstractElementWiseSmoother::smoothMeshSerial(
 
 
     // Deallocate vertex accumulators
-    for(size_t i=0; i < vertCount; ++i)
-        delete _vertexAccums[i];
-    delete[] _vertexAccums;
+    _vertexAccums.deallocate();
 }
 
 void AbstractElementWiseSmoother::smoothMeshThread(
@@ -87,99 +86,79 @@ void AbstractElementWiseSmoother::smoothMeshThread(
         const MeshCrew& crew)
 {
     // Allocate vertex accumulators
-    size_t vertCount = mesh.verts.size();
-    _vertexAccums = new IVertexAccum*[vertCount];
-    for(size_t i=0; i < vertCount; ++i)
-        _vertexAccums[i] = new ThreadSafeVertexAccum();
+    _vertexAccums.allocate(mesh.verts.size());
 
-/*
-    // TODO : Use a thread pool
-    size_t groupCount = mesh.nodeGroups.size();
-    uint threadCount = thread::hardware_concurrency();    
+    ThreadPool& pool = getThreadPool();
+    uint threadCount = pool.concurrency();
+    mesh.nodeGroups().setCpuWorkerCount(threadCount);
 
-    mesh.nodeGroups().setCpuWorkgroupSize(threadCount);
+    // Topology doesn't change while smoothing
+    vector<vector<uint>> colorChunks;
+    colorElementChunks(mesh, colorChunks);
+    size_t colorCount = colorChunks.size();
 
-
-    _smoothPassId = 0;
-    size_t tetCount = mesh.tets.size();
-    size_t priCount = mesh.pris.size();
-    size_t hexCount = mesh.hexs.size();
+    _relocPassId = 0;
     while(evaluateMeshQualityThread(mesh, crew))
     {
-        std::mutex mutex;
-        std::condition_variable cv;
-        std::atomic<int> done( 0 );
-        std::atomic<int> step( 0 );
-
-        // Accumulated vertex positions
-        vector<thread> workers;
-        for(uint t=0; t < threadCount; ++t)
-        {
-            workers.push_back(thread([&, t]() {
-                // Vertex position accumulation
-                if(tetCount > 0)
+        size_t groupCount = mesh.nodeGroups().count();
+        unique_ptr<atomic<size_t>[]> nextNodeChunks(new atomic<size_t>[groupCount]);
+        for(size_t g=0; g < groupCount; ++g)
+            nextNodeChunks[g].store(0);
+
+        unique_ptr<atomic<size_t>[]> nextElemChunks(new atomic<size_t>[colorCount]);
+        for(size_t c=0; c < colorCount; ++c)
+            nextElemChunks[c].store(0);
+
+        uint teamSize = pool.reserveTeam(threadCount-1);
+        SpinBarrier stepBarrier(teamSize + 1);
+
+        auto member = [&](size_t) {
+            // Vertex position accumulation
+            // Chunks of a color don't share vertices : accumulators
+            // can be written without locks, one color at a time.
+            for(size_t c=0; c < colorCount; ++c)
+            {
+                if(c > 0)
+                    stepBarrier.wait();
+
+                const vector<uint>& chunks = colorChunks[c];
+
+                size_t e = nextElemChunks[c].fetch_add(1);
+                while(e < chunks.size())
                 {
-                    size_t tetfirst = (tetCount * t) / threadCount;
-                    size_t tetLast = (tetCount * (t+1)) / threadCount;
-                    smoothTets(mesh, crew, tetfirst, tetLast);
+                    smoothElementChunk(mesh, crew, chunks[e]);
+                    e = nextElemChunks[c].fetch_add(1);
                 }
+            }
 
-                if(priCount > 0)
-                {
-                    size_t prifirst = (priCount * t) / threadCount;
-                    size_t priLast = (priCount * (t+1)) / threadCount;
-                    smoothPris(mesh, crew, prifirst, priLast);
-                }
+            // Vertex position update step
+            // Nodes of a group don't share elements : they can be moved
+            // at once, once every accumulation and previous group is done.
+            for(size_t g=0; g < groupCount; ++g)
+            {
+                stepBarrier.wait();
 
-                if(hexCount > 0)
-                {
-                    size_t hexfirst = (hexCount * t) / threadCount;
-                    size_t hexLast = (hexCount * (t+1)) / threadCount;
-                    smoothHexs(mesh, crew, hexfirst, hexLast);
-                }
+                const vector<vector<uint>>& chunks =
+                    mesh.nodeGroups().parallelGroups()[g].allNodeChunks;
 
-                for(size_t g=0; g < groupCount; ++g)
+                size_t n = nextNodeChunks[g].fetch_add(1);
+                while(n < chunks.size())
                 {
-                    {
-                        std::unique_lock<std::mutex> lk(mutex);
-                        if(done.fetch_add( 1 ) == threadCount-1)
-                        {
-                            ++step;
-                            done.store( 0 );
-                            cv.notify_all();
-                        }
-                        else
-                        {
-                            cv.wait(lk, [&](){ return step > g; });
-                        }
-                    }
-
-
-                    // Vertex position update step
-                    const std::vector<uint>& group =
-                            mesh.nodeGroups[g];
-
-                    size_t groupSize = group.size();
-                    std::vector<uint> vIds(
-                        group.begin() + (groupSize * t) / threadCount,
-                        group.begin() + (groupSize * (t+1)) / threadCount);
-
-                    updateVertexPositions(mesh, crew, vIds);
+                    updateVertexPositions(mesh, crew, chunks[n]);
+                    n = nextNodeChunks[g].fetch_add(1);
                 }
-            }));
-        }
+            }
+        };
 
-        for(uint t=0; t < threadCount; ++t)
-        {
-            workers[t].join();
-        }
+        // Members wait on each other between steps :
+        // they must all run at once, the caller being the last one.
+        pool.runTeam(teamSize, member, [&](){ member(teamSize); });
+        pool.releaseTeam(teamSize);
     }
-*/
+
 
     // Deallocate vertex accumulators
-    for(size_t i=0; i < vertCount; ++i)
-        delete _vertexAccums[i];
-    delete[] _vertexAccums;
+    _vertexAccums.deallocate();
 }
 
 void AbstractElementWiseSmoother::smoothMeshGlsl(
@@ -410,6 +389,7 @@ void AbstractElementWiseSmoother::updateVertexPositions(
 {
     vector<MeshVert>& verts = mesh.verts;
     const vector<MeshTopo>& topos = mesh.topos;
+    QualityCache& cache = mesh.qualityCache();
 
     size_t vIdCount = vIds.size();
     for(int v = 0; v < vIdCount; ++v)
@@ -417,28 +397,162 @@ void AbstractElementWiseSmoother::updateVertexPositions(
         uint vId = vIds[v];
 
 
-        glm::dvec3 pos = verts[vId].p;
-        glm::dvec3 posPrim = pos;
-        if(_vertexAccums[vId]->assignAverage(posPrim))
+        glm::dvec3 posPrim = verts[vId].p;
+        if(_vertexAccums.assignAverage(vId, posPrim))
         {
             const MeshTopo& topo = topos[vId];
             if(topo.snapToBoundary->isConstrained())
                 posPrim = (*topo.snapToBoundary)(posPrim);
 
             double patchQuality =
-                crew.evaluator().patchQuality(
-                    mesh, crew.sampler(), crew.measurer(), vId);
-
-            verts[vId].p = posPrim;
+                crew.pipeline().patchQuality(
+                    mesh, vId);
 
             double patchQualityPrime =
-                crew.evaluator().patchQuality(
-                    mesh, crew.sampler(), crew.measurer(), vId);
+                crew.pipeline().patchQuality(
+                    mesh, vId, posPrim);
+
+            if(patchQualityPrime >= patchQuality)
+            {
+                cache.moveVertex(vId);
+                verts[vId].p = posPrim;
+            }
+        }
+
+        _vertexAccums.reinit(vId);
+    }
+}
+
+size_t AbstractElementWiseSmoother::elementChunkCount(const Mesh& mesh) const
+{
+    return (mesh.tets.size() + ELEMENT_CHUNK_SIZE - 1) / ELEMENT_CHUNK_SIZE +
+           (mesh.pris.size() + ELEMENT_CHUNK_SIZE - 1) / ELEMENT_CHUNK_SIZE +
+           (mesh.hexs.size() + ELEMENT_CHUNK_SIZE - 1) / ELEMENT_CHUNK_SIZE;
+}
 
-            if(patchQualityPrime < patchQuality)
-                verts[vId].p = pos;
+void AbstractElementWiseSmoother::smoothElementChunk(
+        Mesh& mesh,
+        const MeshCrew& crew,
+        size_t chunk)
+{
+    size_t tetChunkCount = (mesh.tets.size() + ELEMENT_CHUNK_SIZE - 1) / ELEMENT_CHUNK_SIZE;
+    size_t priChunkCount = (mesh.pris.size() + ELEMENT_CHUNK_SIZE - 1) / ELEMENT_CHUNK_SIZE;
+
+    if(chunk < tetChunkCount)
+    {
+        size_t first = chunk * ELEMENT_CHUNK_SIZE;
+        size_t last = glm::min(first + ELEMENT_CHUNK_SIZE, mesh.tets.size());
+        smoothTets(mesh, crew, first, last);
+    }
+    else if(chunk < tetChunkCount + priChunkCount)
+    {
+        size_t first = (chunk - tetChunkCount) * ELEMENT_CHUNK_SIZE;
+        size_t last = glm::min(first + ELEMENT_CHUNK_SIZE, mesh.pris.size());
+        smoothPris(mesh, crew, first, last);
+    }
+    else
+    {
+        size_t first = (chunk - tetChunkCount - priChunkCount) * ELEMENT_CHUNK_SIZE;
+        size_t last = glm::min(first + ELEMENT_CHUNK_SIZE, mesh.hexs.size());
+        smoothHexs(mesh, crew, first, last);
+    }
+}
+
+template<typename Elem>
+void stampChunkVerts(
+        const std::vector<Elem>& elems,
+        size_t first, size_t last,
+        std::vector<uint>& vertStamps,
+        std::vector<uint>& chunkVerts,
+        uint stamp)
+{
+    for(size_t e=first; e < last; ++e)
+    {
+        for(uint i=0; i < Elem::VERTEX_COUNT; ++i)
+        {
+            uint vId = elems[e].v[i];
+            if(vertStamps[vId] != stamp)
+            {
+                vertStamps[vId] = stamp;
+                chunkVerts.push_back(vId);
+            }
+        }
+    }
+}
+
+void AbstractElementWiseSmoother::colorElementChunks(
+        const Mesh& mesh,
+        std::vector<std::vector<uint>>& colorChunks) const
+{
+    // Greedy first-fit coloring of the chunks : each vertex holds a bit
+    // mask of the colors of the chunks touching it. Consecutive elements
+    // are close to one another on space filling curve ordered meshes, so
+    // chunks touch few other chunks and colors hold many chunks each.
+    // Chunks that don't fit in the first 64 colors are colored in
+    // another round, with fresh masks and the 64 following colors.
+    size_t vertCount = mesh.verts.size();
+    size_t tetChunkCount = (mesh.tets.size() + ELEMENT_CHUNK_SIZE - 1) / ELEMENT_CHUNK_SIZE;
+    size_t priChunkCount = (mesh.pris.size() + ELEMENT_CHUNK_SIZE - 1) / ELEMENT_CHUNK_SIZE;
+    size_t chunkCount = elementChunkCount(mesh);
+
+    uint stamp = 0;
+    std::vector<uint> vertStamps(vertCount, stamp);
+    std::vector<uint> chunkVerts;
+
+    colorChunks.clear();
+    std::vector<uint> pending(chunkCount);
+    std::iota(pending.begin(), pending.end(), 0);
+    while(!pending.empty())
+    {
+        size_t colorBase = colorChunks.size();
+        std::vector<uint64_t> vertMasks(vertCount, 0);
+        std::vector<uint> leftOver;
+
+        for(uint chunk : pending)
+        {
+            ++stamp;
+            chunkVerts.clear();
+            if(chunk < tetChunkCount)
+            {
+                size_t first = chunk * ELEMENT_CHUNK_SIZE;
+                stampChunkVerts(mesh.tets, first, glm::min(first + ELEMENT_CHUNK_SIZE,
+                    mesh.tets.size()), vertStamps, chunkVerts, stamp);
+            }
+            else if(chunk < tetChunkCount + priChunkCount)
+            {
+                size_t first = (chunk - tetChunkCount) * ELEMENT_CHUNK_SIZE;
+                stampChunkVerts(mesh.pris, first, glm::min(first + ELEMENT_CHUNK_SIZE,
+                    mesh.pris.size()), vertStamps, chunkVerts, stamp);
+            }
+            else
+            {
+                size_t first = (chunk - tetChunkCount - priChunkCount) * ELEMENT_CHUNK_SIZE;
+                stampChunkVerts(mesh.hexs, first, glm::min(first + ELEMENT_CHUNK_SIZE,
+                    mesh.hexs.size()), vertStamps, chunkVerts, stamp);
+            }
+
+            uint64_t usedColors = 0;
+            for(uint vId : chunkVerts)
+                usedColors |= vertMasks[vId];
+
+            if(usedColors == ~uint64_t(0))
+            {
+                leftOver.push_back(chunk);
+                continue;
+            }
+
+            uint color = 0;
+            while(usedColors & (uint64_t(1) << color))
+                ++color;
+
+            for(uint vId : chunkVerts)
+                vertMasks[vId] |= uint64_t(1) << color;
+
+            if(colorChunks.size() <= colorBase + color)
+                colorChunks.resize(colorBase + color + 1);
+            colorChunks[colorBase + color].push_back(chunk);
         }
 
-        _vertexAccums[vId]->reinit();
+        pending.swap(leftOver);
     }
 }
@@ -2,8 +2,7 @@
 #define GPUMESH_ABSTRACTELEMENTWISESMOOTHER
 
 #include "../AbstractSmoother.h"
-
-class IVertexAccum;
+#include "VertexAccum.h"
 
 
 class AbstractElementWiseSmoother : public AbstractSmoother
@@ -75,9 +74,26 @@ protected:
             size_t first,
             size_t last) = 0;
 
+    // Element chunks are ranges of ELEMENT_CHUNK_SIZE tets, pris or hexs,
+    // numbered in that order. Chunks of the same color share no vertex :
+    // their positions can be accumulated at once without synchronization.
+    size_t elementChunkCount(const Mesh& mesh) const;
+
+    void smoothElementChunk(
+            Mesh& mesh,
+            const MeshCrew& crew,
+            size_t chunk);
+
+    void colorElementChunks(
+            const Mesh& mesh,
+            std::vector<std::vector<uint>>& colorChunks) const;
+
 protected:
     static const size_t WORKGROUP_SIZE;
 
+    // Number of elements accumulated at once by a thread
+    static const size_t ELEMENT_CHUNK_SIZE;
+
     bool _initialized;
     std::string _modelBoundsShader;
     std::string _samplingShader;
@@ -87,7 +103,7 @@ protected:
     cellar::GlProgram _elemSmoothProgram;
     cellar::GlProgram _vertUpdateProgram;
 
-    IVertexAccum** _vertexAccums;
+    VertexAccums _vertexAccums;
     GLuint _accumSsbo;
 };
 
@@ -1,11 +1,9 @@
 #include "GetmeSmoother.h"
 
-#include <mutex>
-
 #include "VertexAccum.h"
 #include "Boundaries/Constraints/AbstractConstraint.h"
 #include "DataStructures/MeshCrew.h"
-#include "Evaluators/AbstractEvaluator.h"
+#include "Evaluators/Pipeline.h"
 #include "Measurers/AbstractMeasurer.h"
 
 using namespace std;
@@ -117,14 +115,14 @@ void GetmeSmoother::smoothTets(
         if(topos[vi[3]].snapToBoundary->isConstrained())
             vpp[3] = (*topos[vi[3]].snapToBoundary)(vpp[3]);
 
-        double quality = crew.evaluator().tetQuality(crew.sampler(), crew.measurer(), vp, tet);
-        double qualityPrime = crew.evaluator().tetQuality(crew.sampler(), crew.measurer(), vpp, tet);
+        double quality = crew.pipeline().tetQuality(vp, tet);
+        double qualityPrime = crew.pipeline().tetQuality(vpp, tet);
 
         double weight = qualityPrime / (1.0 + quality);
-        _vertexAccums[vi[0]]->addPosition(vpp[0], weight);
-        _vertexAccums[vi[1]]->addPosition(vpp[1], weight);
-        _vertexAccums[vi[2]]->addPosition(vpp[2], weight);
-        _vertexAccums[vi[3]]->addPosition(vpp[3], weight);
+        _vertexAccums.addPosition(vi[0], vpp[0], weight);
+        _vertexAccums.addPosition(vi[1], vpp[1], weight);
+        _vertexAccums.addPosition(vi[2], vpp[2], weight);
+        _vertexAccums.addPosition(vi[3], vpp[3], weight);
     }
 }
 
@@ -229,16 +227,16 @@ void GetmeSmoother::smoothPris(
             vpp[5] = (*topos[vi[5]].snapToBoundary)(vpp[5]);
 
 
-        double quality = crew.evaluator().priQuality(crew.sampler(), crew.measurer(), vp, pri);
-        double qualityPrime = crew.evaluator().priQuality(crew.sampler(), crew.measurer(), vpp, pri);
+        double quality = crew.pipeline().priQuality(vp, pri);
+        double qualityPrime = crew.pipeline().priQuality(vpp, pri);
 
         double weight = qualityPrime / (1.0 + quality);
-        _vertexAccums[vi[0]]->addPosition(vpp[0], weight);
-        _vertexAccums[vi[1]]->addPosition(vpp[1], weight);
-        _vertexAccums[vi[2]]->addPosition(vpp[2], weight);
-        _vertexAccums[vi[3]]->addPosition(vpp[3], weight);
-        _vertexAccums[vi[4]]->addPosition(vpp[4], weight);
-        _vertexAccums[vi[5]]->addPosition(vpp[5], weight);
+        _vertexAccums.addPosition(vi[0], vpp[0], weight);
+        _vertexAccums.addPosition(vi[1], vpp[1], weight);
+        _vertexAccums.addPosition(vi[2], vpp[2], weight);
+        _vertexAccums.addPosition(vi[3], vpp[3], weight);
+        _vertexAccums.addPosition(vi[4], vpp[4], weight);
+        _vertexAccums.addPosition(vi[5], vpp[5], weight);
     }
 }
 
@@ -358,17 +356,17 @@ void GetmeSmoother::smoothHexs(
             vpp[7] = (*topos[vi[7]].snapToBoundary)(vpp[7]);
 
 
-        double quality = crew.evaluator().hexQuality(crew.sampler(), crew.measurer(), vp, hex);
-        double qualityPrime = crew.evaluator().hexQuality(crew.sampler(), crew.measurer(), vpp, hex);
+        double quality = crew.pipeline().hexQuality(vp, hex);
+        double qualityPrime = crew.pipeline().hexQuality(vpp, hex);
 
         double weight = qualityPrime / (1.0 + quality);
-        _vertexAccums[vi[0]]->addPosition(vpp[0], weight);
-        _vertexAccums[vi[1]]->addPosition(vpp[1], weight);
-        _vertexAccums[vi[2]]->addPosition(vpp[2], weight);
-        _vertexAccums[vi[3]]->addPosition(vpp[3], weight);
-        _vertexAccums[vi[4]]->addPosition(vpp[4], weight);
-        _vertexAccums[vi[5]]->addPosition(vpp[5], weight);
-        _vertexAccums[vi[6]]->addPosition(vpp[6], weight);
-        _vertexAccums[vi[7]]->addPosition(vpp[7], weight);
+        _vertexAccums.addPosition(vi[0], vpp[0], weight);
+        _vertexAccums.addPosition(vi[1], vpp[1], weight);
+        _vertexAccums.addPosition(vi[2], vpp[2], weight);
+        _vertexAccums.addPosition(vi[3], vpp[3], weight);
+        _vertexAccums.addPosition(vi[4], vpp[4], weight);
+        _vertexAccums.addPosition(vi[5], vpp[5], weight);
+        _vertexAccums.addPosition(vi[6], vpp[6], weight);
+        _vertexAccums.addPosition(vi[7], vpp[7], weight);
     }
 }
@@ -1,88 +1,35 @@
 #include "VertexAccum.h"
 
 
-IVertexAccum::IVertexAccum()
+VertexAccums::VertexAccums()
 {
 
 }
 
-IVertexAccum::~IVertexAccum()
+VertexAccums::~VertexAccums()
 {
 
 }
 
-
-
-NotThreadSafeVertexAccum::NotThreadSafeVertexAccum() :
-    _posAccum(),
-    _weightAccum(0.0)
-{
-
-}
-
-NotThreadSafeVertexAccum::~NotThreadSafeVertexAccum()
-{
-
-}
-
-void NotThreadSafeVertexAccum::addPosition(const glm::dvec3 pos, double weight)
-{
-    _posAccum += pos * weight;
-    _weightAccum += weight;
-}
-
-bool NotThreadSafeVertexAccum::assignAverage(glm::dvec3& pos) const
-{
-    if(_weightAccum != 0.0)
-    {
-        pos = _posAccum / _weightAccum;
-        return true;
-    }
-    return false;
-}
-
-void NotThreadSafeVertexAccum::reinit()
+void VertexAccums::allocate(size_t vertCount)
 {
-    _posAccum = glm::dvec3();
-    _weightAccum = 0.0;
-}
-
-
-ThreadSafeVertexAccum::ThreadSafeVertexAccum() :
-    _posAccum(),
-    _weightAccum(0.0)
-{
-
+    _posX.assign(vertCount, 0.0);
+    _posY.assign(vertCount, 0.0);
+    _posZ.assign(vertCount, 0.0);
+    _weights.assign(vertCount, 0.0);
 }
 
-ThreadSafeVertexAccum::~ThreadSafeVertexAccum()
+void VertexAccums::deallocate()
 {
+    _posX.clear();
+    _posX.shrink_to_fit();
 
-}
+    _posY.clear();
+    _posY.shrink_to_fit();
 
-void ThreadSafeVertexAccum::addPosition(const glm::dvec3 pos, double weight)
-{
-    _mutex.lock();
-    _posAccum += pos * weight;
-    _weightAccum += weight;
-    _mutex.unlock();
-}
+    _posZ.clear();
+    _posZ.shrink_to_fit();
 
-bool ThreadSafeVertexAccum::assignAverage(glm::dvec3& pos) const
-{
-    _mutex.lock();
-    if(_weightAccum != 0.0)
-    {
-        pos = _posAccum / _weightAccum;
-        _mutex.unlock();
-        return true;
-    }
-    _mutex.unlock();
-    return false;
-}
-
-void ThreadSafeVertexAccum::reinit()
-{
-    _posAccum = glm::dvec3();
-    _weightAccum = 0.0;
+    _weights.clear();
+    _weights.shrink_to_fit();
 }
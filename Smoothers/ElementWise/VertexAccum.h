@@ -1,54 +1,67 @@
 #ifndef GPUMESH_VERTEXACCUM
 #define GPUMESH_VERTEXACCUM
 
-#include <mutex>
+#include <vector>
 
 #include <GLM/glm.hpp>
 
-
-class IVertexAccum
-{
-protected:
-    IVertexAccum();
-
-public:
-    virtual ~IVertexAccum();
-    virtual void addPosition(const glm::dvec3 pos, double weight) = 0;
-    virtual bool assignAverage(glm::dvec3& pos) const = 0;
-    virtual void reinit() = 0;
-};
+#ifndef uint
+typedef unsigned int uint;
+#endif // uint
 
 
-class NotThreadSafeVertexAccum : public IVertexAccum
+// Weighted vertex positions accumulated by element-wise smoothers.
+// Accumulators are stored as contiguous arrays, one per component.
+// They aren't synchronized : concurrent writers must never share a
+// vertex (see AbstractElementWiseSmoother::colorElementChunks()).
+class VertexAccums
 {
 public:
-    NotThreadSafeVertexAccum();
-    virtual ~NotThreadSafeVertexAccum();
+    VertexAccums();
+    ~VertexAccums();
+
+    void allocate(size_t vertCount);
+    void deallocate();
 
-    virtual void addPosition(const glm::dvec3 pos, double weight) override;
-    virtual bool assignAverage(glm::dvec3& pos) const override;
-    virtual void reinit() override;
+    void addPosition(uint vId, const glm::dvec3& pos, double weight);
+    bool assignAverage(uint vId, glm::dvec3& pos) const;
+    void reinit(uint vId);
 
 private:
-    glm::dvec3 _posAccum;
-    double _weightAccum;
+    std::vector<double> _posX;
+    std::vector<double> _posY;
+    std::vector<double> _posZ;
+    std::vector<double> _weights;
 };
 
 
-class ThreadSafeVertexAccum : public IVertexAccum
+
+// IMPLEMENTATION //
+inline void VertexAccums::addPosition(uint vId, const glm::dvec3& pos, double weight)
 {
-public:
-    ThreadSafeVertexAccum();
-    virtual ~ThreadSafeVertexAccum();
+    _posX[vId] += pos.x * weight;
+    _posY[vId] += pos.y * weight;
+    _posZ[vId] += pos.z * weight;
+    _weights[vId] += weight;
+}
 
-    virtual void addPosition(const glm::dvec3 pos, double weight) override;
-    virtual bool assignAverage(glm::dvec3& pos) const override;
-    virtual void reinit() override;
+inline bool VertexAccums::assignAverage(uint vId, glm::dvec3& pos) const
+{
+    double weight = _weights[vId];
+    if(weight != 0.0)
+    {
+        pos = glm::dvec3(_posX[vId], _posY[vId], _posZ[vId]) / weight;
+        return true;
+    }
+    return false;
+}
 
-private:
-    glm::dvec3 _posAccum;
-    double _weightAccum;
-    mutable std::mutex _mutex;
-};
+inline void VertexAccums::reinit(uint vId)
+{
+    _posX[vId] = 0.0;
+    _posY[vId] = 0.0;
+    _posZ[vId] = 0.0;
+    _weights[vId] = 0.0;
+}
 
 #endif // GPUMESH_VERTEXACCUM
@@ -1,10 +1,10 @@
 #include "AbstractVertexWiseSmoother.h"
 
-#include <thread>
-#include <atomic>
-#include <condition_variable>
+#include <cmath>
+#include <memory>
 #include <algorithm>
 #include <numeric>
+#include <sstream>
 #include <fstream>
 #include <chrono>
 
@@ -12,9 +12,13 @@
 #include "DataStructures/GpuMesh.h"
 #include "DataStructures/MeshCrew.h"
 #include "DataStructures/NodeGroups.h"
+#include "DataStructures/QualityCache.h"
+#include "DataStructures/SpinBarrier.h"
+#include "DataStructures/ThreadPool.h"
 #include "Samplers/AbstractSampler.h"
 #include "Measurers/AbstractMeasurer.h"
 #include "Evaluators/AbstractEvaluator.h"
+#include "Evaluators/Pipeline.h"
 #include "Topologists/AbstractTopologist.h"
 
 using namespace std;
@@ -33,6 +37,12 @@ void sendCudaBoundaryVertices(
         const NodeGroups::ParallelGroup& group);
 
 
+const double AbstractVertexWiseSmoother::WORST_FIRST_ELEMENT_RATIO = 0.02;
+const size_t AbstractVertexWiseSmoother::WORST_FIRST_MIN_ELEMENT_COUNT = 64;
+
+const double AbstractVertexWiseSmoother::ACTIVE_DISPLACEMENT_RATIO = 1.0e-3;
+const double AbstractVertexWiseSmoother::ACTIVE_QUALITY_GAIN = 1.0e-4;
+
 AbstractVertexWiseSmoother::AbstractVertexWiseSmoother(
         const std::vector<std::string>& smoothShaders,
         const installCudaFct &installCuda,
@@ -40,9 +50,14 @@ AbstractVertexWiseSmoother::AbstractVertexWiseSmoother(
     _initialized(false),
     _smoothShaders(smoothShaders),
     _installCudaSmoother(installCuda),
-    _launchCudaKernel(launchCudaKernel)
+    _launchCudaKernel(launchCudaKernel),
+    _isActiveSetEnabled(false),
+    _activePassCount(0),
+    _activeCountSum(0)
 {
-
+    using namespace std::placeholders;
+    addImplementation("Worst First", ImplementationFunc(bind(
+        &AbstractVertexWiseSmoother::smoothMeshWorstFirst, this, _1, _2)));
 }
 
 AbstractVertexWiseSmoother::~AbstractVertexWiseSmoother()
@@ -65,13 +80,21 @@ void AbstractVertexWiseSmoother::smoothMeshSerial(
         {
             verboseCuda = false;
             crew.topologist().restructureMesh(mesh, crew, _schedule);
+            mesh.qualityCache().invalidate(mesh);
             verboseCuda = true;
         }
 
+        vector<uint> activeIds;
+        resetActiveSet(mesh, _schedule.activeSetEnabled);
         while(evaluateMeshQualitySerial(mesh, crew))
         {
-            smoothVertices(mesh, crew,
-                mesh.nodeGroups().serialGroup());
+            collectActiveVertices(
+                mesh.nodeGroups().serialGroup(),
+                activeIds);
+
+            relocateVertices(mesh, crew, activeIds);
+
+            commitActiveSet();
         }
 
         if(isTopoEnabled)
@@ -79,6 +102,8 @@ void AbstractVertexWiseSmoother::smoothMeshSerial(
         else
             break;
     }
+
+    resetActiveSet(mesh, false);
 }
 
 void AbstractVertexWiseSmoother::smoothMeshThread(
@@ -89,10 +114,13 @@ void AbstractVertexWiseSmoother::smoothMeshThread(
         _schedule.topoOperationEnabled &&
         crew.topologist().needTopologicalModifications(mesh);
 
-    // TODO : Use a thread pool
-    uint threadCount = thread::hardware_concurrency();    
+    ThreadPool& pool = getThreadPool();
+    uint threadCount = pool.concurrency();
     mesh.nodeGroups().setCpuWorkerCount(threadCount);
 
+    vector<double> busyTimes(threadCount, 0.0);
+    double wallTime = 0.0;
+
     _relocPassId = INITIAL_PASS_ID;
     while(evaluateMeshQualityThread(mesh, crew))
     {
@@ -100,48 +128,42 @@ void AbstractVertexWiseSmoother::smoothMeshThread(
         {
             verboseCuda = false;
             crew.topologist().restructureMesh(mesh, crew, _schedule);
+            mesh.qualityCache().invalidate(mesh);
             verboseCuda = true;
         }
 
+        resetActiveSet(mesh, _schedule.activeSetEnabled);
         while(evaluateMeshQualityThread(mesh, crew))
         {
-            std::mutex mutex;
-            std::condition_variable cv;
-            std::atomic<int> done( 0 );
-            std::atomic<int> step( 0 );
+            size_t groupCount = mesh.nodeGroups().count();
+            unique_ptr<atomic<size_t>[]> nextChunks(new atomic<size_t>[groupCount]);
+            for(size_t g=0; g < groupCount; ++g)
+                nextChunks[g].store(0);
 
-            vector<thread> workers;
-            for(uint t=0; t < threadCount; ++t)
-            {
-                workers.push_back(thread([&, t]() {
-                    size_t groupCount = mesh.nodeGroups().count();
-                    for(size_t g=0; g < groupCount; ++g)
-                    {
-                        smoothVertices(mesh, crew,
-                            mesh.nodeGroups().parallelGroups()[g].allDispatchedNodes[t]);
+            uint teamSize = pool.reserveTeam(threadCount-1);
+            SpinBarrier groupBarrier(teamSize + 1);
 
-                        if(g < groupCount-1)
-                        {
-                            std::unique_lock<std::mutex> lk(mutex);
-                            if(done.fetch_add( 1 ) == threadCount-1)
-                            {
-                                ++step;
-                                done.store( 0 );
-                                cv.notify_all();
-                            }
-                            else
-                            {
-                                cv.wait(lk, [&](){ return step > g; });
-                            }
-                        }
-                    }
-                }));
-            }
+            auto member = [&](size_t t) {
+                for(size_t g=0; g < groupCount; ++g)
+                {
+                    busyTimes[t] += smoothNodeChunks(mesh, crew,
+                        mesh.nodeGroups().parallelGroups()[g].allNodeChunks,
+                        nextChunks[g]);
 
-            for(uint t=0; t < threadCount; ++t)
-            {
-                workers[t].join();
-            }
+                    if(g < groupCount-1)
+                        groupBarrier.wait();
+                }
+            };
+
+            // Members wait on each other between groups :
+            // they must all run at once, the caller being the last one.
+            auto tStart = chrono::high_resolution_clock::now();
+            pool.runTeam(teamSize, member, [&](){ member(teamSize); });
+            pool.releaseTeam(teamSize);
+            auto tEnd = chrono::high_resolution_clock::now();
+            wallTime += chrono::duration<double>(tEnd - tStart).count();
+
+            commitActiveSet();
         }
 
         if(isTopoEnabled)
@@ -149,6 +171,10 @@ void AbstractVertexWiseSmoother::smoothMeshThread(
         else
             break;
     }
+
+    resetActiveSet(mesh, false);
+
+    printWorkerLoads(busyTimes, wallTime);
 }
 
 void AbstractVertexWiseSmoother::smoothMeshGlsl(
@@ -175,10 +201,14 @@ void AbstractVertexWiseSmoother::smoothMeshGlsl(
     //mesh.updateVerticesFromCpu();
 
     size_t groupCount = mesh.nodeGroups().count();
-    uint threadCount = thread::hardware_concurrency();
+    ThreadPool& pool = getThreadPool();
+    uint threadCount = pool.workerCount();
     mesh.nodeGroups().setCpuWorkerCount(threadCount);
     mesh.nodeGroups().setGpuDispatcher(glslDispatcher());
 
+    vector<double> busyTimes(threadCount, 0.0);
+    double wallTime = 0.0;
+
     bool isTopoEnabled =
         _schedule.topoOperationEnabled &&
         crew.topologist().needTopologicalModifications(mesh);
@@ -200,161 +230,133 @@ void AbstractVertexWiseSmoother::smoothMeshGlsl(
 
         while(evaluateMeshQualityGlsl(mesh, crew))
         {
-            std::mutex mutex;
-            std::condition_variable groupCv;
-            std::condition_variable memcpyCv;
-            std::atomic<int> moveDone( 0 );
-            std::atomic<int> stepDone( 0 );
-            std::atomic<bool> memcpyDone( false );
-
-            vector<thread> workers;
-            for(uint t=0; t < threadCount; ++t)
-            {
-                workers.push_back(thread([&, t]() {
-                    for(size_t g=0; g < groupCount; ++g)
-                    {
-                        const NodeGroups::ParallelGroup& group =
+            // Workers and the GPU driver meet twice per group :
+            // once moves are done and once memory copies are done.
+            uint teamSize = pool.reserveTeam(threadCount);
+            SpinBarrier groupBarrier(teamSize + 1);
+
+            unique_ptr<atomic<size_t>[]> nextChunks(new atomic<size_t>[groupCount]);
+            for(size_t g=0; g < groupCount; ++g)
+                nextChunks[g].store(0);
+
+            auto member = [&](size_t t) {
+                for(size_t g=0; g < groupCount; ++g)
+                {
+                    const NodeGroups::ParallelGroup& group =
+                        mesh.nodeGroups().parallelGroups()[g];
+
+                    busyTimes[t] += smoothNodeChunks(mesh, crew,
+                        group.cpuOnlyNodeChunks, nextChunks[g]);
+
+                    groupBarrier.wait();
+                    groupBarrier.wait();
+                }
+            };
+
+            // The caller drives the GPU while pool workers handle CPU nodes
+            auto tStart = chrono::high_resolution_clock::now();
+            pool.runTeam(teamSize, member, [&]() {
+                _vertSmoothProgram.pushProgram();
+                mesh.bindGlShaderStorageBuffers();
+                for(size_t g=0; g < groupCount; ++g)
+                {
+                    const NodeGroups::ParallelGroup& group =
                             mesh.nodeGroups().parallelGroups()[g];
 
-                        smoothVertices(mesh, crew,
-                            group.cpuOnlyDispatchedNodes[t]);
+                    const NodeGroups::GpuDispatch& dispatch = group.gpuDispatch;
+
+
+                    glBindBuffer(GL_SHADER_STORAGE_BUFFER,
+                                 mesh.glBuffer(EMeshBuffer::VERT));
+
+                    if(dispatch.workgroupCount.x *
+                       dispatch.workgroupCount.y *
+                       dispatch.workgroupCount.z > 0)
+                    {
+                        _vertSmoothProgram.setInt("GroupBase", dispatch.gpuBufferBase);
+                        _vertSmoothProgram.setInt("GroupSize", dispatch.gpuBufferSize);
 
-                        if(g < groupCount)
+                        glDispatchComputeGroupSizeARB(
+                            dispatch.workgroupCount.x,
+                            dispatch.workgroupCount.y,
+                            dispatch.workgroupCount.z,
+                            dispatch.workgroupSize.x,
+                            dispatch.workgroupSize.y,
+                            dispatch.workgroupSize.z);
+
+                        glMemoryBarrier(GL_ALL_BARRIER_BITS);
+
+
+                        // Fetch subsurface vertex positions from GPU
+                        size_t subsurfaceSize =
+                                group.subsurfaceRange.end -
+                                group.subsurfaceRange.begin;
+
+                        if(subsurfaceSize > 0)
                         {
-                            std::unique_lock<std::mutex> lk(mutex);
-                            if(moveDone.fetch_add( 1 ) == threadCount)
+                            subsurfaceSize *= sizeof(GpuVert);
+                            size_t subsurfaceBase = group.subsurfaceRange.begin * sizeof(GpuVert);
+                            GpuVert* boundVerts = static_cast<GpuVert*>(
+                                glMapBufferRange(GL_SHADER_STORAGE_BUFFER,
+                                    subsurfaceBase, subsurfaceSize,
+                                    GL_MAP_READ_BIT));
+
+                            for(size_t vId = group.subsurfaceRange.begin, bId=0;
+                                vId < group.subsurfaceRange.end; ++vId, ++bId)
                             {
-                                ++stepDone;
-                                moveDone.store( 0 );
-                                memcpyDone = false;
-                                groupCv.notify_all();
-                            }
-                            else
-                            {
-                                groupCv.wait(lk, [&](){ return stepDone > g; });
+                                MeshVert vert(boundVerts[bId]);
+                                mesh.verts[vId] = vert;
                             }
 
-                            memcpyCv.wait(lk, [&](){ return memcpyDone.load(); });
+                            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
                         }
                     }
-                }));
-            }
-
-            _vertSmoothProgram.pushProgram();
-            mesh.bindGlShaderStorageBuffers();
-            for(size_t g=0; g < groupCount; ++g)
-            {
-                const NodeGroups::ParallelGroup& group =
-                        mesh.nodeGroups().parallelGroups()[g];
-
-                const NodeGroups::GpuDispatch& dispatch = group.gpuDispatch;
 
 
-                glBindBuffer(GL_SHADER_STORAGE_BUFFER,
-                             mesh.glBuffer(EMeshBuffer::VERT));
+                    // Help CPU workers, if any, with their last chunks
+                    smoothNodeChunks(mesh, crew,
+                        group.cpuOnlyNodeChunks, nextChunks[g]);
 
-                if(dispatch.workgroupCount.x *
-                   dispatch.workgroupCount.y *
-                   dispatch.workgroupCount.z > 0)
-                {
-                    _vertSmoothProgram.setInt("GroupBase", dispatch.gpuBufferBase);
-                    _vertSmoothProgram.setInt("GroupSize", dispatch.gpuBufferSize);
-
-                    glDispatchComputeGroupSizeARB(
-                        dispatch.workgroupCount.x,
-                        dispatch.workgroupCount.y,
-                        dispatch.workgroupCount.z,
-                        dispatch.workgroupSize.x,
-                        dispatch.workgroupSize.y,
-                        dispatch.workgroupSize.z);
-
-                    glMemoryBarrier(GL_ALL_BARRIER_BITS);
+                    // Synchronize with CPU workers
+                    groupBarrier.wait();
 
 
-                    // Fetch subsurface vertex positions from GPU
-                    size_t subsurfaceSize =
-                            group.subsurfaceRange.end -
-                            group.subsurfaceRange.begin;
+                    // Send boundary vertex positions to GPU
+                    size_t boundarySize =
+                            group.boundaryRange.end -
+                            group.boundaryRange.begin;
 
-                    if(subsurfaceSize > 0)
+                    if(boundarySize > 0)
                     {
-                        subsurfaceSize *= sizeof(GpuVert);
-                        size_t subsurfaceBase = group.subsurfaceRange.begin * sizeof(GpuVert);
+                        boundarySize *= sizeof(GpuVert);
+                        size_t boundaryBase = group.boundaryRange.begin * sizeof(GpuVert);
                         GpuVert* boundVerts = static_cast<GpuVert*>(
                             glMapBufferRange(GL_SHADER_STORAGE_BUFFER,
-                                subsurfaceBase, subsurfaceSize,
-                                GL_MAP_READ_BIT));
+                                boundaryBase, boundarySize,
+                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
 
-                        for(size_t vId = group.subsurfaceRange.begin, bId=0;
-                            vId < group.subsurfaceRange.end; ++vId, ++bId)
+                        for(size_t vId = group.boundaryRange.begin, bId=0;
+                            vId < group.boundaryRange.end; ++vId, ++bId)
                         {
-                            MeshVert vert(boundVerts[bId]);
-                            mesh.verts[vId] = vert;
+                            GpuVert vert(mesh.verts[vId]);
+                            boundVerts[bId] = vert;
                         }
 
                         glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
                     }
-                }
-
-
-                // Synchronize with CPU workers
-                if(g < groupCount)
-                {
-                    std::unique_lock<std::mutex> lk(mutex);
-                    if(moveDone.fetch_add( 1 ) == threadCount)
-                    {
-                        ++stepDone;
-                        moveDone.store( 0 );
-                        memcpyDone = false;
-                        groupCv.notify_all();
-                    }
-                    else
-                    {
-                        groupCv.wait(lk, [&](){ return stepDone > g; });
-                    }
-                }
 
+                    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+                    glMemoryBarrier(GL_ALL_BARRIER_BITS);
 
-                // Send boundary vertex positions to GPU
-                size_t boundarySize =
-                        group.boundaryRange.end -
-                        group.boundaryRange.begin;
 
-                if(boundarySize > 0)
-                {
-                    boundarySize *= sizeof(GpuVert);
-                    size_t boundaryBase = group.boundaryRange.begin * sizeof(GpuVert);
-                    GpuVert* boundVerts = static_cast<GpuVert*>(
-                        glMapBufferRange(GL_SHADER_STORAGE_BUFFER,
-                            boundaryBase, boundarySize,
-                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
-
-                    for(size_t vId = group.boundaryRange.begin, bId=0;
-                        vId < group.boundaryRange.end; ++vId, ++bId)
-                    {
-                        GpuVert vert(mesh.verts[vId]);
-                        boundVerts[bId] = vert;
-                    }
-
-                    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+                    // Wake-up threads
+                    groupBarrier.wait();
                 }
-
-                glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-                glMemoryBarrier(GL_ALL_BARRIER_BITS);
-
-
-                // Wake-up threads
-                mutex.lock();
-                memcpyDone = true;
-                mutex.unlock();
-                memcpyCv.notify_all();
-            }
-            _vertSmoothProgram.popProgram();
-
-            for(uint t=0; t < threadCount; ++t)
-            {
-                workers[t].join();
-            }
+                _vertSmoothProgram.popProgram();
+            });
+            pool.releaseTeam(teamSize);
+            auto tEnd = chrono::high_resolution_clock::now();
+            wallTime += chrono::duration<double>(tEnd - tStart).count();
         }
 
         if(isTopoEnabled)
@@ -363,6 +365,8 @@ void AbstractVertexWiseSmoother::smoothMeshGlsl(
             break;
     }
 
+    printWorkerLoads(busyTimes, wallTime);
+
 
     // Fetch new vertex positions
     mesh.fetchGlslVertices();
@@ -383,10 +387,14 @@ void AbstractVertexWiseSmoother::smoothMeshCuda(
     crew.setPluginCudaUniforms(mesh);
 
     size_t groupCount = mesh.nodeGroups().count();
-    uint threadCount = thread::hardware_concurrency();
+    ThreadPool& pool = getThreadPool();
+    uint threadCount = pool.workerCount();
     mesh.nodeGroups().setCpuWorkerCount(threadCount);
     mesh.nodeGroups().setGpuDispatcher(cudaDispatcher());
 
+    vector<double> busyTimes(threadCount, 0.0);
+    double wallTime = 0.0;
+
     bool isTopoEnabled =
         _schedule.topoOperationEnabled &&
         crew.topologist().needTopologicalModifications(mesh);
@@ -408,97 +416,68 @@ void AbstractVertexWiseSmoother::smoothMeshCuda(
 
         while(evaluateMeshQualityCuda(mesh, crew))
         {
-            std::mutex mutex;
-            std::condition_variable groupCv;
-            std::condition_variable memcpyCv;
-            std::atomic<int> moveDone( 0 );
-            std::atomic<int> stepDone( 0 );
-            std::atomic<bool> memcpyDone( false );
-
-            vector<thread> workers;
-            for(uint t=0; t < threadCount; ++t)
-            {
-                workers.push_back(thread([&, t]() {
-                    for(size_t g=0; g < groupCount; ++g)
-                    {
-                        const NodeGroups::ParallelGroup& group =
-                            mesh.nodeGroups().parallelGroups()[g];
-
-                        smoothVertices(mesh, crew,
-                            group.cpuOnlyDispatchedNodes[t]);
+            // Workers and the GPU driver meet twice per group :
+            // once moves are done and once memory copies are done.
+            uint teamSize = pool.reserveTeam(threadCount);
+            SpinBarrier groupBarrier(teamSize + 1);
 
-                        if(g < groupCount)
-                        {
-                            std::unique_lock<std::mutex> lk(mutex);
-                            if(moveDone.fetch_add( 1 ) == threadCount)
-                            {
-                                ++stepDone;
-                                moveDone.store( 0 );
-                                memcpyDone = false;
-                                groupCv.notify_all();
-                            }
-                            else
-                            {
-                                groupCv.wait(lk, [&](){ return stepDone > g; });
-                            }
+            unique_ptr<atomic<size_t>[]> nextChunks(new atomic<size_t>[groupCount]);
+            for(size_t g=0; g < groupCount; ++g)
+                nextChunks[g].store(0);
 
-                            memcpyCv.wait(lk, [&](){ return memcpyDone.load(); });
-                        }
-                    }
-                }));
-            }
+            auto member = [&](size_t t) {
+                for(size_t g=0; g < groupCount; ++g)
+                {
+                    const NodeGroups::ParallelGroup& group =
+                        mesh.nodeGroups().parallelGroups()[g];
 
+                    busyTimes[t] += smoothNodeChunks(mesh, crew,
+                        group.cpuOnlyNodeChunks, nextChunks[g]);
 
-            for(size_t g=0; g < groupCount; ++g)
-            {
-                const NodeGroups::ParallelGroup& group =
-                        mesh.nodeGroups().parallelGroups()[g];
+                    groupBarrier.wait();
+                    groupBarrier.wait();
+                }
+            };
 
-                const NodeGroups::GpuDispatch& dispatch = group.gpuDispatch;
+            // The caller drives the GPU while pool workers handle CPU nodes
+            auto tStart = chrono::high_resolution_clock::now();
+            pool.runTeam(teamSize, member, [&]() {
 
-                if(dispatch.workgroupCount.x *
-                   dispatch.workgroupCount.y *
-                   dispatch.workgroupCount.z > 0)
+                for(size_t g=0; g < groupCount; ++g)
                 {
-                    _launchCudaKernel(dispatch);
+                    const NodeGroups::ParallelGroup& group =
+                            mesh.nodeGroups().parallelGroups()[g];
 
-                    // Fetch subsurface vertex positions from GPU
-                    fetchCudaSubsurfaceVertices(mesh.verts, group);
-                }
+                    const NodeGroups::GpuDispatch& dispatch = group.gpuDispatch;
 
-                // Synchronize with CPU workers
-                if(g < groupCount)
-                {
-                    std::unique_lock<std::mutex> lk(mutex);
-                    if(moveDone.fetch_add( 1 ) == threadCount)
+                    if(dispatch.workgroupCount.x *
+                       dispatch.workgroupCount.y *
+                       dispatch.workgroupCount.z > 0)
                     {
-                        ++stepDone;
-                        moveDone.store( 0 );
-                        memcpyDone = false;
-                        groupCv.notify_all();
-                    }
-                    else
-                    {
-                        groupCv.wait(lk, [&](){ return stepDone > g; });
+                        _launchCudaKernel(dispatch);
+
+                        // Fetch subsurface vertex positions from GPU
+                        fetchCudaSubsurfaceVertices(mesh.verts, group);
                     }
-                }
 
-                // Send boundary vertex positions to GPU
-                sendCudaBoundaryVertices(mesh.verts, group);
+                    // Help CPU workers, if any, with their last chunks
+                    smoothNodeChunks(mesh, crew,
+                        group.cpuOnlyNodeChunks, nextChunks[g]);
 
+                    // Synchronize with CPU workers
+                    groupBarrier.wait();
 
-                // Wake-up threads
-                mutex.lock();
-                memcpyDone = true;
-                mutex.unlock();
-                memcpyCv.notify_all();
-            }
+                    // Send boundary vertex positions to GPU
+                    sendCudaBoundaryVertices(mesh.verts, group);
 
 
-            for(uint t=0; t < threadCount; ++t)
-            {
-                workers[t].join();
-            }
+                    // Wake-up threads
+                    groupBarrier.wait();
+                }
+            });
+            pool.releaseTeam(teamSize);
+            auto tEnd = chrono::high_resolution_clock::now();
+            wallTime += chrono::duration<double>(tEnd - tStart).count();
         }
 
         if(isTopoEnabled)
@@ -507,6 +486,8 @@ void AbstractVertexWiseSmoother::smoothMeshCuda(
             break;
     }
 
+    printWorkerLoads(busyTimes, wallTime);
+
 
     // Fetch new vertex positions
     mesh.fetchCudaVertices();
@@ -514,6 +495,393 @@ void AbstractVertexWiseSmoother::smoothMeshCuda(
     crew.clearCudaMemory(mesh);
 }
 
+void AbstractVertexWiseSmoother::smoothMeshWorstFirst(
+        Mesh& mesh,
+        const MeshCrew& crew)
+{
+    bool isTopoEnabled =
+        _schedule.topoOperationEnabled &&
+        crew.topologist().needTopologicalModifications(mesh);
+
+    _relocPassId = INITIAL_PASS_ID;
+    while(evaluateMeshQualitySerial(mesh, crew))
+    {
+        if(isTopoEnabled)
+        {
+            verboseCuda = false;
+            crew.topologist().restructureMesh(mesh, crew, _schedule);
+            mesh.qualityCache().invalidate(mesh);
+            verboseCuda = true;
+        }
+
+        while(evaluateMeshQualitySerial(mesh, crew))
+        {
+            relaxWorstElements(mesh, crew);
+        }
+
+        if(isTopoEnabled)
+            _relocPassId = COMPARE_PASS_ID;
+        else
+            break;
+    }
+}
+
+void AbstractVertexWiseSmoother::relaxWorstElements(
+        Mesh& mesh,
+        const MeshCrew& crew)
+{
+    const vector<MeshTet>& tets = mesh.tets;
+    const vector<MeshPri>& pris = mesh.pris;
+    const vector<MeshHex>& hexs = mesh.hexs;
+    const vector<MeshVert>& verts = mesh.verts;
+    const vector<MeshTopo>& topos = mesh.topos;
+    const QualityCache& cache = mesh.qualityCache();
+
+    const AbstractEvaluator& evaluator = crew.evaluator();
+    const AbstractSampler& sampler = crew.sampler();
+    const AbstractMeasurer& measurer = crew.measurer();
+
+    auto elemQuality = [&](const MeshNeigElem& e) {
+        switch(e.type)
+        {
+        case MeshTet::ELEMENT_TYPE :
+            return evaluator.tetQuality(mesh, sampler, measurer, tets[e.id]);
+        case MeshPri::ELEMENT_TYPE :
+            return evaluator.priQuality(mesh, sampler, measurer, pris[e.id]);
+        default :
+            return evaluator.hexQuality(mesh, sampler, measurer, hexs[e.id]);
+        }
+    };
+
+
+    // Elements are stamped each time they're evaluated again :
+    // queued entries with an older stamp are stale
+    vector<uint> versions[MeshHex::ELEMENT_TYPE + 1];
+    versions[MeshTet::ELEMENT_TYPE].resize(tets.size(), 0);
+    versions[MeshPri::ELEMENT_TYPE].resize(pris.size(), 0);
+    versions[MeshHex::ELEMENT_TYPE].resize(hexs.size(), 0);
+
+    struct QueuedElem
+    {
+        double quality;
+        MeshNeigElem elem;
+        uint version;
+    };
+    vector<QueuedElem> heap;
+    heap.reserve(tets.size() + pris.size() + hexs.size());
+
+    // Qualities were just stored in the cache by the pass' evaluation
+    auto initQuality = [&](const MeshNeigElem& e, double cached) {
+        double q = std::isnan(cached) ? elemQuality(e) : cached;
+        heap.push_back(QueuedElem{q, e, 0});
+    };
+
+    for(size_t e=0; e < tets.size(); ++e)
+        initQuality(MeshNeigElem(e, MeshTet::ELEMENT_TYPE, -1),
+            cache.isEnabled() ? cache.quality(tets[e], e) : NAN);
+    for(size_t e=0; e < pris.size(); ++e)
+        initQuality(MeshNeigElem(e, MeshPri::ELEMENT_TYPE, -1),
+            cache.isEnabled() ? cache.quality(pris[e], e) : NAN);
+    for(size_t e=0; e < hexs.size(); ++e)
+        initQuality(MeshNeigElem(e, MeshHex::ELEMENT_TYPE, -1),
+            cache.isEnabled() ? cache.quality(hexs[e], e) : NAN);
+
+    auto qualityLess = [](const QueuedElem& a, const QueuedElem& b) {
+        return a.quality < b.quality;
+    };
+    auto qualityGreater = [](const QueuedElem& a, const QueuedElem& b) {
+        return a.quality > b.quality;
+    };
+
+    // Only the worst elements are queued to begin with. Others
+    // get queued once a relaxation evaluates them again.
+    size_t relaxBudget = std::max(WORST_FIRST_MIN_ELEMENT_COUNT,
+        size_t(heap.size() * WORST_FIRST_ELEMENT_RATIO));
+    if(heap.size() > relaxBudget)
+    {
+        nth_element(heap.begin(), heap.begin() + relaxBudget,
+                    heap.end(), qualityLess);
+        heap.resize(relaxBudget);
+    }
+    make_heap(heap.begin(), heap.end(), qualityGreater);
+
+
+    vector<uint> vIds;
+    vector<glm::dvec3> startPos;
+    vector<MeshNeigElem> touched;
+    size_t relaxCount = 0;
+    while(!heap.empty() && relaxCount < relaxBudget)
+    {
+        pop_heap(heap.begin(), heap.end(), qualityGreater);
+        QueuedElem worst = heap.back();
+        heap.pop_back();
+
+        // Element was evaluated again since it was queued
+        const MeshNeigElem& elem = worst.elem;
+        if(worst.version != versions[elem.type][elem.id])
+            continue;
+
+        ++relaxCount;
+
+        switch(elem.type)
+        {
+        case MeshTet::ELEMENT_TYPE :
+            vIds.assign(tets[elem.id].v, tets[elem.id].v + MeshTet::VERTEX_COUNT);
+            break;
+        case MeshPri::ELEMENT_TYPE :
+            vIds.assign(pris[elem.id].v, pris[elem.id].v + MeshPri::VERTEX_COUNT);
+            break;
+        default :
+            vIds.assign(hexs[elem.id].v, hexs[elem.id].v + MeshHex::VERTEX_COUNT);
+            break;
+        }
+
+        vIds.erase(remove_if(vIds.begin(), vIds.end(), [&](uint vId) {
+            return topos[vId].snapToBoundary->isFixed();
+        }), vIds.end());
+
+        startPos.resize(vIds.size());
+        for(size_t v=0; v < vIds.size(); ++v)
+            startPos[v] = verts[vIds[v]].p;
+
+        relocateVertices(mesh, crew, vIds);
+
+
+        // Update keys of the elements around moved vertices. Elements
+        // that couldn't be improved stay out of the queue until one
+        // of their neighbors' relaxation moves their vertices.
+        touched.clear();
+        for(size_t v=0; v < vIds.size(); ++v)
+        {
+            if(verts[vIds[v]].p == startPos[v])
+                continue;
+
+            for(const MeshNeigElem& n : mesh.neighborElems(vIds[v]))
+            {
+                if(n.type != MeshPyr::ELEMENT_TYPE)
+                    touched.push_back(n);
+            }
+        }
+
+        sort(touched.begin(), touched.end(),
+            [](const MeshNeigElem& a, const MeshNeigElem& b) {
+                return a.type < b.type || (a.type == b.type && a.id < b.id);
+        });
+        touched.erase(unique(touched.begin(), touched.end(),
+            [](const MeshNeigElem& a, const MeshNeigElem& b) {
+                return a.type == b.type && a.id == b.id;
+        }), touched.end());
+
+        for(const MeshNeigElem& n : touched)
+        {
+            double q = elemQuality(n);
+            uint version = ++versions[n.type][n.id];
+
+            heap.push_back(QueuedElem{q, n, version});
+            push_heap(heap.begin(), heap.end(), qualityGreater);
+        }
+    }
+}
+
+void AbstractVertexWiseSmoother::relocateVertices(
+        Mesh& mesh,
+        const MeshCrew& crew,
+        const std::vector<uint>& vIds)
+{
+    QualityCache& cache = mesh.qualityCache();
+    if(!cache.isEnabled() && !_isActiveSetEnabled)
+    {
+        smoothVertices(mesh, crew, vIds);
+        return;
+    }
+
+    // Smoothers only read the cache before moving their vertex. Next
+    // vertices must see it moved : it's flagged before they're smoothed.
+    const vector<MeshVert>& verts = mesh.verts;
+
+    vector<uint> vId(1);
+    for(uint id : vIds)
+    {
+        glm::dvec3 startPos = verts[id].p;
+
+        if(_isActiveSetEnabled)
+            _patchGains[id] = NAN;
+
+        vId[0] = id;
+        smoothVertices(mesh, crew, vId);
+
+        if(verts[id].p != startPos)
+        {
+            cache.moveVertex(id);
+
+            if(_isActiveSetEnabled)
+                trackActiveVertex(mesh, crew, id, startPos);
+        }
+    }
+}
+
+void AbstractVertexWiseSmoother::resetActiveSet(
+        const Mesh& mesh,
+        bool enabled)
+{
+    // Active set's shrinking is reported once per relocation stage
+    if(_isActiveSetEnabled && _activePassCount > 0)
+    {
+        getLog().postMessage(new Message('I', false,
+            "Mean active vertices per pass: " +
+            to_string(_activeCountSum / _activePassCount) +
+            "/" + to_string(_activeVerts.size()) +
+            " (" + to_string(_activePassCount) + " passes)",
+            "AbstractVertexWiseSmoother"));
+    }
+
+    _isActiveSetEnabled = enabled;
+    _activePassCount = 0;
+    _activeCountSum = 0;
+
+    if(!_isActiveSetEnabled)
+    {
+        _activeVerts.clear();
+        _activeVerts.shrink_to_fit();
+        _nextActiveVerts.reset();
+        _patchGains.clear();
+        _patchGains.shrink_to_fit();
+        return;
+    }
+
+    size_t vertCount = mesh.verts.size();
+    _activeVerts.assign(vertCount, 1);
+    _patchGains.assign(vertCount, NAN);
+    _nextActiveVerts.reset(new atomic<unsigned char>[vertCount]);
+    for(size_t v=0; v < vertCount; ++v)
+        _nextActiveVerts[v].store(0, memory_order_relaxed);
+}
+
+void AbstractVertexWiseSmoother::commitActiveSet()
+{
+    if(!_isActiveSetEnabled)
+        return;
+
+    size_t activeCount = 0;
+    size_t vertCount = _activeVerts.size();
+    for(size_t v=0; v < vertCount; ++v)
+    {
+        _activeVerts[v] = _nextActiveVerts[v].exchange(0, memory_order_relaxed);
+        activeCount += _activeVerts[v];
+    }
+
+    ++_activePassCount;
+    _activeCountSum += activeCount;
+}
+
+void AbstractVertexWiseSmoother::collectActiveVertices(
+        const std::vector<uint>& vIds,
+        std::vector<uint>& activeIds) const
+{
+    if(!_isActiveSetEnabled)
+    {
+        activeIds = vIds;
+        return;
+    }
+
+    activeIds.clear();
+    for(uint vId : vIds)
+    {
+        if(_activeVerts[vId])
+            activeIds.push_back(vId);
+    }
+}
+
+void AbstractVertexWiseSmoother::trackActiveVertex(
+        const Mesh& mesh,
+        const MeshCrew& crew,
+        uint vId,
+        const glm::dvec3& startPos)
+{
+    const vector<MeshVert>& verts = mesh.verts;
+    const MeshNeigRange<MeshNeigVert> neigVerts = mesh.neighborVerts(vId);
+
+    // Local size is the mean length of vertex's edges
+    double edgeLengthSum = 0.0;
+    for(const MeshNeigVert& n : neigVerts)
+        edgeLengthSum += glm::distance(startPos, verts[n.v].p);
+    double localSize = edgeLengthSum / neigVerts.size();
+
+    bool isActive = glm::distance(startPos, verts[vId].p) >
+                        ACTIVE_DISPLACEMENT_RATIO * localSize;
+
+    // Small moves may still matter on sharp quality landscapes
+    if(!isActive)
+    {
+        double gain = _patchGains[vId];
+        if(std::isnan(gain))
+        {
+            const AbstractPipeline& pipeline = crew.pipeline();
+            gain = pipeline.patchQuality(mesh, vId) -
+                   pipeline.patchQuality(mesh, vId, startPos);
+        }
+
+        isActive = gain > ACTIVE_QUALITY_GAIN;
+    }
+
+    if(isActive)
+    {
+        _nextActiveVerts[vId].store(1, memory_order_relaxed);
+        for(const MeshNeigVert& n : neigVerts)
+            _nextActiveVerts[n.v].store(1, memory_order_relaxed);
+    }
+}
+
+void AbstractVertexWiseSmoother::reportPatchQualities(
+        uint vId,
+        double startQuality,
+        double endQuality)
+{
+    if(_isActiveSetEnabled)
+        _patchGains[vId] = endQuality - startQuality;
+}
+
+double AbstractVertexWiseSmoother::smoothNodeChunks(
+        Mesh& mesh,
+        const MeshCrew& crew,
+        const std::vector<std::vector<uint>>& chunks,
+        std::atomic<size_t>& nextChunk)
+{
+    double busyTime = 0.0;
+
+    vector<uint> activeIds;
+    size_t chunkCount = chunks.size();
+    size_t c = nextChunk.fetch_add(1);
+    while(c < chunkCount)
+    {
+        auto tStart = chrono::high_resolution_clock::now();
+        collectActiveVertices(chunks[c], activeIds);
+        relocateVertices(mesh, crew, activeIds);
+        auto tEnd = chrono::high_resolution_clock::now();
+
+        busyTime += chrono::duration<double>(tEnd - tStart).count();
+        c = nextChunk.fetch_add(1);
+    }
+
+    return busyTime;
+}
+
+void AbstractVertexWiseSmoother::printWorkerLoads(
+        const std::vector<double>& busyTimes,
+        double wallTime) const
+{
+    std::stringstream ss;
+    ss << "Worker loads (busy/idle): ";
+    for(size_t t=0; t < busyTimes.size(); ++t)
+    {
+        ss << (t == 0 ? "" : ", ") << t << ": " << busyTimes[t] << "s/"
+           << glm::max(0.0, wallTime - busyTimes[t]) << "s";
+    }
+
+    getLog().postMessage(new Message('I', false,
+        ss.str(), "AbstractVertexWiseSmoother"));
+}
+
 void AbstractVertexWiseSmoother::initializeProgram(
         Mesh& mesh,
         const MeshCrew& crew)
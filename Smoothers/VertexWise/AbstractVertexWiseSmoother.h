@@ -1,6 +1,9 @@
 #ifndef GPUMESH_ABSTRACTVERTEXWISESMOOTHER
 #define GPUMESH_ABSTRACTVERTEXWISESMOOTHER
 
+#include <atomic>
+#include <memory>
+
 #include "../AbstractSmoother.h"
 
 #include "DataStructures/NodeGroups.h"
@@ -36,6 +39,11 @@ public:
             Mesh& mesh,
             const MeshCrew& crew) override;
 
+    // Serial passes that only relax the vertices of the worst elements
+    virtual void smoothMeshWorstFirst(
+            Mesh& mesh,
+            const MeshCrew& crew);
+
 
 protected:
     virtual void initializeProgram(
@@ -55,12 +63,70 @@ protected:
             const MeshCrew& crew,
             const std::vector<uint>& vIds) = 0;
 
+    // Calls smoothVertices() while keeping mesh's quality cache up to
+    // date : vertices are smoothed one at a time and flagged as moved
+    // once their position changed. Until then, their patch is read from
+    // the cache. Vertices that moved are recorded in the active set.
+    void relocateVertices(
+            Mesh& mesh,
+            const MeshCrew& crew,
+            const std::vector<uint>& vIds);
+
+    // Repeatedly relaxes the vertices of the worst element of a min-heap
+    // of element qualities. Only the elements around moved vertices are
+    // evaluated again and pushed back with their new quality.
+    virtual void relaxWorstElements(
+            Mesh& mesh,
+            const MeshCrew& crew);
+
+    // Vertices are only smoothed again in the next pass if they, or one
+    // of their neighbors, moved by more than a fraction of their local
+    // size or improved their patch by more than a small quality gain.
+    // Every vertex is active after a reset.
+    void resetActiveSet(const Mesh& mesh, bool enabled);
+    void commitActiveSet();
+    void collectActiveVertices(
+            const std::vector<uint>& vIds,
+            std::vector<uint>& activeIds) const;
+    void trackActiveVertex(
+            const Mesh& mesh,
+            const MeshCrew& crew,
+            uint vId,
+            const glm::dvec3& startPos);
+
+    // Smoothers that evaluated vertex's patch at its start and final
+    // positions report both qualities so that the active set doesn't
+    // need to evaluate them again.
+    void reportPatchQualities(
+            uint vId,
+            double startQuality,
+            double endQuality);
+
+    // Smooths the chunks claimed through nextChunk until
+    // they are all claimed. Returns time spent smoothing.
+    virtual double smoothNodeChunks(
+            Mesh& mesh,
+            const MeshCrew& crew,
+            const std::vector<std::vector<uint>>& chunks,
+            std::atomic<size_t>& nextChunk);
+
+    virtual void printWorkerLoads(
+            const std::vector<double>& busyTimes,
+            double wallTime) const;
+
     virtual std::string glslLauncher() const;
 
     virtual NodeGroups::GpuDispatcher glslDispatcher() const;
 
     virtual NodeGroups::GpuDispatcher cudaDispatcher() const;
 
+    // Share of the elements relaxed by each worst first pass
+    static const double WORST_FIRST_ELEMENT_RATIO;
+    static const size_t WORST_FIRST_MIN_ELEMENT_COUNT;
+
+    static const double ACTIVE_DISPLACEMENT_RATIO;
+    static const double ACTIVE_QUALITY_GAIN;
+
 
 private:
     bool _initialized;
@@ -72,6 +138,13 @@ private:
 
     installCudaFct _installCudaSmoother;
     launchCudaKernelFct _launchCudaKernel;
+
+    bool _isActiveSetEnabled;
+    std::vector<unsigned char> _activeVerts;
+    std::unique_ptr<std::atomic<unsigned char>[]> _nextActiveVerts;
+    std::vector<double> _patchGains;
+    size_t _activePassCount;
+    size_t _activeCountSum;
 };
 
 #endif // GPUMESH_ABSTRACTVERTEXWISESMOOTHER
@@ -1,10 +1,11 @@
 #include "GradientDescentSmoother.h"
 
+#include <cmath>
 #include <limits>
 
 #include "Boundaries/Constraints/AbstractConstraint.h"
 #include "DataStructures/MeshCrew.h"
-#include "Evaluators/AbstractEvaluator.h"
+#include "Evaluators/Pipeline.h"
 #include "Measurers/AbstractMeasurer.h"
 
 using namespace std;
@@ -91,6 +92,8 @@ void GradientDescentSmoother::smoothVertices(
         // Initialize node shift distance
         double nodeShift = localSize * GDLocalSizeToNodeShift;
         double originalNodeShift = nodeShift;
+        double startQuality = NAN;
+        double endQuality = NAN;
 
         for(int c=0; c < GDSecurityCycleCount; ++c)
         {
@@ -115,19 +118,9 @@ void GradientDescentSmoother::smoothVertices(
                     gradSamples[p] = (*topo.snapToBoundary)(gradSamples[p]);
             }
 
-            glm::dvec3 originalPos = pos;
-            for(uint p=0; p < GRADIENT_SAMPLE_COUNT; ++p)
-            {
-                // Since 'pos' is a reference on vertex's position
-                // modifing its value here should be seen by the evaluator
-                pos = gradSamples[p];
-
-                // Compute patch quality
-                sampleQualities[p] =
-                    crew.evaluator().patchQuality(
-                        mesh, crew.sampler(), crew.measurer(), vId);
-            }
-            pos = originalPos;
+            crew.pipeline().patchQualities(
+                mesh, vId, gradSamples,
+                GRADIENT_SAMPLE_COUNT, sampleQualities);
 
             glm::dvec3 gradQ = glm::dvec3(
                 sampleQualities[1] - sampleQualities[0],
@@ -169,22 +162,18 @@ void GradientDescentSmoother::smoothVertices(
                     propositions[p] = (*topo.snapToBoundary)(propositions[p]);
             }
 
+            double patchQualities[PROPOSITION_COUNT];
+            crew.pipeline().patchQualities(
+                mesh, vId, propositions,
+                PROPOSITION_COUNT, patchQualities);
+
             uint bestProposition = 0;
             double bestQualityMean = -numeric_limits<double>::infinity();
             for(uint p=0; p < PROPOSITION_COUNT; ++p)
             {
-                // Since 'pos' is a reference on vertex's position
-                // modifing its value here should be seen by the evaluator
-                pos = propositions[p];
-
-                // Compute patch quality
-                double patchQuality =
-                    crew.evaluator().patchQuality(
-                        mesh, crew.sampler(), crew.measurer(), vId);
-
-                if(patchQuality > bestQualityMean)
+                if(patchQualities[p] > bestQualityMean)
                 {
-                    bestQualityMean = patchQuality;
+                    bestQualityMean = patchQualities[p];
                     bestProposition = p;
                 }
             }
@@ -193,10 +182,17 @@ void GradientDescentSmoother::smoothVertices(
             // Update vertex's position
             pos = propositions[bestProposition];
 
+            // Proposition 1 is the current position
+            if(c == 0)
+                startQuality = patchQualities[1];
+            endQuality = bestQualityMean;
+
             // Scale node shift and stop if it is too small
             nodeShift *= glm::abs(OFFSETS[bestProposition]);
             if(nodeShift < originalNodeShift / 10.0)
                 break;
         }
+
+        reportPatchQualities(vId, startQuality, endQuality);
     }
 }
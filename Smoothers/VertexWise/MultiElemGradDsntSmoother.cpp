@@ -74,18 +74,20 @@ void MultiElemGradDsntSmoother::smoothMeshCuda(
 bool MultiElemGradDsntSmoother::verifyMeshForGpuLimitations(
             const Mesh& mesh) const
 {
-    for(const MeshTopo& topo : mesh.topos)
+    size_t vertCount = mesh.verts.size();
+    for(size_t vId=0; vId < vertCount; ++vId)
     {
         const uint ELEMENT_SLOT_COUNT =
                 ELEMENT_PER_THREAD_COUNT *
                 ELEMENT_THREAD_COUNT;
 
-        if(topo.neighborElems.size() > ELEMENT_SLOT_COUNT)
+        size_t neigElemCount = mesh.neighborElems(vId).size();
+        if(neigElemCount > ELEMENT_SLOT_COUNT)
         {
             getLog().postMessage(new Message('E', false,
                 "Some nodes have too many neighbor elements. "\
                 "Maximum " + std::to_string(ELEMENT_SLOT_COUNT) +
-                ". A node with " + std::to_string(topo.neighborElems.size()) + " found.",
+                ". A node with " + std::to_string(neigElemCount) + " found.",
                 "MultiElemGradDsntSmoother"));
             return false;
         }
@@ -6,7 +6,7 @@
 
 #include "Boundaries/Constraints/AbstractConstraint.h"
 #include "DataStructures/MeshCrew.h"
-#include "Evaluators/AbstractEvaluator.h"
+#include "Evaluators/Pipeline.h"
 #include "Measurers/AbstractMeasurer.h"
 
 using namespace std;
@@ -120,10 +120,11 @@ void NelderMeadSmoother::smoothVertices(
         double nodeShift = localSize * NMLocalSizeToNodeShift;
 
 
-        glm::dvec3& pos = verts[vId].p;
+        // Trial positions are evaluated without moving the vertex
+        glm::dvec3 pos = verts[vId].p;
         const MeshTopo& topo = topos[vId];
-        glm::dvec4 vo(pos, crew.evaluator().patchQuality(
-            mesh, crew.sampler(), crew.measurer(), vId));
+        glm::dvec4 vo(pos, crew.pipeline().patchQuality(
+            mesh, vId));
 
         glm::dvec4 simplex[MeshTet::VERTEX_COUNT] = {
             glm::dvec4(pos + glm::dvec3(nodeShift, 0, 0), 0),
@@ -137,20 +138,23 @@ void NelderMeadSmoother::smoothVertices(
         bool terminated = false;
         while(!terminated)
         {
-            for(uint p=0; p < MeshTet::VERTEX_COUNT-1; ++p)
+            const uint SPAWN_COUNT = MeshTet::VERTEX_COUNT-1;
+            glm::dvec3 spawns[SPAWN_COUNT];
+            double spawnQualities[SPAWN_COUNT];
+            for(uint p=0; p < SPAWN_COUNT; ++p)
             {
-                // Since 'pos' is a reference on vertex's position
-                // modifing its value here should be seen by the evaluator
-                pos = glm::dvec3(simplex[p]);
+                spawns[p] = glm::dvec3(simplex[p]);
                 if(topo.snapToBoundary->isConstrained())
-                    pos = (*topo.snapToBoundary)(pos);
+                    spawns[p] = (*topo.snapToBoundary)(spawns[p]);
+            }
 
+            // Compute patch qualities
+            crew.pipeline().patchQualities(
+                mesh, vId, spawns,
+                SPAWN_COUNT, spawnQualities);
 
-                // Compute patch quality
-                simplex[p] = glm::dvec4(pos,
-                    crew.evaluator().patchQuality(
-                        mesh, crew.sampler(), crew.measurer(), vId));
-            }
+            for(uint p=0; p < SPAWN_COUNT; ++p)
+                simplex[p] = glm::dvec4(spawns[p], spawnQualities[p]);
 
             // Mini bubble sort
             if(simplex[0].w > simplex[1].w)
@@ -180,8 +184,8 @@ void NelderMeadSmoother::smoothVertices(
                 // Reflect
                 pos = c + NMAlpha*(c - glm::dvec3(simplex[0]));
                 if(topo.snapToBoundary->isConstrained()) pos = (*topo.snapToBoundary)(pos);
-                double fr = f = crew.evaluator().patchQuality(
-                    mesh, crew.sampler(), crew.measurer(), vId);
+                double fr = f = crew.pipeline().patchQuality(
+                    mesh, vId, pos);
 
                 glm::dvec3 xr = pos;
 
@@ -190,8 +194,8 @@ void NelderMeadSmoother::smoothVertices(
                 {
                     pos = c + NMGamma*(pos - c);
                     if(topo.snapToBoundary->isConstrained()) pos = (*topo.snapToBoundary)(pos);
-                    double fe = f = crew.evaluator().patchQuality(
-                        mesh, crew.sampler(), crew.measurer(), vId);
+                    double fe = f = crew.pipeline().patchQuality(
+                        mesh, vId, pos);
 
                     if(fe <= fr)
                     {
@@ -207,16 +211,16 @@ void NelderMeadSmoother::smoothVertices(
                     {
                         pos = c + NMBeta*(xr - c);
                         if(topo.snapToBoundary->isConstrained()) pos = (*topo.snapToBoundary)(pos);
-                        f = crew.evaluator().patchQuality(
-                            mesh, crew.sampler(), crew.measurer(), vId);
+                        f = crew.pipeline().patchQuality(
+                            mesh, vId, pos);
                     }
                     // Inside
                     else
                     {
                         pos = c + NMBeta*(glm::dvec3(simplex[0]) - c);
                         if(topo.snapToBoundary->isConstrained()) pos = (*topo.snapToBoundary)(pos);
-                        f = crew.evaluator().patchQuality(
-                            mesh, crew.sampler(), crew.measurer(), vId);
+                        f = crew.pipeline().patchQuality(
+                            mesh, vId, pos);
                     }
                 }
 
@@ -257,5 +261,8 @@ void NelderMeadSmoother::smoothVertices(
         pos = glm::dvec3(simplex[3]);
         if(topo.snapToBoundary->isConstrained())
             pos = (*topo.snapToBoundary)(pos);
+
+        verts[vId].p = pos;
+        reportPatchQualities(vId, vo.w, simplex[3].w);
     }
 }
@@ -2,7 +2,7 @@
 
 #include "Boundaries/Constraints/AbstractConstraint.h"
 #include "DataStructures/MeshCrew.h"
-#include "Evaluators/AbstractEvaluator.h"
+#include "Evaluators/Pipeline.h"
 #include "Measurers/AbstractMeasurer.h"
 
 using namespace std;
@@ -102,22 +102,18 @@ void QualityLaplaceSmoother::smoothVertices(
 
 
         // Choose best position
+        double patchQualities[PROPOSITION_COUNT];
+        crew.pipeline().patchQualities(
+            mesh, vId, propositions,
+            PROPOSITION_COUNT, patchQualities);
+
         uint bestProposition = 0;
         double bestQualityMean = -numeric_limits<double>::infinity();
         for(uint p=0; p < PROPOSITION_COUNT; ++p)
         {
-            // Since 'pos' is a reference on vertex's position
-            // modifing its value here should be seen by the evaluator
-            pos = propositions[p];
-
-            // Compute patch quality
-            double patchQuality =
-                crew.evaluator().patchQuality(
-                    mesh, crew.sampler(), crew.measurer(), vId);
-
-            if(patchQuality > bestQualityMean)
+            if(patchQualities[p] > bestQualityMean)
             {
-                bestQualityMean = patchQuality;
+                bestQualityMean = patchQualities[p];
                 bestProposition = p;
             }
         }
@@ -125,5 +121,8 @@ void QualityLaplaceSmoother::smoothVertices(
 
         // Update vertex's position
         pos = propositions[bestProposition];
+
+        // Proposition 1 is the current position
+        reportPatchQualities(vId, patchQualities[1], bestQualityMean);
     }
 }
@@ -1,11 +1,13 @@
 #include "SpawnSearchSmoother.h"
 
+#include <cmath>
+
 #include <CellarWorkbench/Misc/Log.h>
 #include <CellarWorkbench/Misc/Distribution.h>
 
 #include "Boundaries/Constraints/AbstractConstraint.h"
 #include "DataStructures/MeshCrew.h"
-#include "Evaluators/AbstractEvaluator.h"
+#include "Evaluators/Pipeline.h"
 #include "Measurers/AbstractMeasurer.h"
 
 using namespace std;
@@ -176,6 +178,8 @@ void SpawnSearchSmoother::smoothVertices(
         // Compute local element size
         double localSize = crew.measurer().computeLocalElementSize(mesh, vId);
         double scale = SSMoveCoeff * localSize;
+        double startQuality = NAN;
+        double endQuality = NAN;
 
 
         for(int iter=0; iter < 2; ++iter)
@@ -196,22 +200,18 @@ void SpawnSearchSmoother::smoothVertices(
 
 
             // Choose best position
+            double patchQualities[SPAWN_COUNT];
+            crew.pipeline().patchQualities(
+                mesh, vId, propositions,
+                SPAWN_COUNT, patchQualities);
+
             uint bestProposition = 0;
             double bestQualityMean = -numeric_limits<double>::infinity();
             for(uint p=0; p < SPAWN_COUNT; ++p)
             {
-                // Since 'pos' is a reference on vertex's position
-                // modifing its value here should be seen by the evaluator
-                pos = propositions[p];
-
-                // Compute patch quality
-                double patchQuality =
-                    crew.evaluator().patchQuality(
-                        mesh, crew.sampler(), crew.measurer(), vId);
-
-                if(patchQuality > bestQualityMean)
+                if(patchQualities[p] > bestQualityMean)
                 {
-                    bestQualityMean = patchQuality;
+                    bestQualityMean = patchQualities[p];
                     bestProposition = p;
                 }
             }
@@ -220,8 +220,15 @@ void SpawnSearchSmoother::smoothVertices(
             // Update vertex's position
             pos = propositions[bestProposition];
 
+            // First offset is null : proposition 0 is the current position
+            if(iter == 0)
+                startQuality = patchQualities[0];
+            endQuality = bestQualityMean;
+
             scale /= 3.0;
         }
+
+        reportPatchQualities(vId, startQuality, endQuality);
     }
 }
 
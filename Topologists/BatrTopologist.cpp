@@ -8,6 +8,7 @@
 
 #include "Boundaries/AbstractBoundary.h"
 #include "DataStructures/Mesh.h"
+#include "DataStructures/NodeGroups.h"
 #include "DataStructures/MeshCrew.h"
 #include "DataStructures/Schedule.h"
 #include "Measurers/AbstractMeasurer.h"
@@ -84,6 +85,9 @@ void BatrTopologist::restructureMesh(
         "Performing BATR topology modifications...",
         "BatrTopologist"));
 
+    // Topological operations edit neighborhoods in place
+    mesh.expandTopology();
+
     std::vector<uint> vertsToVerify(mesh.verts.size());
     std::iota(vertsToVerify.begin(), vertsToVerify.end(), 0);
     std::vector<uint> tetsToVerify(mesh.tets.size());
@@ -123,7 +127,8 @@ void BatrTopologist::restructureMesh(
         lastPassOpCount = passOpCount;
     }
 
-    mesh.compileTopology(false);
+    // Only regroup the nodes touched by the operations
+    mesh.updateTopology();
 }
 
 void BatrTopologist::printOptimisationParameters(
@@ -322,7 +327,9 @@ size_t BatrTopologist::edgeSplitMerge(
                     else if(tet.v[1] == nId) tet.v[1] = vId;
                     else if(tet.v[2] == nId) tet.v[2] = vId;
                     else if(tet.v[3] == nId) tet.v[3] = vId;
+                    markDirty(mesh, tet);
                 }
+                mesh.nodeGroups().markDirty(vId);
 
                 // Remove n from ring verts
                 // Remove ring elems from ring verts
@@ -330,6 +337,7 @@ size_t BatrTopologist::edgeSplitMerge(
                 for(uint rVert : ringVertsCopy)
                 {
                     popOut(topos[rVert].neighborElems, ringElems);
+                    mesh.nodeGroups().markDirty(rVert);
 
                     // Kill vert if it relied entirely on ring elems
                     if(topos[rVert].neighborElems.empty())
@@ -388,11 +396,10 @@ size_t BatrTopologist::edgeSplitMerge(
                 if(ENABLE_VERIFICATION_FRENZY &&
                    !validateMesh(mesh, aliveTets, aliveVerts))
                 {
-                    for(MeshTet& tet : tets)
-                        tet.value = 0.0;
+                    mesh.tetValues.assign(tets.size(), 0.0);
 
                     for(const MeshNeigElem& vElem : topos[vId].neighborElems)
-                        tets[vElem.id].value = 0.5;
+                        mesh.tetValues[vElem.id] = 0.5;
 
                     emergencyExit = true;
                     break;
@@ -525,6 +532,7 @@ size_t BatrTopologist::edgeSplitMerge(
                         deadTets.pop_back();
 
                         aliveTets[vElem] = true;
+                        markDirty(mesh, tets[vElem]);
                         tets[vElem] = vTet;
                     }
 
@@ -541,9 +549,13 @@ size_t BatrTopologist::edgeSplitMerge(
                         deadTets.pop_back();
 
                         aliveTets[nElem] = true;
+                        markDirty(mesh, tets[nElem]);
                         tets[nElem] = nTet;
                     }
 
+                    markDirty(mesh, vTet);
+                    markDirty(mesh, nTet);
+
                     topos[vTet.v[0]].neighborElems.push_back(vElem);
                     topos[vTet.v[1]].neighborElems.push_back(vElem);
                     topos[vTet.v[2]].neighborElems.push_back(vElem);
@@ -589,14 +601,13 @@ size_t BatrTopologist::edgeSplitMerge(
                 if(ENABLE_VERIFICATION_FRENZY &&
                    !validateMesh(mesh, aliveTets, aliveVerts))
                 {
-                    for(MeshTet& tet : tets)
-                        tet.value = 0.0;
+                    mesh.tetValues.assign(tets.size(), 0.0);
 
                     for(const MeshNeigElem& vElem : topos[vId].neighborElems)
-                        tets[vElem.id].value = 0.5;
+                        mesh.tetValues[vElem.id] = 0.5;
 
                     for(const MeshNeigElem& nElem : topos[nId].neighborElems)
-                        tets[nElem.id].value = 1.0;
+                        mesh.tetValues[nElem.id] = 1.0;
 
                     emergencyExit = true;
                     break;
@@ -769,6 +780,10 @@ size_t BatrTopologist::faceSwapping(
                         uint lt = tets.size();
                         tets.push_back(newTet2);
 
+                        markDirty(mesh, newTet0);
+                        markDirty(mesh, newTet1);
+                        markDirty(mesh, newTet2);
+
                         topos[tOp].neighborElems.push_back(toTet(nt));
                         topos[tOp].neighborElems.push_back(toTet(lt));
                         topos[tOp].neighborVerts.push_back(MeshNeigVert(nOp));
@@ -796,14 +811,13 @@ size_t BatrTopologist::faceSwapping(
                         if(ENABLE_VERIFICATION_FRENZY &&
                            !validateMesh(mesh, aliveTets, aliveVerts))
                         {
-                            for(MeshTet& tet : tets)
-                                tet.value = 0.0;
+                            mesh.tetValues.assign(tets.size(), 0.0);
 
                             for(const MeshNeigElem& vElem : topos[tOp].neighborElems)
-                                tets[vElem.id].value = 0.5;
+                                mesh.tetValues[vElem.id] = 0.5;
 
                             for(const MeshNeigElem& nElem : topos[nOp].neighborElems)
-                                tets[nElem.id].value = 1.0;
+                                mesh.tetValues[nElem.id] = 1.0;
 
                             emergencyExit = true;
                             break;
@@ -963,19 +977,16 @@ size_t BatrTopologist::edgeSwapping(
                     popOut(elems, ringElems);
 
 
-                    for(MeshTet& tet : tets)
-                    {
-                        tet.value = 1.0;
-                    }
+                    mesh.tetValues.assign(tets.size(), 1.0);
 
                     for(uint& elem : elems)
                     {
-                        tets[elem].value = 0.0;
+                        mesh.tetValues[elem] = 0.0;
                     }
 
                     for(uint rElem : ringElems)
                     {
-                        tets[rElem].value = 0.5;
+                        mesh.tetValues[rElem] = 0.5;
                     }
 
                     trimTets(mesh, aliveTets);
@@ -1188,10 +1199,13 @@ size_t BatrTopologist::edgeSwapping(
                     {
                         tetId = deadTets.back();
                         deadTets.pop_back();
+                        markDirty(mesh, tets[tetId]);
                         tets[tetId] = tet;
                         aliveTets[tetId] = true;
                     }
 
+                    markDirty(mesh, tet);
+
                     MeshNeigElem elem = toTet(tetId);
                     topos[tet.v[0]].neighborElems.push_back(elem);
                     topos[tet.v[1]].neighborElems.push_back(elem);
@@ -1230,14 +1244,13 @@ size_t BatrTopologist::edgeSwapping(
                 if(ENABLE_VERIFICATION_FRENZY &&
                    !validateMesh(mesh, aliveTets, aliveVerts))
                 {
-                    for(MeshTet& tet : tets)
-                        tet.value = 0.0;
+                    mesh.tetValues.assign(tets.size(), 0.0);
 
                     for(const MeshNeigElem& vElem : vElems)
-                        tets[vElem.id].value = 0.5;
+                        mesh.tetValues[vElem.id] = 0.5;
 
                     for(const MeshNeigElem& nElem : nElems)
-                        tets[nElem.id].value = 1.0;
+                        mesh.tetValues[nElem.id] = 1.0;
 
                     emergencyExit = true;
                     break;
@@ -1355,16 +1368,23 @@ void BatrTopologist::buildVertNeighborhood(Mesh& mesh, uint vId) const
         neigSet.begin(), neigSet.end());
 }
 
+void BatrTopologist::markDirty(Mesh& mesh, const MeshTet& tet) const
+{
+    NodeGroups& nodeGroups = mesh.nodeGroups();
+    nodeGroups.markDirty(tet.v[0]);
+    nodeGroups.markDirty(tet.v[1]);
+    nodeGroups.markDirty(tet.v[2]);
+    nodeGroups.markDirty(tet.v[3]);
+}
+
 void BatrTopologist::findRing(
         const Mesh &mesh,
         uint vId, uint nId,
         std::vector<uint>& ringVerts,
         std::vector<uint>& ringElems) const
 {
-    const MeshTopo& vTopo = mesh.topos[vId];
-    const MeshTopo& nTopo = mesh.topos[nId];
-    const std::vector<MeshNeigElem>& vElems = vTopo.neighborElems;
-    const std::vector<MeshNeigElem>& nElems = nTopo.neighborElems;
+    MeshNeigRange<MeshNeigElem> vElems = mesh.neighborElems(vId);
+    MeshNeigRange<MeshNeigElem> nElems = mesh.neighborElems(nId);
 
     for(const MeshNeigElem& vElem : vElems)
     {
@@ -1396,8 +1416,7 @@ void BatrTopologist::findExclusiveElems(
         const std::vector<uint>& ringElems,
         std::vector<uint>& exElems) const
 {
-    const std::vector<MeshNeigElem>& vElems =
-            mesh.topos[vId].neighborElems;
+    MeshNeigRange<MeshNeigElem> vElems = mesh.neighborElems(vId);
 
     for(const MeshNeigElem& vElem : vElems)
     {
@@ -1451,6 +1470,8 @@ void BatrTopologist::trimVerts(Mesh& mesh, const std::vector<bool>& aliveVerts)
     }
     verts.resize(copyVertId);
     topos.resize(copyVertId);
+
+    mesh.nodeGroups().eraseNodes(aliveVerts);
 }
 
 void BatrTopologist::trimTets(Mesh& mesh, const std::vector<bool>& aliveTets) const
@@ -1462,7 +1483,12 @@ void BatrTopologist::trimTets(Mesh& mesh, const std::vector<bool>& aliveTets) co
     size_t tetCount = tets.size();
     for(size_t tId=0; tId < tetCount; ++tId)
     {
-        if(aliveTets[tId])
+        if(!aliveTets[tId])
+        {
+            // Nodes of removed tets may change type
+            markDirty(mesh, tets[tId]);
+        }
+        else
         {
             if(copyTetId != tId)
             {
@@ -1475,11 +1501,17 @@ void BatrTopologist::trimTets(Mesh& mesh, const std::vector<bool>& aliveTets) co
                 }
 
                 tets[copyTetId] = tet;
+
+                if(tId < mesh.tetValues.size())
+                    mesh.tetValues[copyTetId] = mesh.tetValues[tId];
             }
             ++copyTetId;
         }
     }
     tets.resize(copyTetId);
+
+    if(mesh.tetValues.size() > copyTetId)
+        mesh.tetValues.resize(copyTetId);
 }
 
 bool BatrTopologist::cureBoundaries(
@@ -1822,8 +1854,7 @@ bool BatrTopologist::validateMesh(const Mesh& mesh,
             }
 
             bool refFound = false;
-            const MeshTopo& topo = topos[tet.v[i]];
-            for(const MeshNeigElem& elem : topo.neighborElems)
+            for(const MeshNeigElem& elem : mesh.neighborElems(tet.v[i]))
             {
                 if(elem.id == tId)
                 {
@@ -1851,7 +1882,7 @@ bool BatrTopologist::validateMesh(const Mesh& mesh,
             continue;
 
         std::set<uint> neighSet;
-        for(const MeshNeigElem& aElem : topos[vId].neighborElems)
+        for(const MeshNeigElem& aElem : mesh.neighborElems(vId))
         {
             if(!aliveTets[aElem.id])
             {
@@ -1879,7 +1910,8 @@ bool BatrTopologist::validateMesh(const Mesh& mesh,
         }
 
         std::vector<uint> neighVec(neighSet.begin(), neighSet.end());
-        std::vector<MeshNeigVert> aVerts = topos[vId].neighborVerts;
+        MeshNeigRange<MeshNeigVert> vVerts = mesh.neighborVerts(vId);
+        std::vector<MeshNeigVert> aVerts(vVerts.begin(), vVerts.end());
         std::sort(aVerts.begin(), aVerts.end());
 
         if(neighVec.size() == aVerts.size())
@@ -1905,7 +1937,7 @@ bool BatrTopologist::validateMesh(const Mesh& mesh,
                 }
 
                 bool refFound = false;
-                for(const MeshNeigVert& vert : topos[aVerts[i].v].neighborVerts)
+                for(const MeshNeigVert& vert : mesh.neighborVerts(aVerts[i].v))
                 {
                     if(vert.v == vId)
                     {
@@ -1939,7 +1971,7 @@ bool BatrTopologist::validateMesh(const Mesh& mesh,
         if(!aliveVerts[vId])
             continue;
 
-        for(uint nId : topos[vId].neighborVerts)
+        for(uint nId : mesh.neighborVerts(vId))
         {
             if(nId < vId)
             {
@@ -4,6 +4,7 @@
 #include "AbstractTopologist.h"
 
 class MeshTri;
+class MeshTet;
 class MeshTopo;
 
 
@@ -55,6 +56,9 @@ private:
 
     void buildVertNeighborhood(Mesh& mesh, uint vId) const;
 
+    // Tells mesh's node groups that tet's nodes must be regrouped
+    void markDirty(Mesh& mesh, const MeshTet& tet) const;
+
     void findRing(
             const Mesh& mesh,
             uint vId, uint nId,
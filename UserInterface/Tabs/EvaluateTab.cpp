@@ -57,6 +57,11 @@ EvaluateTab::EvaluateTab(Ui::MainWindow* ui,
             static_cast<void(QComboBox::*)(const QString&)>(&QComboBox::currentIndexChanged),
             this, &EvaluateTab::samplingTypeChanged);
 
+    deployMetricIntegrations();
+    connect(_ui->metricIntegrationMenu,
+            static_cast<void(QComboBox::*)(const QString&)>(&QComboBox::currentIndexChanged),
+            this, &EvaluateTab::metricIntegrationChanged);
+
     _character->displaySamplingMesh(
         _ui->discretizationDisplayCheck->isChecked());
     connect(_ui->discretizationDisplayCheck, &QCheckBox::toggled,
@@ -149,6 +154,11 @@ void EvaluateTab::discretizationDepthChanged(int depth)
     _character->setMetricDiscretizationDepth(depth);
 }
 
+void EvaluateTab::metricIntegrationChanged(const QString& integration)
+{
+    _character->useMetricIntegration(integration.toStdString());
+}
+
 void EvaluateTab::displayDicretizationToggled(bool display)
 {
     _character->displaySamplingMesh(display);
@@ -236,3 +246,15 @@ void EvaluateTab::deploySamplings()
 
     _character->useSampler(samplers.defaultOption);
 }
+
+void EvaluateTab::deployMetricIntegrations()
+{
+    OptionMapDetails integrations = _character->availableMetricIntegrations();
+
+    _ui->metricIntegrationMenu->clear();
+    for(const auto& name : integrations.options)
+        _ui->metricIntegrationMenu->addItem(QString(name.c_str()));
+    _ui->metricIntegrationMenu->setCurrentText(integrations.defaultOption.c_str());
+
+    _character->useMetricIntegration(integrations.defaultOption);
+}
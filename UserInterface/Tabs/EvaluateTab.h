@@ -38,6 +38,7 @@ protected slots:
     virtual void aspectRatioChanged(double ratio);
     virtual void samplingTypeChanged(const QString& type);
     virtual void discretizationDepthChanged(int depth);
+    virtual void metricIntegrationChanged(const QString& integration);
     virtual void displayDicretizationToggled(bool display);
 
     virtual void benchmarkImplementations();
@@ -46,6 +47,7 @@ protected:
     virtual void deployShapeMeasures();
     virtual void deployImplementations();
     virtual void deploySamplings();
+    virtual void deployMetricIntegrations();
 
 private:
     Ui::MainWindow* _ui;
@@ -1,5 +1,6 @@
 #include "MeshTab.h"
 
+#include <QCheckBox>
 #include <QFileDialog>
 
 #include <CellarWorkbench/Image/Image.h>
@@ -39,6 +40,24 @@ MeshTab::MeshTab(Ui::MainWindow* ui,
             static_cast<void(QPushButton::*)(bool)>(&QPushButton::clicked),
             this, &MeshTab::loadMesh);
 
+    deployRenumberings();
+    connect(_ui->renumberingMenu,
+            static_cast<void(QComboBox::*)(const QString&)>(&QComboBox::currentIndexChanged),
+            this, &MeshTab::renumberingChanged);
+
+    connect(_ui->renumberMeshButton,
+            static_cast<void(QPushButton::*)(bool)>(&QPushButton::clicked),
+            this, &MeshTab::renumberMesh);
+
+    deployGroupColorings();
+    connect(_ui->groupColoringMenu,
+            static_cast<void(QComboBox::*)(const QString&)>(&QComboBox::currentIndexChanged),
+            this, &MeshTab::groupColoringChanged);
+
+    groupBalancingToggled(_ui->groupBalancingCheck->isChecked());
+    connect(_ui->groupBalancingCheck, &QCheckBox::toggled,
+            this, &MeshTab::groupBalancingToggled);
+
     connect(_ui->screenshotButton,
             static_cast<void(QPushButton::*)(bool)>(&QPushButton::clicked),
             this, &MeshTab::screenshot);
@@ -93,6 +112,27 @@ void MeshTab::loadMesh()
     }
 }
 
+void MeshTab::renumberingChanged(const QString& renumbering)
+{
+    _character->useRenumbering(renumbering.toStdString());
+}
+
+void MeshTab::renumberMesh()
+{
+    _character->renumberMesh(
+        _ui->renumberingMenu->currentText().toStdString());
+}
+
+void MeshTab::groupColoringChanged(const QString& coloring)
+{
+    _character->useGroupColoring(coloring.toStdString());
+}
+
+void MeshTab::groupBalancingToggled(bool checked)
+{
+    _character->setGroupBalancing(checked);
+}
+
 void MeshTab::screenshot()
 {
     Image screenshotImage;
@@ -128,3 +168,27 @@ void MeshTab::deployModels()
         _ui->geometryModelMenu->addItem(QString(name.c_str()));
     _ui->geometryModelMenu->setCurrentText(models.defaultOption.c_str());
 }
+
+void MeshTab::deployRenumberings()
+{
+    OptionMapDetails renumberings = _character->availableRenumberings();
+
+    _ui->renumberingMenu->clear();
+    for(const auto& name : renumberings.options)
+        _ui->renumberingMenu->addItem(QString(name.c_str()));
+    _ui->renumberingMenu->setCurrentText(renumberings.defaultOption.c_str());
+
+    _character->useRenumbering(renumberings.defaultOption);
+}
+
+void MeshTab::deployGroupColorings()
+{
+    OptionMapDetails colorings = _character->availableGroupColorings();
+
+    _ui->groupColoringMenu->clear();
+    for(const auto& name : colorings.options)
+        _ui->groupColoringMenu->addItem(QString(name.c_str()));
+    _ui->groupColoringMenu->setCurrentText(colorings.defaultOption.c_str());
+
+    _character->useGroupColoring(colorings.defaultOption);
+}
@@ -30,11 +30,17 @@ protected slots:
     virtual void clearMesh();
     virtual void saveMesh();
     virtual void loadMesh();
+    virtual void renumberingChanged(const QString& renumbering);
+    virtual void renumberMesh();
+    virtual void groupColoringChanged(const QString& coloring);
+    virtual void groupBalancingToggled(bool checked);
     virtual void screenshot();
 
 protected:
     virtual void deployTechniques();
     virtual void deployModels();
+    virtual void deployRenumberings();
+    virtual void deployGroupColorings();
 
 private:
     Ui::MainWindow* _ui;
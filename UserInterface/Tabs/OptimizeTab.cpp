@@ -54,6 +54,21 @@ OptimizeTab::OptimizeTab(Ui::MainWindow* ui,
             this, &OptimizeTab::globalPassCount);
 
 
+    sampledConvergenceToggled(_ui->scheduleSampledConvergenceCheck->isChecked());
+    connect(_ui->scheduleSampledConvergenceCheck, &QCheckBox::toggled,
+            this, &OptimizeTab::sampledConvergenceToggled);
+
+    convergenceSampleCount(_ui->scheduleConvergenceSampleCountSpin->value());
+    connect(_ui->scheduleConvergenceSampleCountSpin,
+            static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, &OptimizeTab::convergenceSampleCount);
+
+    convergenceWorstCount(_ui->scheduleConvergenceWorstCountSpin->value());
+    connect(_ui->scheduleConvergenceWorstCountSpin,
+            static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, &OptimizeTab::convergenceWorstCount);
+
+
     // Topology Modifications
     enableTopology(_ui->topoEnabledCheck->isChecked());
     connect(_ui->topoEnabledCheck, &QRadioButton::toggled,
@@ -95,6 +110,15 @@ OptimizeTab::OptimizeTab(Ui::MainWindow* ui,
             static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
             this, &OptimizeTab::cudaThreadCount);
 
+    cpuWorkerCount(_ui->relocCpuWorkerCountSpin->value());
+    connect(_ui->relocCpuWorkerCountSpin,
+            static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            this, &OptimizeTab::cpuWorkerCount);
+
+    cpuWorkerPinningToggled(_ui->relocCpuWorkerPinningCheck->isChecked());
+    connect(_ui->relocCpuWorkerPinningCheck, &QCheckBox::toggled,
+            this, &OptimizeTab::cpuWorkerPinningToggled);
+
     nodeRelocationPassCount(_ui->scheduleRelocPassCountSpin->value());
     connect(_ui->scheduleRelocPassCountSpin,
             static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged),
@@ -146,6 +170,22 @@ void OptimizeTab::globalPassCount(int passCount)
     _schedule.globalPassCount = passCount;
 }
 
+void OptimizeTab::sampledConvergenceToggled(bool checked)
+{
+    _schedule.sampledConvergenceEnabled = checked;
+    _ui->scheduleSampledConvergenceWidget->setEnabled(checked);
+}
+
+void OptimizeTab::convergenceSampleCount(int count)
+{
+    _schedule.convergenceSampleCount = count;
+}
+
+void OptimizeTab::convergenceWorstCount(int count)
+{
+    _schedule.convergenceWorstCount = count;
+}
+
 void OptimizeTab::glslThreadCount(int count)
 {
     _character->setGlslSmootherThreadCount(count);
@@ -156,6 +196,16 @@ void OptimizeTab::cudaThreadCount(int count)
     _character->setCudaSmootherThreadCount(count);
 }
 
+void OptimizeTab::cpuWorkerCount(int count)
+{
+    _character->setCpuWorkerCount(count);
+}
+
+void OptimizeTab::cpuWorkerPinningToggled(bool checked)
+{
+    _character->setCpuWorkerPinning(checked);
+}
+
 void OptimizeTab::nodeRelocationPassCount(int passCount)
 {
     _schedule.relocationPassCount = passCount;
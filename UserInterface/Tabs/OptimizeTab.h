@@ -34,6 +34,9 @@ protected slots:
     virtual void qualMeanThresholdChanged(double threshold);
     virtual void fixedIterationsToggled(bool checked);
     virtual void globalPassCount(int passCount);
+    virtual void sampledConvergenceToggled(bool checked);
+    virtual void convergenceSampleCount(int count);
+    virtual void convergenceWorstCount(int count);
 
     virtual void enableTopology(bool checked);
     virtual void topologyPassCount(int count);
@@ -44,6 +47,8 @@ protected slots:
     virtual void implementationChanged(const QString&);
     virtual void glslThreadCount(int count);
     virtual void cudaThreadCount(int count);
+    virtual void cpuWorkerCount(int count);
+    virtual void cpuWorkerPinningToggled(bool checked);
     virtual void nodeRelocationPassCount(int passCount);
     virtual void smoothMesh();
 